@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include "lambert_cases.h"
+#include "battin1984.h"
+#include "izzo2015.h"
+#include "kepler_propagator.h"
+#include "lambert_solver.h"
+#include <string>
+
+// Accuracy regression harness: every solution is propagated from r1 with its v1 over the time of flight and
+// compared against r2 (and v2). A regime fails when more than its budget of solutions miss r2 by more than
+// POSITION_TOLERANCE relative to |r2|. The zero-revolution regimes run once per LambertBackend, with the same
+// budget; multi-revolution cases go through Izzo directly.
+
+constexpr double POSITION_TOLERANCE = 1e-6;
+
+struct RegimeReport
+{
+    int solutions = 0;
+    int infeasible = 0;
+    int non_finite = 0;
+    int failures = 0;
+    std::vector<double> position_errors;
+    double max_velocity_error = 0;
+};
+
+void checkSolution(RegimeReport &report, const LambertCase &c, const vec3d &v1, const vec3d &v2)
+{
+    ++report.solutions;
+
+    if (!v1.allFinite() || !v2.allFinite())
+    {
+        ++report.non_finite;
+        ++report.failures;
+        return;
+    }
+
+    KeplerState arrival = propagateKepler(MU_SUN, c.r1, v1, c.tof);
+    double position_error = (arrival.r - c.r2).norm() / c.r2.norm();
+    double velocity_error = (arrival.v - v2).norm() / v2.norm();
+
+    if (!(position_error <= POSITION_TOLERANCE))
+        ++report.failures;
+    else
+        report.max_velocity_error = std::max(report.max_velocity_error, velocity_error);
+
+    report.position_errors.push_back(std::isfinite(position_error) ? position_error : 1.);
+}
+
+double percentile(std::vector<double> &values, double p)
+{
+    if (values.empty())
+        return 0;
+
+    size_t k = std::min(values.size() - 1, static_cast<size_t>(p * values.size()));
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+// Prints one row of the table; returns whether the failures stay within budget.
+bool printReport(const std::string &name, RegimeReport &report, double budget)
+{
+    double failure_fraction = report.solutions > 0 ? double(report.failures) / report.solutions : 0.;
+    bool passed = failure_fraction <= budget;
+
+    double median = percentile(report.position_errors, 0.5);
+    double p99 = percentile(report.position_errors, 0.99);
+    double max = percentile(report.position_errors, 1.0);
+
+    std::printf("%-20s %9d %10d %9d %9d %11.3e %11.3e %11.3e %11.3e  %s\n", name.c_str(), report.solutions,
+                report.infeasible, report.non_finite, report.failures, median, p99, max, report.max_velocity_error,
+                passed ? "ok" : "FAIL");
+    return passed;
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? std::atoi(argv[1]) : 2000;
+
+    // Allowed fraction of solutions beyond POSITION_TOLERANCE per regime. Within ~1e-4 rad of 180 deg the
+    // transfer plane is ill-conditioned and about 1% of solutions land 1e-6..3e-6 off.
+    const struct
+    {
+        LambertRegime regime;
+        double budget;
+    } regimes[] = {
+            {REGIME_ELLIPTIC,   0.0},
+            {REGIME_NEAR_PI,    0.02},
+            {REGIME_HYPERBOLIC, 0.0},
+            {REGIME_LONG_TOF,   0.0},
+            {REGIME_MULTI_REV,  0.0},
+    };
+
+    const LambertBackend backends[] = {LAMBERT_BATTIN, LAMBERT_IZZO, LAMBERT_GOODING, LAMBERT_AUTO};
+
+    bool passed = true;
+
+    std::printf("%-20s %9s %10s %9s %9s %11s %11s %11s %11s  %s\n", "regime", "solutions", "infeasible",
+                "nonfinite", "failures", "median", "p99", "max", "max |dv2|", "");
+
+    for (const auto &entry: regimes)
+    {
+        std::vector<LambertCase> cases = makeLambertCases(entry.regime, count);
+
+        if (entry.regime == REGIME_MULTI_REV)
+        {
+            RegimeReport report;
+            for (LambertCase &c: cases)
+            {
+                TransferGeometry g = getTransferGeometry(c.r1, c.r2, c.r1.norm());
+                for (bool shortPath: {true, false})
+                {
+                    Izzo2015Geometry geometry = getIzzoGeometry(MU_SUN, g, c.r1, c.r2, shortPath);
+
+                    vec3d v1, v2;
+                    if (izzo2015(geometry, MU_SUN, c.tof, c.nRev, c.rightBranch, v1, v2))
+                        checkSolution(report, c, v1, v2);
+                    else
+                        ++report.infeasible;
+                }
+            }
+
+            passed = printReport(regimeName(entry.regime), report, entry.budget) && passed;
+            continue;
+        }
+
+        for (LambertBackend backend: backends)
+        {
+            RegimeReport report;
+            for (LambertCase &c: cases)
+            {
+                TransferGeometry g = getTransferGeometry(c.r1, c.r2, c.r1.norm());
+                LambertBranches branches = lambertBranches(backend, MU_SUN, g, c.r1, c.r2, c.tof);
+                checkSolution(report, c, branches.v1_short, branches.v2_short);
+                checkSolution(report, c, branches.v1_long, branches.v2_long);
+            }
+
+            std::string name = std::string(regimeName(entry.regime)) + "/" + lambertBackendName(backend);
+            passed = printReport(name, report, entry.budget) && passed;
+        }
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,339 @@
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include "lambert_cases.h"
+#include "battin1984.h"
+#include "battin1984_batch.h"
+#include "izzo2015.h"
+#include "lambert_sensitivity.h"
+#include "lambert_solver.h"
+#include "porkchop_engine.h"
+
+// Single-solve latency per regime.
+static void BM_Battin1984(benchmark::State &state, LambertRegime regime)
+{
+    std::vector<LambertCase> cases = makeLambertCases(regime, 1024);
+
+    size_t k = 0;
+    for (auto _: state)
+    {
+        LambertCase &c = cases[k++ & 1023];
+        auto [v1, v2] = battin1984(MU_SUN, c.r1, c.r2, c.tof, true, true);
+        benchmark::DoNotOptimize(v1);
+        benchmark::DoNotOptimize(v2);
+    }
+}
+
+BENCHMARK_CAPTURE(BM_Battin1984, elliptic, REGIME_ELLIPTIC);
+BENCHMARK_CAPTURE(BM_Battin1984, near_180deg, REGIME_NEAR_PI);
+BENCHMARK_CAPTURE(BM_Battin1984, hyperbolic, REGIME_HYPERBOLIC);
+BENCHMARK_CAPTURE(BM_Battin1984, long_tof, REGIME_LONG_TOF);
+
+// Both zero-revolution branches per regime, as a porkchop cell solves them, for every backend (range(0)).
+static void BM_LambertBranches(benchmark::State &state, LambertRegime regime)
+{
+    LambertBackend backend = static_cast<LambertBackend>(state.range(0));
+    std::vector<LambertCase> cases = makeLambertCases(regime, 1024);
+
+    size_t k = 0;
+    for (auto _: state)
+    {
+        LambertCase &c = cases[k++ & 1023];
+        TransferGeometry g = getTransferGeometry(c.r1, c.r2, c.r1.norm());
+        LambertBranches branches = lambertBranches(backend, MU_SUN, g, c.r1, c.r2, c.tof);
+        benchmark::DoNotOptimize(branches);
+    }
+
+    state.SetLabel(lambertBackendName(backend));
+}
+
+BENCHMARK_CAPTURE(BM_LambertBranches, elliptic, REGIME_ELLIPTIC)->DenseRange(LAMBERT_BATTIN, LAMBERT_AUTO);
+BENCHMARK_CAPTURE(BM_LambertBranches, near_180deg, REGIME_NEAR_PI)->DenseRange(LAMBERT_BATTIN, LAMBERT_AUTO);
+BENCHMARK_CAPTURE(BM_LambertBranches, hyperbolic, REGIME_HYPERBOLIC)->DenseRange(LAMBERT_BATTIN, LAMBERT_AUTO);
+BENCHMARK_CAPTURE(BM_LambertBranches, long_tof, REGIME_LONG_TOF)->DenseRange(LAMBERT_BATTIN, LAMBERT_AUTO);
+
+// Solve plus analytic velocity partials (range(0) = 1) against the central differences they replace: two more
+// solves for each of the seven inputs r1, r2 and tof (range(0) = 0).
+static void BM_LambertSensitivity(benchmark::State &state, LambertRegime regime)
+{
+    bool analytic = state.range(0) != 0;
+    std::vector<LambertCase> cases = makeLambertCases(regime, 1024);
+
+    size_t k = 0;
+    for (auto _: state)
+    {
+        LambertCase &c = cases[k++ & 1023];
+        vec3d v1, v2;
+        if (analytic)
+        {
+            LambertSensitivity s;
+            benchmark::DoNotOptimize(lambertSolveSensitivity(LAMBERT_BATTIN, MU_SUN, c.r1, c.r2, c.tof, true, v1, v2,
+                                                             s));
+            benchmark::DoNotOptimize(s);
+            continue;
+        }
+
+        std::tie(v1, v2) = battin1984(MU_SUN, c.r1, c.r2, c.tof);
+        for (int input = 0; input < 7; ++input)
+        {
+            vec3d r1 = c.r1, r2 = c.r2;
+            double tof = c.tof;
+            for (double sign: {1., -1.})
+            {
+                double &x = input < 3 ? r1[input] : input < 6 ? r2[input - 3] : tof;
+                double x0 = x;
+                x = x0 * (1. + sign * 1e-6);
+                benchmark::DoNotOptimize(battin1984(MU_SUN, r1, r2, tof));
+                x = x0;
+            }
+        }
+    }
+
+    state.SetLabel(analytic ? "analytic" : "central differences");
+}
+
+BENCHMARK_CAPTURE(BM_LambertSensitivity, elliptic, REGIME_ELLIPTIC)->Arg(0)->Arg(1);
+BENCHMARK_CAPTURE(BM_LambertSensitivity, hyperbolic, REGIME_HYPERBOLIC)->Arg(0)->Arg(1);
+
+static void BM_Izzo2015MultiRev(benchmark::State &state)
+{
+    std::vector<LambertCase> cases = makeLambertCases(REGIME_MULTI_REV, 1024);
+
+    size_t k = 0;
+    for (auto _: state)
+    {
+        LambertCase &c = cases[k++ & 1023];
+        TransferGeometry g = getTransferGeometry(c.r1, c.r2, c.r1.norm());
+        Izzo2015Geometry geometry = getIzzoGeometry(MU_SUN, g, c.r1, c.r2, true);
+
+        vec3d v1, v2;
+        benchmark::DoNotOptimize(izzo2015(geometry, MU_SUN, c.tof, c.nRev, c.rightBranch, v1, v2));
+        benchmark::DoNotOptimize(v1);
+    }
+}
+
+BENCHMARK(BM_Izzo2015MultiRev);
+
+// Every feasible solution up to 3 revolutions, as the multi-rev porkchop mode does per cell.
+static void BM_LambertMultiRevAll(benchmark::State &state)
+{
+    std::vector<LambertCase> cases = makeLambertCases(REGIME_MULTI_REV, 1024);
+
+    size_t k = 0;
+    for (auto _: state)
+    {
+        LambertCase &c = cases[k++ & 1023];
+        benchmark::DoNotOptimize(lambertMultiRev(MU_SUN, c.r1, c.r2, c.tof, 3));
+    }
+}
+
+BENCHMARK(BM_LambertMultiRevAll);
+
+// Fixed-point iteration only: the scalar loop against the lane-parallel batch kernel.
+static void BM_IterateScalar(benchmark::State &state)
+{
+    const int n = 4096;
+    std::vector<LambertCase> cases = makeLambertCases(REGIME_ELLIPTIC, n);
+    std::vector<BattinParameters> params(n);
+    for (int k = 0; k < n; ++k)
+        params[k] = getBattinParameters(MU_SUN, cases[k].r1, cases[k].r2, cases[k].tof, true, k % 2 == 0);
+
+    ContinuedFractionDepth depth = continuedFractionDepth(static_cast<ContinuedFractionMode>(state.range(0)), tol);
+
+    for (auto _: state)
+    {
+        for (int k = 0; k < n; ++k)
+        {
+            double x, y;
+            battinIterate(params[k].l1, params[k].m, params[k].x0, 100, tol, depth, x, y);
+            benchmark::DoNotOptimize(x);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK(BM_IterateScalar)->Arg(CF_ADAPTIVE)->Arg(CF_FIXED_DEPTH);
+
+static void BM_IterateBatch(benchmark::State &state)
+{
+    const int n = 4096;
+    std::vector<LambertCase> cases = makeLambertCases(REGIME_ELLIPTIC, n);
+    std::vector<double> l1(n), m(n), x0(n), x(n), y(n);
+    for (int k = 0; k < n; ++k)
+    {
+        BattinParameters p = getBattinParameters(MU_SUN, cases[k].r1, cases[k].r2, cases[k].tof, true, k % 2 == 0);
+        l1[k] = p.l1;
+        m[k] = p.m;
+        x0[k] = p.x0;
+    }
+
+    for (auto _: state)
+    {
+        battinIterateBatch(l1.data(), m.data(), x0.data(), x.data(), y.data(), n, 100, tol,
+                           static_cast<ContinuedFractionMode>(state.range(0)));
+        benchmark::DoNotOptimize(x.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * n);
+    state.SetLabel(battinBatchInstructionSet());
+}
+
+BENCHMARK(BM_IterateBatch)->Arg(CF_ADAPTIVE)->Arg(CF_FIXED_DEPTH);
+
+// Porkchop sweep through the batch kernel per SolverPrecision on an n x n Earth-Mars grid. Reports the speedup
+// over the float64 sweep and the worst total-Δv deviation from it (m/s) over cells under the cutoff.
+static void BM_PorkchopPrecision(benchmark::State &state, SolverPrecision precision)
+{
+    int n = static_cast<int>(state.range(0));
+    double span_days = 800.;
+
+    SyntheticEphemeris earth = makeSyntheticEphemeris(AU, 0.0, 0.0, 2460000.5, span_days / n, n);
+    SyntheticEphemeris mars = makeSyntheticEphemeris(1.524 * AU, 1.0, 0.03, 2460100.5, span_days / n, n);
+
+    size_t cells = static_cast<size_t>(n) * n;
+    std::vector<double> reference(cells), total_dv(cells);
+
+    auto sweep = [&](std::vector<double> &grid, SolverPrecision p)
+    {
+        MetricOutput output = {METRIC_TOTAL_DV, METRIC_FLOAT64, grid.data()};
+        auto start = std::chrono::steady_clock::now();
+        computePorkchopMetrics(MU_SUN, earth.r.data(), earth.v.data(), mars.r.data(), mars.v.data(),
+                               earth.jd.data(), mars.jd.data(), n, n, 398600.4418, 42828.3, 6778, 3396,
+                               &output, 1, nullptr, p);
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    double reference_seconds = sweep(reference, PRECISION_DOUBLE);
+
+    double seconds = 0;
+    for (auto _: state)
+    {
+        seconds += sweep(total_dv, precision);
+        benchmark::DoNotOptimize(total_dv.data());
+    }
+
+    double max_error = 0;
+    for (size_t k = 0; k < cells; ++k)
+        if (reference[k] < MAX_DV_CUTOFF)
+            max_error = std::max(max_error, std::abs(total_dv[k] - reference[k]));
+
+    state.counters["cells/s"] = benchmark::Counter(static_cast<double>(cells) * state.iterations(),
+                                                   benchmark::Counter::kIsRate);
+    state.counters["speedup"] = reference_seconds * state.iterations() / seconds;
+    state.counters["max_dv_err_mps"] = max_error * 1000.;
+    state.SetLabel(battinBatchInstructionSet());
+}
+
+BENCHMARK_CAPTURE(BM_PorkchopPrecision, double, PRECISION_DOUBLE)->Arg(500)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_PorkchopPrecision, mixed, PRECISION_MIXED)->Arg(500)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_PorkchopPrecision, float, PRECISION_FLOAT)->Arg(500)->Unit(benchmark::kMillisecond);
+
+// Iteration-count histogram per regime, as fractions of solves in log2 bins.
+static void BM_IterationHistogram(benchmark::State &state, LambertRegime regime)
+{
+    const int n = 4096;
+    std::vector<LambertCase> cases = makeLambertCases(regime, n);
+    std::vector<BattinParameters> params(n);
+    for (int k = 0; k < n; ++k)
+        params[k] = getBattinParameters(MU_SUN, cases[k].r1, cases[k].r2, cases[k].tof, true, k % 2 == 0);
+
+    ContinuedFractionDepth depth = continuedFractionDepth(CF_ADAPTIVE, tol);
+
+    const int bins = 6;
+    long long histogram[bins] = {0};
+    long long total = 0;
+
+    for (auto _: state)
+    {
+        for (int k = 0; k < n; ++k)
+        {
+            double x, y;
+            int iterations = battinIterate(params[k].l1, params[k].m, params[k].x0, 100, tol, depth, x, y);
+
+            int bin = 0;
+            while (bin < bins - 1 && iterations > (2 << bin))
+                ++bin;
+            ++histogram[bin];
+            total += iterations;
+        }
+    }
+
+    double solves = static_cast<double>(state.iterations()) * n;
+    state.counters["mean"] = total / solves;
+    state.counters["it01-02"] = histogram[0] / solves;
+    state.counters["it03-04"] = histogram[1] / solves;
+    state.counters["it05-08"] = histogram[2] / solves;
+    state.counters["it09-16"] = histogram[3] / solves;
+    state.counters["it17-32"] = histogram[4] / solves;
+    state.counters["it33+"] = histogram[5] / solves;
+}
+
+BENCHMARK_CAPTURE(BM_IterationHistogram, elliptic, REGIME_ELLIPTIC);
+BENCHMARK_CAPTURE(BM_IterationHistogram, near_180deg, REGIME_NEAR_PI);
+BENCHMARK_CAPTURE(BM_IterationHistogram, hyperbolic, REGIME_HYPERBOLIC);
+BENCHMARK_CAPTURE(BM_IterationHistogram, long_tof, REGIME_LONG_TOF);
+
+// Porkchop throughput in cells/second on an n x n Earth-Mars grid.
+enum PorkchopPath
+{
+    PORKCHOP_SERIAL,
+    PORKCHOP_SIMD,
+    PORKCHOP_PARALLEL,
+    PORKCHOP_PARALLEL_WARM
+};
+
+static void BM_Porkchop(benchmark::State &state, PorkchopPath path)
+{
+    int n = static_cast<int>(state.range(0));
+    double span_days = 800.;
+
+    SyntheticEphemeris earth = makeSyntheticEphemeris(AU, 0.0, 0.0, 2460000.5, span_days / n, n);
+    SyntheticEphemeris mars = makeSyntheticEphemeris(1.524 * AU, 1.0, 0.03, 2460100.5, span_days / n, n);
+
+    size_t cells = static_cast<size_t>(n) * n;
+    std::vector<double> c3(cells), dv1(cells), total_dv(cells);
+
+    PorkchopOptions options;
+    options.warm_start = path == PORKCHOP_PARALLEL_WARM;
+
+    for (auto _: state)
+    {
+        switch (path)
+        {
+            case PORKCHOP_SERIAL:
+                computePorkchopPlot(MU_SUN, earth.r.data(), earth.v.data(), mars.r.data(), mars.v.data(),
+                                    earth.jd.data(), mars.jd.data(), n, n, 398600.4418, 42828.3, 6778, 3396,
+                                    c3.data(), dv1.data(), total_dv.data());
+                break;
+            case PORKCHOP_SIMD:
+                computePorkchopPlot_SIMD(MU_SUN, earth.r.data(), earth.v.data(), mars.r.data(), mars.v.data(),
+                                         earth.jd.data(), mars.jd.data(), n, n, 398600.4418, 42828.3, 6778, 3396,
+                                         c3.data(), dv1.data(), total_dv.data());
+                break;
+            case PORKCHOP_PARALLEL:
+            case PORKCHOP_PARALLEL_WARM:
+                computePorkchopPlotParallel(MU_SUN, earth.r.data(), earth.v.data(), mars.r.data(), mars.v.data(),
+                                            earth.jd.data(), mars.jd.data(), n, n, 398600.4418, 42828.3, 6778, 3396,
+                                            c3.data(), dv1.data(), total_dv.data(), options);
+                break;
+        }
+        benchmark::DoNotOptimize(total_dv.data());
+    }
+
+    state.counters["cells/s"] = benchmark::Counter(static_cast<double>(cells) * state.iterations(),
+                                                   benchmark::Counter::kIsRate);
+}
+
+static void porkchopGridSizes(benchmark::internal::Benchmark *benchmark)
+{
+    for (int n: {100, 250, 500, 1000, 2000, 4000})
+        benchmark->Arg(n);
+    benchmark->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK_CAPTURE(BM_Porkchop, serial, PORKCHOP_SERIAL)->Apply(porkchopGridSizes);
+BENCHMARK_CAPTURE(BM_Porkchop, simd, PORKCHOP_SIMD)->Apply(porkchopGridSizes);
+BENCHMARK_CAPTURE(BM_Porkchop, parallel, PORKCHOP_PARALLEL)->Apply(porkchopGridSizes);
+BENCHMARK_CAPTURE(BM_Porkchop, parallel_warm, PORKCHOP_PARALLEL_WARM)->Apply(porkchopGridSizes);
+
+BENCHMARK_MAIN();
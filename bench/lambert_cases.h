@@ -0,0 +1,147 @@
+#ifndef LAMBERT_BENCH_CASES_H
+#define LAMBERT_BENCH_CASES_H
+
+#include "battin1984.h"
+#include <random>
+#include <string>
+#include <vector>
+
+// Reproducible problem sets shared by lambert_bench and lambert_accuracy.
+
+constexpr double MU_SUN = 132712440018.0;
+constexpr double AU = 149597870.7;
+constexpr double DAY = 86400.0;
+
+enum LambertRegime
+{
+    REGIME_ELLIPTIC,
+    REGIME_NEAR_PI,
+    REGIME_HYPERBOLIC,
+    REGIME_LONG_TOF,
+    REGIME_MULTI_REV
+};
+
+struct LambertCase
+{
+    vec3d r1;
+    vec3d r2;
+    double tof;
+    int nRev;           // multi-rev regime only
+    bool rightBranch;   // multi-rev regime only
+};
+
+inline const char *regimeName(LambertRegime regime)
+{
+    switch (regime)
+    {
+        case REGIME_ELLIPTIC:
+            return "elliptic";
+        case REGIME_NEAR_PI:
+            return "near_180deg";
+        case REGIME_HYPERBOLIC:
+            return "hyperbolic";
+        case REGIME_LONG_TOF:
+            return "long_tof";
+        case REGIME_MULTI_REV:
+            return "multi_rev";
+    }
+    return "unknown";
+}
+
+inline vec3d orbitPosition(double radius, double angle, double inclination)
+{
+    return {radius * std::cos(angle), radius * std::sin(angle) * std::cos(inclination),
+            radius * std::sin(angle) * std::sin(inclination)};
+}
+
+inline std::vector<LambertCase> makeLambertCases(LambertRegime regime, int count, unsigned int seed = 1984)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> unit(0., 1.);
+
+    std::vector<LambertCase> cases;
+    cases.reserve(count);
+
+    for (int k = 0; k < count; ++k)
+    {
+        double r1_norm = AU * (0.7 + 0.6 * unit(rng));
+        double r2_norm = AU * (1.0 + 1.5 * unit(rng));
+        double start = 2. * M_PI * unit(rng);
+        double inclination = 0.05 * unit(rng);
+
+        double angle, tof;
+        int nRev = 0;
+        bool rightBranch = false;
+
+        switch (regime)
+        {
+            case REGIME_ELLIPTIC:
+                angle = M_PI * (0.15 + 0.7 * unit(rng));
+                tof = DAY * (120. + 250. * unit(rng));
+                break;
+            case REGIME_NEAR_PI:
+                angle = M_PI - 1e-2 * std::pow(10., -2. * unit(rng));
+                tof = DAY * (150. + 250. * unit(rng));
+                break;
+            case REGIME_HYPERBOLIC:
+                angle = M_PI * (0.1 + 0.6 * unit(rng));
+                tof = DAY * (5. + 25. * unit(rng));
+                break;
+            case REGIME_LONG_TOF:
+                angle = M_PI * (0.1 + 0.8 * unit(rng));
+                tof = DAY * 365.25 * (2. + 18. * unit(rng));
+                break;
+            case REGIME_MULTI_REV:
+            default:
+                angle = M_PI * (0.1 + 0.8 * unit(rng));
+                nRev = 1 + static_cast<int>(3 * unit(rng));
+                tof = DAY * 365.25 * (1.6 * nRev + 2. + 4. * unit(rng));
+                rightBranch = unit(rng) < 0.5;
+                break;
+        }
+
+        cases.push_back({orbitPosition(r1_norm, start, inclination),
+                         orbitPosition(r2_norm, start + angle, inclination), tof, nRev, rightBranch});
+    }
+
+    return cases;
+}
+
+// Circular, slightly inclined planet orbits sampled daily-or-coarser for porkchop grids.
+struct SyntheticEphemeris
+{
+    std::vector<double> r;
+    std::vector<double> v;
+    std::vector<double> jd;
+};
+
+inline SyntheticEphemeris makeSyntheticEphemeris(double radius, double phase, double inclination,
+                                                 double jd0, double step_days, int count)
+{
+    SyntheticEphemeris eph;
+    eph.r.resize(3 * count);
+    eph.v.resize(3 * count);
+    eph.jd.resize(count);
+
+    double n = std::sqrt(MU_SUN / (radius * radius * radius));
+    double speed = n * radius;
+
+    for (int k = 0; k < count; ++k)
+    {
+        eph.jd[k] = jd0 + step_days * k;
+
+        double angle = phase + n * DAY * step_days * k;
+        vec3d r = orbitPosition(radius, angle, inclination);
+        vec3d v = orbitPosition(speed, angle + M_PI / 2., inclination);
+
+        for (int c = 0; c < 3; ++c)
+        {
+            eph.r[3 * k + c] = r[c];
+            eph.v[3 * k + c] = v[c];
+        }
+    }
+
+    return eph;
+}
+
+#endif //LAMBERT_BENCH_CASES_H
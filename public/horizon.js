@@ -1,6 +1,16 @@
 import { CelestialDataParser } from "./porkchop/celestialDataParser.js";
 import { showAlertInElement } from "./error_message.js";
 import { visualizePorkchopPlot } from "./porkchop/visualize_porkchop.js";
+import { PorkchopResultCache, unpackPorkchopGrid } from "./porkchop/resultCache.js";
+
+// Bump when solver output changes, so stored results are not reused.
+const RESULT_CACHE_VERSION = 2;
+const resultCache = new PorkchopResultCache();
+
+// Isolines the engine traces after a solve: time of flight every 50 days, and total Δv at these multiples of the
+// best transfer's.
+const TOF_ISOCHRONES = Array.from({ length: 18 }, (_, k) => 50 * (k + 1));
+const DV_CONTOUR_FACTORS = [1.1, 1.25, 1.5, 2];
 
 function getActualStepSize(elementId) {
     const element = document.getElementById(elementId);
@@ -12,6 +22,83 @@ function getActualStepSize(elementId) {
     return element.value;
 }
 
+// Porkchop computation in flight; a new request or the cancel button aborts it.
+let activeComputation = null;
+
+export function cancelPorkchopComputation() {
+    if (activeComputation) {
+        activeComputation.abort();
+        activeComputation = null;
+    }
+}
+
+function setCancelButtonVisible(visible) {
+    const cancelButton = document.getElementById('cancelButton');
+    if (cancelButton) cancelButton.classList.toggle('d-none', !visible);
+}
+
+// "5d", "12h" or "30m", as the step size selects and Horizons accept them, in days.
+function stepSizeInDays(stepSize) {
+    const match = /^(\d+)([dhm])$/.exec(stepSize);
+    if (!match) return null;
+
+    const value = parseInt(match[1], 10);
+    return { d: value, h: value / 24, m: value / 1440 }[match[2]];
+}
+
+function dateToJulianDate(date) {
+    return date.getTime() / 86400000 + 2440587.5;
+}
+
+// Grids above this many cells are sent to the server's native solver when it runs one; devices reporting
+// little memory hand off earlier.
+const SERVER_CELL_THRESHOLD = 4e6;
+const LOW_MEMORY_SERVER_CELL_THRESHOLD = 1e6;
+
+function gridCellCount(request) {
+    const count = (start, end, step) => {
+        const stepDays = stepSizeInDays(step);
+        if (!stepDays) return 0;
+        return Math.floor((dateToJulianDate(new Date(end)) - dateToJulianDate(new Date(start))) / stepDays + 1e-6) + 1;
+    };
+
+    return count(request.departureStartDate, request.departureEndDate, request.departureStepSize) *
+        count(request.arrivalStartDate, request.arrivalEndDate, request.arrivalStepSize);
+}
+
+function prefersServerCompute(request) {
+    const cells = gridCellCount(request);
+    const lowMemory = navigator.deviceMemory !== undefined && navigator.deviceMemory <= 2;
+    return cells > SERVER_CELL_THRESHOLD || (lowMemory && cells > LOW_MEMORY_SERVER_CELL_THRESHOLD);
+}
+
+// The whole grid from the server's native solver, or null when the server does not offer it.
+async function fetchServerPorkchop(request, params) {
+    const response = await fetch(`/api/horizons/porkchop?` +
+        `depBody=${encodeURIComponent(request.departureBodyID)}` +
+        `&arrBody=${encodeURIComponent(request.arrivalBodyID)}` +
+        `&depStart=${request.departureStartDate}` +
+        `&depEnd=${request.departureEndDate}` +
+        `&arrStart=${request.arrivalStartDate}` +
+        `&arrEnd=${request.arrivalEndDate}` +
+        `&depStep=${request.departureStepSize}` +
+        `&arrStep=${request.arrivalStepSize}` +
+        `&mu=${params.mu}` +
+        `&depMu=${params.departurePlanetMu}` +
+        `&arrMu=${params.arrivalPlanetMu}` +
+        `&depRadius=${params.departureOrbitRadius}` +
+        `&arrRadius=${params.arrivalOrbitRadius}` +
+        (params.precision ? `&precision=${params.precision}` : '') +
+        (params.solver ? `&solver=${params.solver}` : '')
+    );
+
+    if (!response.ok) {
+        return null;
+    }
+
+    return unpackPorkchopGrid(await response.arrayBuffer());
+}
+
 export async function fetchHorizonsData() {
     const departureBodyID = document.getElementById('departureBodyID').value;
     const arrivalBodyID = document.getElementById('arrivalBodyID').value;
@@ -64,76 +151,235 @@ export async function fetchHorizonsData() {
     }
 
     const wasmModule = window.wasmModule;
-    let dataParser;
+    const dataParser = new CelestialDataParser(wasmModule);
+
+    const request = {
+        centralBody: document.getElementById('centralBodySelect')?.value,
+        departureBodyID, arrivalBodyID,
+        departureStartDate, departureEndDate, departureStepSize,
+        arrivalStartDate, arrivalEndDate, arrivalStepSize
+    };
+
+    const params = {
+        mu: mu,
+        departurePlanetMu: departurePlanetMu,
+        arrivalPlanetMu: arrivalPlanetMu,
+        departureOrbitRadius: departureOrbitRadius,
+        arrivalOrbitRadius: arrivalOrbitRadius
+    };
 
     try {
+        // Modules without the zero-copy buffers cannot hand back flat grids, so they bypass the result cache.
+        if (!dataParser.supportsBinaryEphemeris()) {
+            const { departureParsedData, arrivalParsedData } = await loadEphemeris(dataParser, request, mu);
+            if (!departureParsedData) return;
+
+            const results = dataParser.computePorkchopPlot(departureParsedData, arrivalParsedData, params);
+            if (!results) {
+                throw new Error("Failed to compute porkchop plot");
+            }
+
+            document.getElementById('result').textContent += "\nPorkchop plot calculation complete";
+            visualizePorkchopPlot(results, departureParsedData, arrivalParsedData,
+                { optima: dataParser.findPorkchopOptima(params) });
+            return;
+        }
+
+        const key = await PorkchopResultCache.key({ version: RESULT_CACHE_VERSION, request, params });
+
+        // an identical request already running is joined, anything else replaces it
+        if (!resultCache.isPending(key)) {
+            cancelPorkchopComputation();
+        }
+
+        const entry = await resultCache.getOrCompute(key, async () => {
+            if (prefersServerCompute(request)) {
+                document.getElementById('result').textContent += "\nComputing porkchop plot on the server...";
+                const serverEntry = await fetchServerPorkchop(request, params).catch(() => null);
+                if (serverEntry) return serverEntry;
+            }
+
+            const { departureParsedData, arrivalParsedData, preloaded } = await loadEphemeris(dataParser, request, mu);
+            if (!departureParsedData) return null;
+
+            const results = await solvePorkchop(dataParser, departureParsedData, arrivalParsedData, params, preloaded);
+            if (!results) return null;
+
+            // the search and the contours need the module's buffers, so they run now; both stay with the in-memory
+            // entry only, and grids from storage or the server are summarized by their grid minimum and contoured
+            // by the plot
+            const entry = dataParser.snapshotResults();
+            entry.optima = dataParser.findPorkchopOptima(params);
+            const bestDv = entry.optima.length > 0 ? entry.optima[0].totalDv : null;
+            entry.contours = dataParser.porkchopContours({
+                levels: bestDv !== null ? DV_CONTOUR_FACTORS.map(factor => factor * bestDv) : [],
+                tofLevels: TOF_ISOCHRONES
+            });
+            return entry;
+        });
+
+        if (!entry) {
+            document.getElementById('result').textContent += "\nPorkchop plot calculation cancelled";
+            return;
+        }
+
+        const departureCount = entry.departureJd.length;
+        const arrivalCount = entry.arrivalJd.length;
+        const results = dataParser.processResultViews(entry.c3, entry.dv1, entry.totalDv, departureCount, arrivalCount);
+
+        document.getElementById('result').textContent += "\nPorkchop plot calculation complete";
+
+        visualizePorkchopPlot(results,
+            Array.from(entry.departureJd, jd => ({ date: { jd } })),
+            Array.from(entry.arrivalJd, jd => ({ date: { jd } })),
+            { optima: entry.optima, contours: entry.contours });
+    } catch (error) {
+        document.getElementById('result').textContent += "\nError: " + error.message;
+        console.error("Error computing porkchop plot:", error);
+    }
+}
+
+// Departure and arrival states for the request: from the module's analytic ephemeris for planets around the
+// Sun, otherwise from Horizons (packed binary when the module takes it, JSON for older modules). With
+// preloaded the states already sit in the module buffers.
+async function loadEphemeris(dataParser, request, mu) {
+    const departureStepDays = stepSizeInDays(request.departureStepSize);
+    const arrivalStepDays = stepSizeInDays(request.arrivalStepSize);
+
+    let departureParsedData;
+    let arrivalParsedData;
+    let preloaded = false;
+
+    const ephemeris = request.centralBody === 'Sun' && departureStepDays && arrivalStepDays
+        ? dataParser.loadBodyEphemeris(
+            mu,
+            {
+                body: parseInt(request.departureBodyID, 10),
+                startJd: dateToJulianDate(new Date(request.departureStartDate)),
+                endJd: dateToJulianDate(new Date(request.departureEndDate)),
+                stepDays: departureStepDays
+            },
+            {
+                body: parseInt(request.arrivalBodyID, 10),
+                startJd: dateToJulianDate(new Date(request.arrivalStartDate)),
+                endJd: dateToJulianDate(new Date(request.arrivalEndDate)),
+                stepDays: arrivalStepDays
+            })
+        : null;
+
+    if (ephemeris) {
+        departureParsedData = ephemeris.departure;
+        arrivalParsedData = ephemeris.arrival;
+        preloaded = true;
+    } else if (dataParser.supportsBinaryEphemeris()) {
+        const fetchEphemeris = async (body, start, end, step) => {
+            const response = await fetch(`/api/horizons/ephemeris?` +
+                `body=${encodeURIComponent(body)}&start=${start}&end=${end}&step=${step}`);
+
+            if (!response.ok) {
+                throw new Error(`${response.status}`);
+            }
+
+            return response.arrayBuffer();
+        };
+
+        const [departureBuffer, arrivalBuffer] = await Promise.all([
+            fetchEphemeris(request.departureBodyID, request.departureStartDate, request.departureEndDate,
+                request.departureStepSize),
+            fetchEphemeris(request.arrivalBodyID, request.arrivalStartDate, request.arrivalEndDate,
+                request.arrivalStepSize)
+        ]);
+
+        const loaded = dataParser.loadBinaryEphemeris(departureBuffer, arrivalBuffer);
+        if (loaded) {
+            departureParsedData = loaded.departure;
+            arrivalParsedData = loaded.arrival;
+            preloaded = true;
+        }
+    } else {
         const response = await fetch(`/api/horizons/combined?` +
-            `depBody=${departureBodyID}` +
-            `&arrBody=${arrivalBodyID}` +
-            `&depStart=${departureStartDate}` +
-            `&depEnd=${departureEndDate}` +
-            `&arrStart=${arrivalStartDate}` +
-            `&arrEnd=${arrivalEndDate}` +
-            `&depStep=${departureStepSize}` +
-            `&arrStep=${arrivalStepSize}`
+            `depBody=${request.departureBodyID}` +
+            `&arrBody=${request.arrivalBodyID}` +
+            `&depStart=${request.departureStartDate}` +
+            `&depEnd=${request.departureEndDate}` +
+            `&arrStart=${request.arrivalStartDate}` +
+            `&arrEnd=${request.arrivalEndDate}` +
+            `&depStep=${request.departureStepSize}` +
+            `&arrStep=${request.arrivalStepSize}`
         );
-        
+
         if (!response.ok) {
             throw new Error(`${response.status}`);
         }
-        
+
         const result = await response.json();
-        
-        const departureParsedData = result.departure.data;
-        const arrivalParsedData = result.arrival.data;
-        
-        if (!departureParsedData || departureParsedData.length === 0) {
-            document.getElementById('result').textContent = "No departure body data.";
-            return;
-        }
-        
-        if (!arrivalParsedData || arrivalParsedData.length === 0) {
-            document.getElementById('result').textContent = "No arrival body data.";
-            return;
-        }
 
-        document.getElementById('result').textContent = `Departure body data: ${departureParsedData.length}, Arrival body data: ${arrivalParsedData.length}`;
-        //---------------------------------------------------------------------------------------------
-        dataParser = new CelestialDataParser(wasmModule);
+        departureParsedData = result.departure.data;
+        arrivalParsedData = result.arrival.data;
+    }
+
+    if (!departureParsedData || departureParsedData.length === 0) {
+        document.getElementById('result').textContent = "No departure body data.";
+        return {};
+    }
 
-        const params = {
-            mu: mu,
-            departurePlanetMu: departurePlanetMu,
-            arrivalPlanetMu: arrivalPlanetMu,
-            departureOrbitRadius: departureOrbitRadius,
-            arrivalOrbitRadius: arrivalOrbitRadius
-        };
+    if (!arrivalParsedData || arrivalParsedData.length === 0) {
+        document.getElementById('result').textContent = "No arrival body data.";
+        return {};
+    }
+
+    document.getElementById('result').textContent = `Departure body data: ${departureParsedData.length}, Arrival body data: ${arrivalParsedData.length}`;
+    document.getElementById('result').textContent += "\nComputing porkchop plot...";
+
+    return { departureParsedData, arrivalParsedData, preloaded };
+}
+
+// Runs the solve, progressively with partial redraws and cancellation when the module supports it. Resolves to
+// the results, or null when cancelled.
+async function solvePorkchop(dataParser, departureParsedData, arrivalParsedData, params, preloaded) {
+    let results;
 
-        document.getElementById('result').textContent += "\nComputing porkchop plot...";
+    if (dataParser.supportsProgressive()) {
+        const computation = new AbortController();
+        activeComputation = computation;
+        setCancelButtonVisible(true);
 
-        //----------------------------------------------------------------------------------------------
         try {
-            const results = dataParser.computePorkchopPlot(
+            results = await dataParser.computePorkchopPlotProgressive(
                 departureParsedData,
                 arrivalParsedData,
-                params
+                params,
+                {
+                    preloaded,
+                    signal: computation.signal,
+                    onProgress: ({ rowsCompleted, departureCount, results: partialResults }) => {
+                        const badge = document.getElementById('status-badge');
+                        if (badge) {
+                            badge.className = 'badge bg-warning';
+                            badge.textContent = `Computing ${Math.round(100 * rowsCompleted / departureCount)}%`;
+                        }
+                        visualizePorkchopPlot(partialResults, departureParsedData, arrivalParsedData,
+                            { partial: true });
+                    }
+                }
             );
-
-            if (!results) {
-                throw new Error("Failed to compute porkchop plot");
+        } finally {
+            if (activeComputation === computation) {
+                activeComputation = null;
+                setCancelButtonVisible(false);
             }
+        }
 
-            document.getElementById('result').textContent += "\nPorkchop plot calculation complete";
-
-            visualizePorkchopPlot(results, departureParsedData, arrivalParsedData);
-
-        } catch (wasmError) {
-            console.error("WASM function error:", wasmError);
-            document.getElementById('result').textContent += "\nWASM function error: " + wasmError.message;
+        if (computation.signal.aborted) {
+            return null;
         }
+    } else {
+        results = dataParser.computePorkchopPlot(departureParsedData, arrivalParsedData, params, { preloaded });
+    }
 
-    } catch (error) {
-        document.getElementById('result').textContent = "Server error: " + error.message;
-        console.error("Error fetching Horizons data:", error);
+    if (!results) {
+        throw new Error("Failed to compute porkchop plot");
     }
+
+    return results;
 }
@@ -1,3 +1,18 @@
+// Metric names in the order of PorkchopMetric in src/cpp/porkchop_metrics.h, and the MetricFormat codes.
+export const PORKCHOP_METRICS = ['c3', 'dv1', 'dv2', 'totalDv', 'vinfArrival', 'tof', 'dla'];
+const METRIC_FORMATS = { float64: 0, float32: 1, uint16: 2 };
+const QUANTIZED_MAX = 65533;
+const QUANTIZED_PRUNED = 65534;
+
+// SolverPrecision codes of src/cpp/battin1984_batch.h.
+const SOLVER_PRECISIONS = { double: 0, mixed: 1, float: 2 };
+
+// LambertBackend codes of src/cpp/battin1984.h.
+const LAMBERT_BACKENDS = { battin: 0, izzo: 1, gooding: 2, auto: 3 };
+
+// Value of cells a pruned sweep (params.pruneAboveDv) rejected without solving them fully.
+export const PRUNED_MARKER = -2;
+
 export class CelestialDataParser {
     constructor(wasmModule) {
         if (!wasmModule || typeof wasmModule.computePorkchopPlot !== 'function') {
@@ -76,7 +91,435 @@ export class CelestialDataParser {
         };
     }
 
-    computePorkchopPlot(departureData, arrivalData, params) {
+    _normalize(parsedData) {
+        return Array.isArray(parsedData) ? parsedData : [parsedData];
+    }
+
+    // Writes dates, positions and velocities straight into the module-owned heap views.
+    _fillEphemerisViews(points, positions, velocities, dates) {
+        for (let k = 0; k < points.length; k++) {
+            const point = points[k];
+
+            dates[k] = point.date.jd;
+
+            positions[3 * k] = point.position.x;
+            positions[3 * k + 1] = point.position.y;
+            positions[3 * k + 2] = point.position.z;
+
+            velocities[3 * k] = point.velocity.vx;
+            velocities[3 * k + 1] = point.velocity.vy;
+            velocities[3 * k + 2] = point.velocity.vz;
+        }
+    }
+
+    _loadEphemeris(departurePoints, arrivalPoints) {
+        const wasm = this.wasm;
+
+        // views are only valid until the next preparePorkchopBuffers call
+        wasm.preparePorkchopBuffers(departurePoints.length, arrivalPoints.length);
+
+        this._fillEphemerisViews(departurePoints, wasm.departurePositionsView(),
+            wasm.departureVelocitiesView(), wasm.departureDatesView());
+        this._fillEphemerisViews(arrivalPoints, wasm.arrivalPositionsView(),
+            wasm.arrivalVelocitiesView(), wasm.arrivalDatesView());
+    }
+
+    _readEphemerisViews(positions, velocities, dates) {
+        const points = new Array(dates.length);
+
+        for (let k = 0; k < dates.length; k++) {
+            points[k] = {
+                date: { jd: dates[k] },
+                position: { x: positions[3 * k], y: positions[3 * k + 1], z: positions[3 * k + 2] },
+                velocity: { vx: velocities[3 * k], vy: velocities[3 * k + 1], vz: velocities[3 * k + 2] }
+            };
+        }
+
+        return points;
+    }
+
+    // With params.pruneAboveDv (km/s) the next solve only fully solves cells under that total Δv; the rest come
+    // back as PRUNED_MARKER. params.precision picks the solver arithmetic: 'double' (default), 'mixed' (float32
+    // iterations with a float64 correction, same results) or 'float' (float32 only, Δv within about 10 m/s).
+    // params.solver picks the Lambert backend: 'battin' (default), 'izzo', 'gooding' or 'auto'; precision only
+    // applies to 'battin'. Modules without these options ignore them.
+    _applySolverOptions(params) {
+        if (typeof this.wasm.setPorkchopPruning === 'function') {
+            this.wasm.setPorkchopPruning(params.pruneAboveDv > 0 ? params.pruneAboveDv : 0);
+        }
+        if (typeof this.wasm.setPorkchopPrecision === 'function') {
+            this.wasm.setPorkchopPrecision(SOLVER_PRECISIONS[params.precision] ?? SOLVER_PRECISIONS.double);
+        }
+        if (typeof this.wasm.setPorkchopSolver === 'function') {
+            this.wasm.setPorkchopSolver(LAMBERT_BACKENDS[params.solver] ?? LAMBERT_BACKENDS.battin);
+        }
+    }
+
+    supportsBinaryEphemeris() {
+        return typeof this.wasm.preparePorkchopBuffers === 'function';
+    }
+
+    // Copies two packed tables from /api/horizons/ephemeris (64-byte header, then float64 jd[n], r[3n], v[3n])
+    // into the module's input buffers. Returns the date points for plotting, or null for a malformed payload.
+    loadBinaryEphemeris(departureBuffer, arrivalBuffer) {
+        const decode = (buffer) => {
+            const header = new DataView(buffer, 0, 64);
+            const magic = String.fromCharCode(header.getUint8(0), header.getUint8(1), header.getUint8(2), header.getUint8(3));
+            const count = header.getUint32(8, true);
+
+            if (magic !== 'EPHC' || buffer.byteLength < 64 + 56 * count) {
+                return null;
+            }
+
+            return {
+                count,
+                jd: new Float64Array(buffer, 64, count),
+                r: new Float64Array(buffer, 64 + 8 * count, 3 * count),
+                v: new Float64Array(buffer, 64 + 32 * count, 3 * count)
+            };
+        };
+
+        const departure = decode(departureBuffer);
+        const arrival = decode(arrivalBuffer);
+        if (!departure || !arrival) {
+            console.error("Malformed ephemeris payload");
+            return null;
+        }
+
+        const wasm = this.wasm;
+        wasm.preparePorkchopBuffers(departure.count, arrival.count);
+
+        wasm.departureDatesView().set(departure.jd);
+        wasm.departurePositionsView().set(departure.r);
+        wasm.departureVelocitiesView().set(departure.v);
+        wasm.arrivalDatesView().set(arrival.jd);
+        wasm.arrivalPositionsView().set(arrival.r);
+        wasm.arrivalVelocitiesView().set(arrival.v);
+
+        return {
+            departure: Array.from(departure.jd, jd => ({ date: { jd } })),
+            arrival: Array.from(arrival.jd, jd => ({ date: { jd } }))
+        };
+    }
+
+    supportsAnalyticEphemeris() {
+        return typeof this.wasm.preparePorkchopBodies === 'function';
+    }
+
+    // Evaluates planet states on the requested date grids with the module's mean-element ephemeris, in the same
+    // point format as the Horizons route. Returns null when the module or either body is not supported.
+    loadBodyEphemeris(mu, departure, arrival) {
+        if (!this.supportsAnalyticEphemeris()) {
+            return null;
+        }
+
+        const wasm = this.wasm;
+        const loaded = wasm.preparePorkchopBodies(
+            mu,
+            departure.body, departure.startJd, departure.endJd, departure.stepDays,
+            arrival.body, arrival.startJd, arrival.endJd, arrival.stepDays
+        );
+
+        if (!loaded) {
+            return null;
+        }
+
+        return {
+            departure: this._readEphemerisViews(wasm.departurePositionsView(), wasm.departureVelocitiesView(),
+                wasm.departureDatesView()),
+            arrival: this._readEphemerisViews(wasm.arrivalPositionsView(), wasm.arrivalVelocitiesView(),
+                wasm.arrivalDatesView())
+        };
+    }
+
+    supportsProgressive() {
+        return typeof this.wasm.startPorkchopJob === 'function';
+    }
+
+    // Solves the grid in batches of departure rows, yielding to the event loop between batches. Unsolved cells
+    // are NaN in the grids passed to onProgress. Resolves to the final results, or null when options.signal aborts.
+    // With options.preloaded the module buffers already hold the states (loadBinaryEphemeris, loadBodyEphemeris)
+    // and the data arrays only provide the grid sizes.
+    async computePorkchopPlotProgressive(departureData, arrivalData, params, options = {}) {
+        if (!this.supportsProgressive()) {
+            return this.computePorkchopPlot(departureData, arrivalData, params, options);
+        }
+
+        const departurePoints = this._normalize(departureData);
+        const arrivalPoints = this._normalize(arrivalData);
+        const departureCount = departurePoints.length;
+        const arrivalCount = arrivalPoints.length;
+
+        if (departureCount === 0 || arrivalCount === 0) {
+            console.error("Invalid data for porkchop plot computation");
+            return null;
+        }
+
+        const { onProgress, signal } = options;
+        const frameMilliseconds = options.frameMilliseconds ?? 16;
+        const progressIntervalMilliseconds = options.progressIntervalMilliseconds ?? 100;
+
+        const wasm = this.wasm;
+        const readResults = () => this.processResultViews(
+            wasm.porkchopC3View(),
+            wasm.porkchopDv1View(),
+            wasm.porkchopTotalDvView(),
+            departureCount,
+            arrivalCount
+        );
+
+        const cancel = () => wasm.cancelPorkchopJob();
+        if (signal) {
+            if (signal.aborted) return null;
+            signal.addEventListener('abort', cancel, { once: true });
+        }
+
+        try {
+            if (!options.preloaded) {
+                this._loadEphemeris(departurePoints, arrivalPoints);
+            }
+
+            this._applySolverOptions(params);
+            wasm.startPorkchopJob(
+                params.mu,
+                params.departurePlanetMu,
+                params.arrivalPlanetMu,
+                params.departureOrbitRadius,
+                params.arrivalOrbitRadius,
+                params.float32 === true
+            );
+
+            // batch size adapts so one step stays within about one frame
+            let rowsPerStep = 1;
+            let rowsCompleted = 0;
+            let lastProgress = -Infinity;
+
+            while (rowsCompleted < departureCount) {
+                const stepStart = performance.now();
+                rowsCompleted = wasm.stepPorkchopJob(rowsPerStep);
+                const stepMilliseconds = performance.now() - stepStart;
+
+                if (rowsCompleted < 0) {
+                    return null;
+                }
+
+                if (stepMilliseconds < frameMilliseconds / 2) {
+                    rowsPerStep *= 2;
+                } else if (stepMilliseconds > frameMilliseconds * 2 && rowsPerStep > 1) {
+                    rowsPerStep = Math.max(1, rowsPerStep >> 1);
+                }
+
+                const now = performance.now();
+                if (onProgress && rowsCompleted < departureCount && now - lastProgress >= progressIntervalMilliseconds) {
+                    lastProgress = now;
+                    onProgress({ rowsCompleted, departureCount, results: readResults() });
+                }
+
+                await new Promise(resolve => setTimeout(resolve, 0));
+
+                if (signal && signal.aborted) {
+                    return null;
+                }
+            }
+
+            return readResults();
+        } catch (error) {
+            console.error("Error computing porkchop plot:", error);
+            return null;
+        } finally {
+            if (signal) signal.removeEventListener('abort', cancel);
+        }
+    }
+
+    computePorkchopPlot(departureData, arrivalData, params, options = {}) {
+        if (typeof this.wasm.preparePorkchopBuffers !== 'function') {
+            return this._computePorkchopPlotCopying(departureData, arrivalData, params);
+        }
+
+        const departurePoints = this._normalize(departureData);
+        const arrivalPoints = this._normalize(arrivalData);
+
+        if (departurePoints.length === 0 || arrivalPoints.length === 0) {
+            console.error("Invalid data for porkchop plot computation");
+            return null;
+        }
+
+        try {
+            const wasm = this.wasm;
+
+            if (!options.preloaded) {
+                this._loadEphemeris(departurePoints, arrivalPoints);
+            }
+
+            this._applySolverOptions(params);
+            wasm.computePorkchopPlotInPlace(
+                params.mu,
+                params.departurePlanetMu,
+                params.arrivalPlanetMu,
+                params.departureOrbitRadius,
+                params.arrivalOrbitRadius,
+                params.float32 === true
+            );
+
+            return this.processResultViews(
+                wasm.porkchopC3View(),
+                wasm.porkchopDv1View(),
+                wasm.porkchopTotalDvView(),
+                departurePoints.length,
+                arrivalPoints.length
+            );
+        } catch (error) {
+            console.error("Error computing porkchop plot:", error);
+            return null;
+        }
+    }
+
+    supportsMetrics() {
+        return typeof this.wasm.computePorkchopMetricsInPlace === 'function';
+    }
+
+    // Solves only the requested metrics, e.g. { totalDv: 'float32', dla: 'uint16' } (formats 'float64',
+    // 'float32' or 'uint16'). Returns { grids, departureCount, arrivalCount } with one departure-major
+    // typed-array view per metric; the views are only valid until the next solve. Quantized grids are read back
+    // with metricValues.
+    computePorkchopMetrics(departureData, arrivalData, params, metrics = { totalDv: 'float64' }, options = {}) {
+        if (!this.supportsMetrics()) {
+            return null;
+        }
+
+        const departurePoints = this._normalize(departureData);
+        const arrivalPoints = this._normalize(arrivalData);
+
+        if (departurePoints.length === 0 || arrivalPoints.length === 0) {
+            console.error("Invalid data for porkchop plot computation");
+            return null;
+        }
+
+        const formats = PORKCHOP_METRICS.map(name => metrics[name] in METRIC_FORMATS ? METRIC_FORMATS[metrics[name]] : -1);
+
+        try {
+            const wasm = this.wasm;
+
+            if (!options.preloaded) {
+                this._loadEphemeris(departurePoints, arrivalPoints);
+            }
+
+            this._applySolverOptions(params);
+            wasm.computePorkchopMetricsInPlace(
+                params.mu,
+                params.departurePlanetMu,
+                params.arrivalPlanetMu,
+                params.departureOrbitRadius,
+                params.arrivalOrbitRadius,
+                formats
+            );
+
+            const grids = {};
+            PORKCHOP_METRICS.forEach((name, metric) => {
+                if (formats[metric] >= 0) grids[name] = wasm.porkchopMetricView(metric);
+            });
+
+            return { grids, departureCount: departurePoints.length, arrivalCount: arrivalPoints.length };
+        } catch (error) {
+            console.error("Error computing porkchop metrics:", error);
+            return null;
+        }
+    }
+
+    // Values of a metric grid in its units; uint16 grids are expanded over the metric's quantization range, with
+    // PRUNED_MARKER for pruned cells and NaN for cells that have no value.
+    metricValues(name, grid) {
+        if (!(grid instanceof Uint16Array)) {
+            return grid;
+        }
+
+        const { min, max } = this.wasm.porkchopMetricRange(PORKCHOP_METRICS.indexOf(name));
+        const scale = (max - min) / QUANTIZED_MAX;
+
+        return Float32Array.from(grid, code => {
+            if (code === QUANTIZED_PRUNED) return PRUNED_MARKER;
+            return code > QUANTIZED_MAX ? NaN : min + code * scale;
+        });
+    }
+
+    supportsOptimumSearch() {
+        return typeof this.wasm.findPorkchopOptima === 'function';
+    }
+
+    // Refined minima of the last solve's grid, best first: objective 'totalDv' or 'c3', at most count of them.
+    // Each is { departureJd, arrivalJd, c3, dv1, totalDv, departureIndex, arrivalIndex }; the dates are
+    // continuous, not grid dates. Returns [] when the module lacks the search or the grid was not solved.
+    findPorkchopOptima(params, { objective = 'totalDv', count = 5 } = {}) {
+        if (!this.supportsOptimumSearch()) {
+            return [];
+        }
+
+        try {
+            return this.wasm.findPorkchopOptima(
+                params.mu,
+                params.departurePlanetMu,
+                params.arrivalPlanetMu,
+                params.departureOrbitRadius,
+                params.arrivalOrbitRadius,
+                objective === 'c3' ? 1 : 0,
+                count
+            );
+        } catch (error) {
+            console.error("Error searching porkchop optima:", error);
+            return [];
+        }
+    }
+
+    supportsContours() {
+        return typeof this.wasm.contourPorkchopMetric === 'function';
+    }
+
+    // Isolines of the last solve as polylines in the plot's index coordinates (x departure, y arrival, fractional):
+    // levels of the named metric grid, tofLevels in days (isochrones) and arrivalLevels in JD (constant arrival
+    // date). Returns { metric, tof, arrival }, each an array of { level, x, y } copied out of the module, so only
+    // the polylines cross the boundary instead of the grids. null when the module cannot contour.
+    porkchopContours({ metric = 'totalDv', levels = [], tofLevels = [], arrivalLevels = [] } = {}) {
+        if (!this.supportsContours()) {
+            return null;
+        }
+
+        const readPolylines = (views) => {
+            if (!views) return [];
+
+            const polylines = [];
+            for (let k = 0; k < views.levels.length; k++) {
+                const start = views.offsets[k];
+                const count = views.offsets[k + 1] - start;
+                const x = new Float32Array(count);
+                const y = new Float32Array(count);
+
+                for (let p = 0; p < count; p++) {
+                    x[p] = views.points[2 * (start + p)];
+                    y[p] = views.points[2 * (start + p) + 1];
+                }
+                polylines.push({ level: views.levels[k], x, y });
+            }
+            return polylines;
+        };
+
+        try {
+            const wasm = this.wasm;
+            const metricIndex = PORKCHOP_METRICS.indexOf(metric);
+
+            return {
+                metric: levels.length > 0 && metricIndex >= 0
+                    ? readPolylines(wasm.contourPorkchopMetric(metricIndex, levels)) : [],
+                tof: tofLevels.length > 0 ? readPolylines(wasm.contourPorkchopTimeOfFlight(tofLevels)) : [],
+                arrival: arrivalLevels.length > 0
+                    ? readPolylines(wasm.contourPorkchopArrivalDate(arrivalLevels)) : []
+            };
+        } catch (error) {
+            console.error("Error contouring porkchop grids:", error);
+            return null;
+        }
+    }
+
+    _computePorkchopPlotCopying(departureData, arrivalData, params) {
         const depData = this.createTypedArrays(departureData);
         const arrData = this.createTypedArrays(arrivalData);
 
@@ -102,29 +545,6 @@ export class CelestialDataParser {
                 params.arrivalOrbitRadius
             );
 
-            // const fromVec = cppVector => {
-            //     const out = [];
-            //     const n   = cppVector.size();
-            //     for (let i = 0; i < n; ++i) out.push(cppVector.get(i));
-            //     return out;
-            // };
-            //
-            // const result = fromVec(results);
-            // console.log(result);
-            //
-            // console.log("Results full dump:", results);
-            // console.log("Results properties:", Object.keys(results));
-            // console.log("Results length:", results.length);
-            // console.log("Is results.data available?", results.data !== undefined);
-            // console.log("Is results.size available?", results.size !== undefined);
-            //
-            // try {
-            //     console.log("First element access:", results[0]);
-            //     console.log("Can iterate?", [...results].length > 0);
-            // } catch(e) {
-            //     console.log("Cannot access as array:", e);
-            // }
-
             return this.processResults(results, depData.count, arrData.count);
         } catch (error) {
             console.error("Error computing porkchop plot:", error);
@@ -132,6 +552,51 @@ export class CelestialDataParser {
         }
     }
 
+    // Copies the dates and result grids of the last solve out of the module heap, in the result cache's format.
+    snapshotResults() {
+        const wasm = this.wasm;
+
+        return {
+            departureJd: wasm.departureDatesView().slice(),
+            arrivalJd: wasm.arrivalDatesView().slice(),
+            c3: wasm.porkchopC3View().slice(),
+            dv1: wasm.porkchopDv1View().slice(),
+            totalDv: wasm.porkchopTotalDvView().slice()
+        };
+    }
+
+    // Builds the arrival-major grids for plotting directly from the Float64Array/Float32Array result views.
+    processResultViews(c3, dv1, totalDv, departureCount, arrivalCount) {
+        const c3Grid = [];
+        const dv1Grid = [];
+        const totalDvGrid = [];
+
+        for (let j = 0; j < arrivalCount; j++) {
+            const c3Row = new Array(departureCount);
+            const dv1Row = new Array(departureCount);
+            const totalDvRow = new Array(departureCount);
+
+            for (let i = 0; i < departureCount; i++) {
+                const index = i * arrivalCount + j;
+                c3Row[i] = c3[index];
+                dv1Row[i] = dv1[index];
+                totalDvRow[i] = totalDv[index];
+            }
+
+            c3Grid.push(c3Row);
+            dv1Grid.push(dv1Row);
+            totalDvGrid.push(totalDvRow);
+        }
+
+        return {
+            c3: c3Grid,
+            dv1: dv1Grid,
+            totalDv: totalDvGrid,
+            departureCount,
+            arrivalCount
+        };
+    }
+
     processResults(results, departureCount, arrivalCount) {
         const totalSize = departureCount * arrivalCount;
 
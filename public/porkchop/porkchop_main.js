@@ -1,4 +1,4 @@
-import { fetchHorizonsData } from "../horizon.js";
+import { fetchHorizonsData, cancelPorkchopComputation } from "../horizon.js";
 
 let solarSystemData = {};
 
@@ -11,6 +11,11 @@ document.addEventListener('DOMContentLoaded', function () {
         button.addEventListener('click', fetchHorizonsData);
     }
 
+    const cancelButton = document.getElementById('cancelButton');
+    if (cancelButton) {
+        cancelButton.addEventListener('click', cancelPorkchopComputation);
+    }
+
     document.getElementById('departureAltitude').addEventListener('input', () => {
         updateBodyDetails('departure');
     });
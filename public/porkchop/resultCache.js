@@ -0,0 +1,184 @@
+// Content-addressed cache of porkchop results in the browser, mirroring src/backend/utils/resultCache.js.
+// Entries are { departureJd, arrivalJd, c3, dv1, totalDv } typed arrays keyed by a SHA-256 of the request
+// inputs. Recent entries stay in memory up to maxBytes. New results are also written to Cache Storage (when
+// available, up to maxStoredEntries, oldest first out), so they survive eviction and page reloads.
+// Concurrent getOrCompute calls for the same key share one computation.
+
+const STORAGE_NAME = 'porkchop-results-v2';
+
+function canonicalJson(value) {
+    if (Array.isArray(value)) {
+        return `[${value.map(canonicalJson).join(',')}]`;
+    }
+    if (value && typeof value === 'object') {
+        return `{${Object.keys(value).sort().map(key => `${JSON.stringify(key)}:${canonicalJson(value[key])}`).join(',')}}`;
+    }
+    return JSON.stringify(value);
+}
+
+function entryBytes(entry) {
+    return entry.departureJd.byteLength + entry.arrivalJd.byteLength +
+        entry.c3.byteLength + entry.dv1.byteLength + entry.totalDv.byteLength;
+}
+
+// The PKCH grid format of src/cpp/porkchop_io.h: "PKCH", then n, m and bytes per result value as uint32, then
+// the five arrays, each 8-byte aligned. The server-side path returns the same bytes.
+const PKCH_MAGIC = 0x48434b50;
+
+function pack(entry) {
+    const n = entry.departureJd.length;
+    const m = entry.arrivalJd.length;
+    const valueBytes = entry.c3.BYTES_PER_ELEMENT;
+    const resultBytes = Math.ceil(n * m * valueBytes / 8) * 8;
+
+    const buffer = new ArrayBuffer(16 + 8 * (n + m) + 3 * resultBytes);
+    new Uint32Array(buffer, 0, 4).set([PKCH_MAGIC, n, m, valueBytes]);
+
+    let offset = 16;
+    for (const array of [entry.departureJd, entry.arrivalJd, entry.c3, entry.dv1, entry.totalDv]) {
+        new Uint8Array(buffer, offset, array.byteLength).set(new Uint8Array(array.buffer, array.byteOffset, array.byteLength));
+        offset += Math.ceil(array.byteLength / 8) * 8;
+    }
+
+    return buffer;
+}
+
+export function unpackPorkchopGrid(buffer) {
+    const [magic, n, m, valueBytes] = new Uint32Array(buffer, 0, 4);
+    if (magic !== PKCH_MAGIC || (valueBytes !== 4 && valueBytes !== 8)) {
+        return null;
+    }
+
+    const Values = valueBytes === 4 ? Float32Array : Float64Array;
+    const resultBytes = Math.ceil(n * m * valueBytes / 8) * 8;
+
+    let offset = 16;
+    const departureJd = new Float64Array(buffer, offset, n);
+    offset += 8 * n;
+    const arrivalJd = new Float64Array(buffer, offset, m);
+    offset += 8 * m;
+    const c3 = new Values(buffer, offset, n * m);
+    const dv1 = new Values(buffer, offset + resultBytes, n * m);
+    const totalDv = new Values(buffer, offset + 2 * resultBytes, n * m);
+
+    return { departureJd, arrivalJd, c3, dv1, totalDv };
+}
+
+export class PorkchopResultCache {
+    constructor({ maxBytes = 128 * 1024 * 1024, maxStoredEntries = 32 } = {}) {
+        this.maxBytes = maxBytes;
+        this.maxStoredEntries = maxStoredEntries;
+        this.memory = new Map();    // insertion order is recency order
+        this.memoryBytes = 0;
+        this.pending = new Map();
+    }
+
+    static async key(inputs) {
+        const bytes = new TextEncoder().encode(canonicalJson(inputs));
+        const digest = await crypto.subtle.digest('SHA-256', bytes);
+        return Array.from(new Uint8Array(digest), byte => byte.toString(16).padStart(2, '0')).join('');
+    }
+
+    async get(key) {
+        const entry = this.memory.get(key);
+        if (entry) {
+            this.memory.delete(key);
+            this.memory.set(key, entry);
+            return entry;
+        }
+
+        const storage = await this._storage();
+        const response = storage ? await storage.match(this._url(key)) : undefined;
+        if (!response) {
+            return null;
+        }
+
+        const stored = unpackPorkchopGrid(await response.arrayBuffer());
+        if (!stored) {
+            return null;
+        }
+
+        this._remember(key, stored);
+        return stored;
+    }
+
+    isPending(key) {
+        return this.pending.has(key);
+    }
+
+    // compute resolves to an entry, or null for results that should not be cached (e.g. a cancelled run).
+    async getOrCompute(key, compute) {
+        const cached = await this.get(key);
+        if (cached) return cached;
+
+        if (this.pending.has(key)) {
+            return this.pending.get(key);
+        }
+
+        const computation = (async () => {
+            try {
+                const entry = await compute();
+                if (entry) {
+                    this._remember(key, entry);
+                    this._store(key, entry);
+                }
+                return entry;
+            } finally {
+                this.pending.delete(key);
+            }
+        })();
+
+        this.pending.set(key, computation);
+        return computation;
+    }
+
+    _url(key) {
+        return `/porkchop-results/${key}`;
+    }
+
+    async _storage() {
+        if (typeof caches === 'undefined') {
+            return null;
+        }
+        try {
+            return await caches.open(STORAGE_NAME);
+        } catch (error) {
+            return null;
+        }
+    }
+
+    _remember(key, entry) {
+        const previous = this.memory.get(key);
+        if (previous) {
+            this.memoryBytes -= entryBytes(previous);
+            this.memory.delete(key);
+        }
+
+        this.memory.set(key, entry);
+        this.memoryBytes += entryBytes(entry);
+
+        while (this.memoryBytes > this.maxBytes && this.memory.size > 1) {
+            const [evictedKey, evicted] = this.memory.entries().next().value;
+            this.memory.delete(evictedKey);
+            this.memoryBytes -= entryBytes(evicted);
+        }
+    }
+
+    _store(key, entry) {
+        const store = async () => {
+            const storage = await this._storage();
+            if (!storage) return;
+
+            await storage.put(this._url(key), new Response(pack(entry), {
+                headers: { 'Content-Type': 'application/octet-stream' }
+            }));
+
+            const stored = await storage.keys();
+            for (let k = 0; k + this.maxStoredEntries < stored.length; k++) {
+                await storage.delete(stored[k]);
+            }
+        };
+
+        store().catch(error => console.warn('Porkchop result store failed:', error));
+    }
+}
@@ -1,4 +1,8 @@
-export async function visualizePorkchopPlot(results, departureParsedData, arrivalParsedData) {
+// With options.partial the plot is redrawn in place and the status badge is left to the caller. options.optima,
+// when given, are the refined minima from CelestialDataParser.findPorkchopOptima: they are marked on the plot and
+// the best one replaces the grid minimum in the summary. options.contours, when given, are the isolines from
+// CelestialDataParser.porkchopContours, drawn as traced; without them the time-of-flight contours are computed here.
+export async function visualizePorkchopPlot(results, departureParsedData, arrivalParsedData, options = {}) {
 
     if (!results || !results.totalDv) {
         console.error("No data to visualize.");
@@ -14,6 +18,23 @@ export async function visualizePorkchopPlot(results, departureParsedData, arriva
         return `${year}-${month}-${day}`;
     }
 
+    function formatDateTime(jd) {
+        const date = new Date((jd - 2440587.5) * 86400000);
+        const hours = String(date.getHours()).padStart(2, '0');
+        const minutes = String(date.getMinutes()).padStart(2, '0');
+        return `${formatDate(jd)} ${hours}:${minutes}`;
+    }
+
+    // position of a date between grid dates, in the plot's index coordinates
+    function fractionalIndex(parsedData, jd) {
+        const last = parsedData.length - 1;
+        if (last <= 0) return 0;
+        let k = 0;
+        while (k < last - 1 && parsedData[k + 1].date.jd <= jd) k++;
+        const span = parsedData[k + 1].date.jd - parsedData[k].date.jd;
+        return k + (span > 0 ? (jd - parsedData[k].date.jd) / span : 0);
+    }
+
     const departureDates = departureParsedData.map(item =>
         item.date.formatted && !item.date.formatted.includes('JD') ? item.date.formatted : formatDate(item.date.jd)
     );
@@ -77,20 +98,12 @@ export async function visualizePorkchopPlot(results, departureParsedData, arriva
         ];
     };
 
-    const tofMatrix = [];
-    for (let i = 0; i < results.totalDv.length; i++) {
-        const tofRow = [];
-        for (let j = 0; j < results.totalDv[i].length; j++) {
-            const jdDep = departureParsedData[j]?.date.jd;
-            const jdArr = arrivalParsedData[i]?.date.jd;
-            if (jdDep != null && jdArr != null) {
-                const tof = Math.round(jdArr - jdDep);
-                tofRow.push(isFinite(tof) ? tof : null);
-            } else {
-                tofRow.push(null);
-            }
-        }
-        tofMatrix.push(tofRow);
+    function tofDaysAt(i, j) {
+        const jdDep = departureParsedData[j]?.date.jd;
+        const jdArr = arrivalParsedData[i]?.date.jd;
+        if (jdDep == null || jdArr == null) return null;
+        const tof = Math.round(jdArr - jdDep);
+        return isFinite(tof) ? tof : null;
     }
 
     const hoverTexts = [];
@@ -104,7 +117,7 @@ export async function visualizePorkchopPlot(results, departureParsedData, arriva
             } else {
                 const departureDate = departureDates[j];
                 const arrivalDate = arrivalDates[i];
-                const tofDays = tofMatrix[i][j];
+                const tofDays = tofDaysAt(i, j);
 
                 let hoverText = `Departure: ${departureDate}<br>Arrival: ${arrivalDate}<br>Delta-V: ${value.toFixed(2)} km/s`;
 
@@ -148,25 +161,50 @@ export async function visualizePorkchopPlot(results, departureParsedData, arriva
         }
     };
 
-    const contourData = {
-        z: tofMatrix,
-        type: 'contour',
-        contours: {
-            coloring: 'none',
-            showlabels: true,
-            labelfont: { size: 10, color: 'black' },
-            start: 0,
-            end: 900,
-            size: 50
-        },
-        line: {
-            color: 'gray',
-            width: 1,
-            dash: 'dot'
-        },
-        showscale: false,
-        hovertemplate: ' ',
-        hoverinfo: 'skip'
+    // one line trace per polyline, labelled at its middle point
+    const polylineTraces = (polylines, label, line) => polylines.map(polyline => {
+        const text = new Array(polyline.x.length).fill('');
+        text[polyline.x.length >> 1] = label(polyline.level);
+        return {
+            x: polyline.x,
+            y: polyline.y,
+            type: 'scatter',
+            mode: 'lines+text',
+            line,
+            text,
+            textfont: { size: 10, color: 'black' },
+            hoverinfo: 'skip',
+            showlegend: false
+        };
+    });
+
+    const tofContourTraces = () => {
+        const contours = options.contours;
+        if (contours) {
+            return polylineTraces(contours.tof, level => `${level}`, { color: 'gray', width: 1, dash: 'dot' });
+        }
+
+        const tofMatrix = results.totalDv.map((row, i) => Array.from(row, (value, j) => tofDaysAt(i, j)));
+        return [{
+            z: tofMatrix,
+            type: 'contour',
+            contours: {
+                coloring: 'none',
+                showlabels: true,
+                labelfont: { size: 10, color: 'black' },
+                start: 0,
+                end: 900,
+                size: 50
+            },
+            line: {
+                color: 'gray',
+                width: 1,
+                dash: 'dot'
+            },
+            showscale: false,
+            hovertemplate: ' ',
+            hoverinfo: 'skip'
+        }];
     };
 
     const layout = {
@@ -192,9 +230,42 @@ export async function visualizePorkchopPlot(results, departureParsedData, arriva
         hovermode: 'closest'
     };
 
+    const optima = options.optima || [];
+    const traces = [...tofContourTraces(), heatmapData];
+
+    if (options.contours) {
+        traces.push(...polylineTraces(options.contours.metric, level => `${level.toFixed(2)} km/s`,
+            { color: 'white', width: 1 }));
+    }
+
+    if (optima.length > 0) {
+        traces.push({
+            x: optima.map(optimum => fractionalIndex(departureParsedData, optimum.departureJd)),
+            y: optima.map(optimum => fractionalIndex(arrivalParsedData, optimum.arrivalJd)),
+            type: 'scatter',
+            mode: 'markers',
+            marker: {
+                symbol: optima.map((optimum, k) => k === 0 ? 'star' : 'circle-open'),
+                size: optima.map((optimum, k) => k === 0 ? 16 : 10),
+                color: 'white',
+                line: { color: 'black', width: 1.5 }
+            },
+            text: optima.map((optimum, k) =>
+                `${k === 0 ? 'Global minimum' : `Local minimum ${k + 1}`}<br>` +
+                `Departure: ${formatDateTime(optimum.departureJd)}<br>` +
+                `Arrival: ${formatDateTime(optimum.arrivalJd)}<br>` +
+                `Delta-V: ${optimum.totalDv.toFixed(3)} km/s<br>` +
+                `C3: ${optimum.c3.toFixed(2)} km²/s²`),
+            hoverinfo: 'text',
+            showlegend: false
+        });
+    }
+
     if (optimalRow >= 0 && optimalCol >= 0) {
-        const optimalDeparture = departureDates[optimalCol];
-        const optimalArrival = arrivalDates[optimalRow];
+        const best = optima[0];
+        const optimalDeparture = best ? formatDateTime(best.departureJd) : departureDates[optimalCol];
+        const optimalArrival = best ? formatDateTime(best.arrivalJd) : arrivalDates[optimalRow];
+        const optimalDv = best ? best.totalDv : minDv;
 
         // layout.annotations.push({
         //     x: optimalCol,
@@ -222,16 +293,16 @@ export async function visualizePorkchopPlot(results, departureParsedData, arriva
                 <ul>
                     <li><strong>Departure Date:</strong> ${optimalDeparture}</li>
                     <li><strong>Arrival Date</strong> ${optimalArrival}</li>
-                    <li><strong>Required Δv:</strong> ${minDv.toFixed(2)} km/s</li>
+                    <li><strong>Required Δv:</strong> ${optimalDv.toFixed(best ? 3 : 2)} km/s</li>
                     <li><strong>Delta-V Range:</strong> ${minDv.toFixed(2)} - ${maxDv.toFixed(2)} km/s</li>
                 </ul>
             </div>
         `;
 
         try {
-            const departureDate = new Date(optimalDeparture);
-            const arrivalDate = new Date(optimalArrival);
-            const tofDays = Math.round((arrivalDate - departureDate) / (1000 * 60 * 60 * 24));
+            const tofDays = best
+                ? (best.arrivalJd - best.departureJd).toFixed(1)
+                : Math.round((new Date(optimalArrival) - new Date(optimalDeparture)) / (1000 * 60 * 60 * 24));
             const resultList = resultDiv.querySelector('ul');
             const tofItem = document.createElement('li');
             tofItem.innerHTML = `<strong>Time Of Flight (TOF):</strong> ${tofDays} Days`;
@@ -255,7 +326,12 @@ export async function visualizePorkchopPlot(results, departureParsedData, arriva
         }
     };
 
-    Plotly.newPlot('porkchopPlotContainer', [contourData, heatmapData], layout, config);
+    Plotly.react('porkchopPlotContainer', traces, layout, config);
+
+    if (options.partial) {
+        return;
+    }
+
     document.getElementById('status-badge').className = "badge bg-success";
     document.getElementById('status-badge').innerText = "Calculation Complete";
 }
\ No newline at end of file
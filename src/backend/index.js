@@ -99,7 +99,9 @@ app.use(
                 "upgrade-insecure-requests": [],
             },
         },
-        crossOriginEmbedderPolicy: false,
+        /* ── Cross-origin isolation (SharedArrayBuffer for the pthreads WASM build) ── */
+        crossOriginOpenerPolicy: { policy: "same-origin" },
+        crossOriginEmbedderPolicy: { policy: "credentialless" },
         crossOriginResourcePolicy: { policy: "cross-origin" },
     }),
 );
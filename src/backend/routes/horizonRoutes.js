@@ -2,6 +2,8 @@ const express = require('express');
 const axios = require('axios');
 const logVisitorCall = require("../middlewares/logVisitorCall");
 const {query, validationResult} = require('express-validator');
+const {getEphemeris, encode} = require('../utils/ephemerisCache');
+const porkchopCompute = require('../utils/porkchopCompute');
 
 const router = express.Router();
 
@@ -16,6 +18,169 @@ const validateCombinedRequest = [
     query('arrStepSize').optional().matches(/^\d+[dhm]$/).withMessage('Vaild step size needed')
 ];
 
+const HORIZONS_CENTER = '500@10';
+const HORIZONS_REF_PLANE = 'ECLIPTIC';
+
+function dateToJulianDate(date) {
+    const time = Date.parse(date);
+    return Number.isNaN(time) ? null : time / 86400000 + 2440587.5;
+}
+
+function stepSizeInDays(stepSize) {
+    const match = /^(\d+)([dhm])$/.exec(stepSize);
+    if (!match) return null;
+
+    const value = parseInt(match[1], 10);
+    return value > 0 ? {d: value, h: value / 24, m: value / 1440}[match[2]] : null;
+}
+
+// States of one body on the grid start + k * step through the on-disk cache; Horizons is only asked for the
+// part of the range no cached table covers.
+async function getCachedStates(body, start, end, stepSize = '1d') {
+    const startJd = dateToJulianDate(start);
+    const endJd = dateToJulianDate(end);
+    const stepDays = stepSizeInDays(stepSize);
+
+    if (startJd === null || endJd === null || !stepDays || endJd < startJd) {
+        throw new RangeError('Invalid date range or step size');
+    }
+
+    const fetchStates = async (fetchStartJd, fetchEndJd) => {
+        const rawData = await getHorizonsData(body, `JD${fetchStartJd}`, `JD${fetchEndJd}`, stepSize);
+        return toStateArrays(parseHorizonsData(rawData), fetchStartJd, stepDays);
+    };
+
+    return getEphemeris({body, center: HORIZONS_CENTER, frame: HORIZONS_REF_PLANE, startJd, endJd, stepDays},
+        fetchStates);
+}
+
+function toStateArrays(points, startJd, stepDays) {
+    const count = points.length;
+    const jd = new Float64Array(count);
+    const r = new Float64Array(3 * count);
+    const v = new Float64Array(3 * count);
+
+    points.forEach((point, k) => {
+        jd[k] = point.date.jd;
+        r.set([point.position.x, point.position.y, point.position.z], 3 * k);
+        v.set([point.velocity.vx, point.velocity.vy, point.velocity.vz], 3 * k);
+    });
+
+    return {startJd: count > 0 ? jd[0] : startJd, stepDays, jd, r, v};
+}
+
+// Calendar date of a JD in the Horizons table format, e.g. 2025-Jan-01 00:00:00.0000
+function toHorizonsDate(jd) {
+    const months = ['Jan', 'Feb', 'Mar', 'Apr', 'May', 'Jun', 'Jul', 'Aug', 'Sep', 'Oct', 'Nov', 'Dec'];
+    const date = new Date(Math.round((jd - 2440587.5) * 86400000));
+    const pad = (value, width) => String(value).padStart(width, '0');
+
+    return `${date.getUTCFullYear()}-${months[date.getUTCMonth()]}-${pad(date.getUTCDate(), 2)} ` +
+        `${pad(date.getUTCHours(), 2)}:${pad(date.getUTCMinutes(), 2)}:${pad(date.getUTCSeconds(), 2)}.` +
+        `${pad(date.getUTCMilliseconds(), 3)}0`;
+}
+
+// Same point shape as parseHorizonsData, so /combined answers as it did before the cache.
+function toDataPoints(states) {
+    const points = [];
+
+    for (let k = 0; k < states.jd.length; k++) {
+        const dateStr = toHorizonsDate(states.jd[k]);
+        points.push({
+            date: {jd: states.jd[k], dateStr, iso: convertToISODate(dateStr)},
+            position: {x: states.r[3 * k], y: states.r[3 * k + 1], z: states.r[3 * k + 2]},
+            velocity: {vx: states.v[3 * k], vy: states.v[3 * k + 1], vz: states.v[3 * k + 2]}
+        });
+    }
+
+    return points;
+}
+
+// One body as the packed cache format (see utils/ephemerisCache.js), ready to copy into the WASM buffers.
+router.get('/ephemeris', async (req, res) => {
+    const {body, start, end, step} = req.query;
+
+    if (!body || !start || !end) {
+        return res.status(400).json({error: "(body, start, end)"});
+    }
+
+    try {
+        const states = await getCachedStates(body, start, end, step);
+
+        res.set('Content-Type', 'application/octet-stream');
+        res.set('Cache-Control', 'public, max-age=86400');
+        res.send(encode(states));
+    } catch (error) {
+        if (error instanceof RangeError) {
+            return res.status(400).json({error: error.message});
+        }
+        console.error('Ephemeris request failed:', error.message);
+        res.status(500).json({error: 'Failed to fetch Horizons data'});
+    }
+});
+
+// Largest grid the server-side path accepts.
+const MAX_SERVER_CELLS = 25e6;
+
+function gridCount(start, end, stepSize) {
+    const startJd = dateToJulianDate(start);
+    const endJd = dateToJulianDate(end);
+    const stepDays = stepSizeInDays(stepSize);
+    return startJd === null || endJd === null || !stepDays || endJd < startJd ? 0 : Math.floor((endJd - startJd) / stepDays + 1e-6) + 1;
+}
+
+// Whole porkchop grid solved by the native executable, in the PKCH format of src/cpp/porkchop_io.h.
+router.get('/porkchop', async (req, res) => {
+    const {depBody, arrBody, depStart, depEnd, arrStart, arrEnd, depStep = '1d', arrStep = '1d'} = req.query;
+
+    if (!depBody || !arrBody || !depStart || !depEnd || !arrStart || !arrEnd) {
+        return res.status(400).json({error: "(depBody, arrBody, depStart, depEnd, arrStart, arrEnd)"});
+    }
+
+    if (!await porkchopCompute.isAvailable()) {
+        return res.status(503).json({error: 'Server-side porkchop computation is not available'});
+    }
+
+    const cells = gridCount(depStart, depEnd, depStep) * gridCount(arrStart, arrEnd, arrStep);
+    if (cells <= 0 || cells > MAX_SERVER_CELLS) {
+        return res.status(400).json({error: `Grid must have between 1 and ${MAX_SERVER_CELLS} cells`});
+    }
+
+    const number = (value, fallback) => {
+        const parsed = parseFloat(value);
+        return Number.isFinite(parsed) ? parsed : fallback;
+    };
+
+    const params = {
+        mu: number(req.query.mu, 132712440018),
+        departurePlanetMu: number(req.query.depMu, 398600.4418),
+        arrivalPlanetMu: number(req.query.arrMu, 42828.3),
+        departureOrbitRadius: number(req.query.depRadius, 6778.0),
+        arrivalOrbitRadius: number(req.query.arrRadius, 3396.0),
+        float32: req.query.float32 === '1' || req.query.float32 === 'true',
+        precision: ['mixed', 'float'].includes(req.query.precision) ? req.query.precision : 'double',
+        solver: ['izzo', 'gooding', 'auto'].includes(req.query.solver) ? req.query.solver : 'battin'
+    };
+
+    const request = {depBody, arrBody, depStart, depEnd, arrStart, arrEnd, depStep, arrStep};
+
+    try {
+        const grid = await porkchopCompute.computePorkchop(request, () => Promise.all([
+            getCachedStates(depBody, depStart, depEnd, depStep),
+            getCachedStates(arrBody, arrStart, arrEnd, arrStep)
+        ]), params);
+
+        res.set('Content-Type', 'application/octet-stream');
+        res.send(grid);
+    } catch (error) {
+        if (error instanceof RangeError) {
+            return res.status(400).json({error: error.message});
+        }
+        console.error('Server-side porkchop failed:', error.message);
+        res.status(500).json({error: 'Porkchop computation failed'});
+    }
+});
+
 router.get('/combined', async (req, res) => {
     const {depBody, arrBody, depStart, depEnd, arrStart, arrEnd, depStep, arrStep} = req.query;
 
@@ -24,13 +189,13 @@ router.get('/combined', async (req, res) => {
     }
 
     try {
-        const [depData, arrData] = await Promise.all([
-            getHorizonsData(depBody, depStart, depEnd, depStep),
-            getHorizonsData(arrBody, arrStart, arrEnd, arrStep)
+        const [depStates, arrStates] = await Promise.all([
+            getCachedStates(depBody, depStart, depEnd, depStep),
+            getCachedStates(arrBody, arrStart, arrEnd, arrStep)
         ]);
 
-        const parsedDep = parseHorizonsData(depData);
-        const parsedArr = parseHorizonsData(arrData);
+        const parsedDep = toDataPoints(depStates);
+        const parsedArr = toDataPoints(arrStates);
 
         await logVisitorCall(req, {
             depBody,
@@ -57,12 +222,12 @@ const getHorizonsData = async (bodyName, start, stop, stepSize = '1d') => {
                 format: 'json',
                 COMMAND: bodyName,
                 EPHEM_TYPE: 'VECTORS',
-                CENTER: '500@10',
+                CENTER: HORIZONS_CENTER,
                 START_TIME: start,
                 STOP_TIME: stop,
                 STEP_SIZE: stepSize,
                 OUT_UNITS: 'KM-S',
-                REF_PLANE: 'ECLIPTIC'
+                REF_PLANE: HORIZONS_REF_PLANE
             },
             timeout: 10000
         });
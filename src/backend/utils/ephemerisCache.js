@@ -0,0 +1,217 @@
+const fs = require('fs');
+const path = require('path');
+
+// On-disk cache of Horizons state tables.
+//
+// Every file holds one body on one uniform date grid, keyed by body, center, reference plane and step:
+//
+//   offset 0    char[4]  "EPHC"
+//   offset 4    uint32   format version
+//   offset 8    uint32   sample count n
+//   offset 16   float64  first JD
+//   offset 24   float64  step in days
+//   offset 64   float64  jd[n], r[3n], v[3n]   (km, km/s; r and v interleaved x, y, z per sample)
+//
+// The arrays match the module's input buffers, so a slice can be copied into the WASM heap as is. A request
+// is served from any cached grid of the same key that covers it and shares its alignment; a grid that only
+// partly covers it is extended by fetching the missing head or tail.
+
+const MAGIC = 'EPHC';
+const VERSION = 1;
+const HEADER_BYTES = 64;
+
+const cacheDir = process.env.EPHEMERIS_CACHE_DIR || path.join(__dirname, '../../../cache/ephemeris');
+
+// key -> [{ file, startJd, stepDays, count }]
+const index = new Map();
+let indexLoaded = null;
+
+// Grids whose offsets differ by less than this many steps from an integer are treated as aligned.
+const ALIGNMENT_TOLERANCE = 1e-6;
+
+function cacheKey({ body, center, frame, stepDays }) {
+    return [body, center, frame, stepDays].map(part => String(part).replace(/[^0-9A-Za-z.@-]/g, '_')).join('_');
+}
+
+function fileName(key, startJd, count) {
+    return `${key}__${startJd.toFixed(6)}__${count}.eph`;
+}
+
+async function loadIndex() {
+    await fs.promises.mkdir(cacheDir, { recursive: true });
+
+    for (const file of await fs.promises.readdir(cacheDir)) {
+        const match = /^(.*)__([\d.]+)__(\d+)\.eph$/.exec(file);
+        if (!match) continue;
+
+        const key = match[1];
+        const stepDays = parseFloat(key.split('_').pop());
+        const entry = { file, startJd: parseFloat(match[2]), stepDays, count: parseInt(match[3], 10) };
+
+        if (!index.has(key)) index.set(key, []);
+        index.get(key).push(entry);
+    }
+}
+
+function ensureIndex() {
+    if (!indexLoaded) indexLoaded = loadIndex();
+    return indexLoaded;
+}
+
+function stepOffset(entry, jd) {
+    return (jd - entry.startJd) / entry.stepDays;
+}
+
+function isAligned(entry, jd) {
+    const offset = stepOffset(entry, jd);
+    return Math.abs(offset - Math.round(offset)) < ALIGNMENT_TOLERANCE;
+}
+
+function entryEndJd(entry) {
+    return entry.startJd + entry.stepDays * (entry.count - 1);
+}
+
+function encode(states) {
+    const { startJd, stepDays, jd, r, v } = states;
+    const count = jd.length;
+    const buffer = Buffer.alloc(HEADER_BYTES + 8 * 7 * count);
+
+    buffer.write(MAGIC, 0, 'ascii');
+    buffer.writeUInt32LE(VERSION, 4);
+    buffer.writeUInt32LE(count, 8);
+    buffer.writeDoubleLE(startJd, 16);
+    buffer.writeDoubleLE(stepDays, 24);
+
+    const body = new Float64Array(buffer.buffer, buffer.byteOffset + HEADER_BYTES, 7 * count);
+    body.set(jd, 0);
+    body.set(r, count);
+    body.set(v, 4 * count);
+
+    return buffer;
+}
+
+// Reads samples [first, first + count) of a cache file with three positioned reads.
+async function readSlice(entry, first, count) {
+    const handle = await fs.promises.open(path.join(cacheDir, entry.file), 'r');
+
+    try {
+        const header = Buffer.alloc(HEADER_BYTES);
+        await handle.read(header, 0, HEADER_BYTES, 0);
+        if (header.toString('ascii', 0, 4) !== MAGIC || header.readUInt32LE(4) !== VERSION) {
+            throw new Error(`Corrupt ephemeris cache file ${entry.file}`);
+        }
+
+        const n = entry.count;
+        const read = async (arrayOffset, elements) => {
+            const bytes = Buffer.alloc(8 * elements);
+            await handle.read(bytes, 0, bytes.length, HEADER_BYTES + 8 * arrayOffset);
+            return new Float64Array(bytes.buffer, bytes.byteOffset, elements);
+        };
+
+        return {
+            startJd: entry.startJd + first * entry.stepDays,
+            stepDays: entry.stepDays,
+            jd: await read(first, count),
+            r: await read(n + 3 * first, 3 * count),
+            v: await read(4 * n + 3 * first, 3 * count)
+        };
+    } finally {
+        await handle.close();
+    }
+}
+
+async function store(key, states, replaced) {
+    const count = states.jd.length;
+    const entry = { file: fileName(key, states.startJd, count), startJd: states.startJd, stepDays: states.stepDays, count };
+
+    const temporary = path.join(cacheDir, `${entry.file}.${process.pid}.tmp`);
+    await fs.promises.writeFile(temporary, encode(states));
+    await fs.promises.rename(temporary, path.join(cacheDir, entry.file));
+
+    const entries = (index.get(key) || []).filter(other => other !== replaced && other.file !== entry.file);
+    entries.push(entry);
+    index.set(key, entries);
+
+    if (replaced && replaced.file !== entry.file) {
+        await fs.promises.unlink(path.join(cacheDir, replaced.file)).catch(() => {});
+    }
+
+    return entry;
+}
+
+// True when the last sample sits where the grid puts it, i.e. no part came back short.
+function isContiguous(states) {
+    const last = states.jd.length - 1;
+    return Math.abs(states.jd[last] - (states.startJd + last * states.stepDays)) < ALIGNMENT_TOLERANCE * states.stepDays;
+}
+
+// Joins the non-empty parts in order; null when there are none.
+function concatenate(parts) {
+    const filled = parts.filter(part => part && part.jd.length > 0);
+    if (filled.length === 0) {
+        return null;
+    }
+
+    const count = filled.reduce((sum, part) => sum + part.jd.length, 0);
+    const jd = new Float64Array(count);
+    const r = new Float64Array(3 * count);
+    const v = new Float64Array(3 * count);
+
+    let offset = 0;
+    for (const part of filled) {
+        jd.set(part.jd, offset);
+        r.set(part.r, 3 * offset);
+        v.set(part.v, 3 * offset);
+        offset += part.jd.length;
+    }
+
+    return { startJd: jd[0], stepDays: filled[0].stepDays, jd, r, v };
+}
+
+// Returns { startJd, stepDays, jd, r, v } for the grid startJd + k * stepDays up to endJd. `fetchStates(startJd,
+// endJd)` is called only for the parts no cached grid covers and must return the same shape on the same grid.
+async function getEphemeris(request, fetchStates) {
+    await ensureIndex();
+
+    const { startJd, endJd, stepDays } = request;
+    const key = cacheKey(request);
+    const count = Math.floor((endJd - startJd) / stepDays + ALIGNMENT_TOLERANCE) + 1;
+    const requestEndJd = startJd + stepDays * (count - 1);
+
+    const candidates = (index.get(key) || []).filter(entry => isAligned(entry, startJd));
+
+    const covering = candidates.find(entry =>
+        stepOffset(entry, startJd) > -ALIGNMENT_TOLERANCE && stepOffset(entry, requestEndJd) < entry.count - 1 + ALIGNMENT_TOLERANCE);
+    if (covering) {
+        return readSlice(covering, Math.round(stepOffset(covering, startJd)), count);
+    }
+
+    // extend an overlapping or adjacent grid instead of fetching the whole range again
+    const overlapping = candidates.find(entry =>
+        stepOffset(entry, requestEndJd) >= -1 - ALIGNMENT_TOLERANCE &&
+        stepOffset(entry, startJd) <= entry.count + ALIGNMENT_TOLERANCE);
+
+    let states;
+    if (overlapping) {
+        const cached = await readSlice(overlapping, 0, overlapping.count);
+        const head = startJd < overlapping.startJd - ALIGNMENT_TOLERANCE * stepDays
+            ? await fetchStates(startJd, overlapping.startJd - stepDays) : null;
+        const tail = requestEndJd > entryEndJd(overlapping) + ALIGNMENT_TOLERANCE * stepDays
+            ? await fetchStates(entryEndJd(overlapping) + stepDays, requestEndJd) : null;
+
+        states = concatenate([head, cached, tail]);
+    } else {
+        states = await fetchStates(startJd, requestEndJd);
+    }
+
+    // a short Horizons table is not cached, so the next request fetches it again
+    const first = states && states.jd.length > 0 ? Math.round((startJd - states.startJd) / stepDays) : -1;
+    if (first < 0 || first + count > states.jd.length || !isContiguous(states)) {
+        throw new Error('Horizons returned fewer samples than requested');
+    }
+
+    const entry = await store(key, states, overlapping || null);
+    return readSlice(entry, first, count);
+}
+
+module.exports = { getEphemeris, encode, HEADER_BYTES };
@@ -0,0 +1,80 @@
+const {spawn} = require('child_process');
+const fs = require('fs');
+const path = require('path');
+const {encode} = require('./ephemerisCache');
+const {ResultCache} = require('./resultCache');
+
+// Server-side porkchop solves through the native `porkchop` executable (src/cpp/porkchop_cli.cpp), for grids
+// too large for the browser module. Optional: without the executable, isAvailable() is false and the route
+// answers 503 so the client stays on WASM.
+
+const porkchopBin = process.env.PORKCHOP_BIN || path.join(__dirname, '../../../build/porkchop');
+const resultCache = new ResultCache({
+    directory: process.env.RESULT_CACHE_DIR || path.join(__dirname, '../../../cache/results'),
+    maxBytes: parseInt(process.env.RESULT_CACHE_BYTES || `${512 * 1024 * 1024}`, 10)
+});
+
+// Bump when solver output changes, so cached grids are not reused.
+const RESULT_CACHE_VERSION = 2;
+
+let available = null;
+
+async function isAvailable() {
+    if (available === null) {
+        available = await fs.promises.access(porkchopBin, fs.constants.X_OK).then(() => true, () => false);
+    }
+    return available;
+}
+
+function runPorkchop(departure, arrival, params, timeoutMs) {
+    const args = [
+        '--mu', String(params.mu),
+        '--departure-mu', String(params.departurePlanetMu),
+        '--arrival-mu', String(params.arrivalPlanetMu),
+        '--departure-radius', String(params.departureOrbitRadius),
+        '--arrival-radius', String(params.arrivalOrbitRadius)
+    ];
+    if (params.float32) args.push('--float32');
+    if (params.precision && params.precision !== 'double') args.push('--precision', params.precision);
+    if (params.solver && params.solver !== 'battin') args.push('--solver', params.solver);
+
+    return new Promise((resolve, reject) => {
+        const child = spawn(porkchopBin, args, {stdio: ['pipe', 'pipe', 'pipe']});
+        const output = [];
+        let errors = '';
+
+        const timer = setTimeout(() => child.kill('SIGKILL'), timeoutMs);
+
+        child.stdout.on('data', chunk => output.push(chunk));
+        child.stderr.on('data', chunk => errors += chunk);
+        child.on('error', error => {
+            clearTimeout(timer);
+            reject(error);
+        });
+        child.on('close', (code, signal) => {
+            clearTimeout(timer);
+            if (code === 0) {
+                resolve(Buffer.concat(output));
+            } else {
+                reject(new Error(`porkchop exited with ${signal || code}: ${errors.trim()}`));
+            }
+        });
+
+        child.stdin.on('error', () => {});
+        child.stdin.write(encode(departure));
+        child.stdin.end(encode(arrival));
+    });
+}
+
+// Grid in the PKCH format of src/cpp/porkchop_io.h for two ephemeris tables ({startJd, stepDays, jd, r, v}),
+// cached by request and shared between identical concurrent requests.
+async function computePorkchop(request, loadStates, params, {timeoutMs = 120000} = {}) {
+    const key = ResultCache.key({version: RESULT_CACHE_VERSION, request, params});
+
+    return resultCache.getOrCompute(key, async () => {
+        const [departure, arrival] = await loadStates();
+        return runPorkchop(departure, arrival, params, timeoutMs);
+    });
+}
+
+module.exports = {isAvailable, computePorkchop};
@@ -0,0 +1,150 @@
+const crypto = require('crypto');
+const fs = require('fs');
+const path = require('path');
+
+// Content-addressed cache of porkchop results. Values are Buffers keyed by a hash of the request inputs.
+// Recently used results stay in memory up to maxBytes; evicted ones spill to disk (up to maxDiskBytes, oldest
+// files removed first) and are promoted back on the next hit. Concurrent getOrCompute calls for the same key
+// share one computation.
+
+function canonicalJson(value) {
+    if (Array.isArray(value)) {
+        return `[${value.map(canonicalJson).join(',')}]`;
+    }
+    if (value && typeof value === 'object') {
+        return `{${Object.keys(value).sort().map(key => `${JSON.stringify(key)}:${canonicalJson(value[key])}`).join(',')}}`;
+    }
+    return JSON.stringify(value);
+}
+
+class ResultCache {
+    constructor({directory, maxBytes = 256 * 1024 * 1024, maxDiskBytes = 2 * 1024 * 1024 * 1024} = {}) {
+        this.directory = directory;
+        this.maxBytes = maxBytes;
+        this.maxDiskBytes = maxDiskBytes;
+
+        this.memory = new Map();    // insertion order is recency order
+        this.memoryBytes = 0;
+        this.pending = new Map();
+
+        this.stats = {memoryHits: 0, diskHits: 0, misses: 0, coalesced: 0};
+    }
+
+    // Key of a request: SHA-256 over its inputs with object keys sorted, so property order does not matter.
+    static key(inputs) {
+        return crypto.createHash('sha256').update(canonicalJson(inputs)).digest('hex');
+    }
+
+    async get(key) {
+        const value = this.memory.get(key);
+        if (value) {
+            this.memory.delete(key);
+            this.memory.set(key, value);
+            this.stats.memoryHits++;
+            return value;
+        }
+
+        if (this.directory) {
+            try {
+                const spilled = await fs.promises.readFile(this._file(key));
+                this.stats.diskHits++;
+                this._remember(key, spilled);
+                return spilled;
+            } catch (error) {
+                if (error.code !== 'ENOENT') throw error;
+            }
+        }
+
+        return null;
+    }
+
+    set(key, value) {
+        this._remember(key, value);
+    }
+
+    async getOrCompute(key, compute) {
+        const cached = await this.get(key);
+        if (cached) return cached;
+
+        const inFlight = this.pending.get(key);
+        if (inFlight) {
+            this.stats.coalesced++;
+            return inFlight;
+        }
+
+        this.stats.misses++;
+        const computation = (async () => {
+            try {
+                const value = await compute();
+                this._remember(key, value);
+                return value;
+            } finally {
+                this.pending.delete(key);
+            }
+        })();
+
+        this.pending.set(key, computation);
+        return computation;
+    }
+
+    _file(key) {
+        return path.join(this.directory, `${key}.bin`);
+    }
+
+    _remember(key, value) {
+        const previous = this.memory.get(key);
+        if (previous) {
+            this.memoryBytes -= previous.length;
+            this.memory.delete(key);
+        }
+
+        this.memory.set(key, value);
+        this.memoryBytes += value.length;
+
+        while (this.memoryBytes > this.maxBytes && this.memory.size > 1) {
+            const [evictedKey, evicted] = this.memory.entries().next().value;
+            this.memory.delete(evictedKey);
+            this.memoryBytes -= evicted.length;
+            this._spill(evictedKey, evicted);
+        }
+    }
+
+    _spill(key, value) {
+        if (!this.directory) return;
+
+        const spill = async () => {
+            await fs.promises.mkdir(this.directory, {recursive: true});
+
+            const file = this._file(key);
+            const exists = await fs.promises.access(file).then(() => true, () => false);
+            if (!exists) {
+                const temporary = `${file}.${process.pid}.tmp`;
+                await fs.promises.writeFile(temporary, value);
+                await fs.promises.rename(temporary, file);
+            }
+
+            await this._trimDisk();
+        };
+
+        spill().catch(error => console.error('Result cache spill failed:', error.message));
+    }
+
+    async _trimDisk() {
+        const names = (await fs.promises.readdir(this.directory)).filter(name => name.endsWith('.bin'));
+        const files = await Promise.all(names.map(async name => {
+            const stat = await fs.promises.stat(path.join(this.directory, name));
+            return {name, size: stat.size, mtime: stat.mtimeMs};
+        }));
+
+        let total = files.reduce((sum, file) => sum + file.size, 0);
+        files.sort((a, b) => a.mtime - b.mtime);
+
+        for (const file of files) {
+            if (total <= this.maxDiskBytes) break;
+            await fs.promises.unlink(path.join(this.directory, file.name)).catch(() => {});
+            total -= file.size;
+        }
+    }
+}
+
+module.exports = {ResultCache, canonicalJson};
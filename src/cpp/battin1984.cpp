@@ -1,44 +1,71 @@
+#include <algorithm>
 #include <cmath>
 #include "battin1984.h"
+#include "lambert_solver.h"
+#include "porkchop_metrics.h"
 #include <iostream>
 #include <vector>
 
 #ifdef EMSCRIPTEN
 
-#include <wasm_simd128.h>
 #include <emscripten/bind.h>
 #include <emscripten/val.h>
+#include <memory>
+#include "porkchop_stream.h"
+#include "porkchop_optimum.h"
+#include "porkchop_contour.h"
+#include "ephemeris.h"
+
+#ifdef LAMBERT_WASM_THREADS
+#include "porkchop_engine.h"
+#include <thread>
+#endif
 
 #endif
 
-double getTransferAngle(vec3d &r1, vec3d &r2, bool prograde, bool shortPath)
+TransferGeometry getTransferGeometry(vec3d &r1, vec3d &r2, double r1_norm)
 {
+    TransferGeometry g;
+    g.r1_norm = r1_norm;
+    g.r2_norm = r2.norm();
+    g.c_norm = (r2 - r1).norm();
+    g.semiperimeter = (g.r1_norm + g.r2_norm + g.c_norm) / 2.0;
+
     vec3d cross = r1.cross(r2);
-    if (cross.isZero(tol))
+    g.degenerate = cross.isZero(tol);
+    if (g.degenerate)
     {
-        return (r1.dot(r2) >= 0) ? 0 : M_PI;
+        g.alpha = 0;
+        g.theta0 = (r1.dot(r2) >= 0) ? 0 : M_PI;
+        return g;
     }
 
     vec3d h = cross.normalized();
+    g.alpha = vec3d(0, 0, 1).dot(h);
 
-    double alpha = vec3d(0, 0, 1).dot(h);
-    double r1_norm = r1.norm();
-    double r2_norm = r2.norm();
-
-    double cosTheta = r1.dot(r2) / (r1_norm * r2_norm);
+    double cosTheta = r1.dot(r2) / (g.r1_norm * g.r2_norm);
     cosTheta = std::clamp(cosTheta, -1.0, 1.0);
-    double theta0 = std::acos(cosTheta);
+    g.theta0 = std::acos(cosTheta);
+
+    return g;
+}
 
+double getTransferAngle(const TransferGeometry &g, bool prograde, bool shortPath)
+{
+    if (g.degenerate)
+    {
+        return g.theta0;
+    }
 
     double dTheta;
 
     if (prograde)
     {
-        dTheta = (alpha > 0) ? theta0 : (2 * M_PI - theta0);
+        dTheta = (g.alpha > 0) ? g.theta0 : (2 * M_PI - g.theta0);
     }
     else
     {
-        dTheta = (alpha < 0) ? theta0 : (2 * M_PI - theta0);
+        dTheta = (g.alpha < 0) ? g.theta0 : (2 * M_PI - g.theta0);
     }
 
     if (shortPath)
@@ -75,32 +102,26 @@ double getM(double mu, double tof, double s, double lambda)
     return m;
 }
 
-double xiAtX(double x, int levels = 125)
+double xiAtX(double x, int fixedDepth = 0, double tailTol = 1e-18)
 {
     double eta = x / std::pow(sqrt(1. + x) + 1., 2.);
-    double delta = 0., u = 1., sigma = 1., m1 = 1.;
+    double sigma = evaluateContinuedFraction(XI_GAMMA.data(), XI_LEVELS, eta, fixedDepth, tailTol);
 
-    double gamma;
-
-    while (u > 1e-18 && m1 <= levels)
-    {
-        m1 += 1;
-        gamma = std::pow(m1 + 3., 2.) / (4. * std::pow(m1 + 3., 2.) - 1.);
-        delta = 1. / (1. + gamma * eta * delta);
-        u = u * (delta - 1.);
-        sigma = sigma + u;
-    }
+#ifdef LAMBERT_INSTRUMENT
+    SolveTrace &trace = solveTrace();
+    trace.xi_depth = std::max(trace.xi_depth, trace.last_cf_depth);
+#endif
 
     double xi = 8. * (sqrt(1. + x) + 1.) / (3. + 1. / (5. + eta + (9. * eta / 7.) * sigma));
     return xi;
 }
 
-std::tuple<double, double> getH(double x, double l1, double m)
+std::tuple<double, double> getH(double x, double l1, double m, const ContinuedFractionDepth &depth = {0, 0, 1e-18})
 {
-    double xi = xiAtX(x);
+    double xi = xiAtX(x, depth.xi, depth.tail_tol);
     double hDenom = (1. + 2. * x + l1) * (4. * x + xi * (3. + x));
 
-    double h1 = (std::pow(l1 + x, 2) * (1. + .3 * x + xi)) / hDenom;
+    double h1 = (std::pow(l1 + x, 2) * (1. + 3. * x + xi)) / hDenom;
     double h2 = (m * (x - l1 + xi)) / hDenom;
 
     return std::make_tuple(h1, h2);
@@ -108,13 +129,13 @@ std::tuple<double, double> getH(double x, double l1, double m)
 
 double uAtB(double B)
 {
-    double u = -B / (2. * sqrt(1. + B) + 1.);
+    double u = -B / (2. * (sqrt(1. + B) + 1.));
     return u;
 }
 
 double BAtH(double h1, double h2)
 {
-    double B = (27. * h2) / (4. + pow(1. + h1, 3.));
+    double B = (27. * h2) / (4. * pow(1. + h1, 3.));
     return B;
 }
 
@@ -124,47 +145,14 @@ double uAtH(double h1, double h2)
     return u;
 }
 
-double KAtu(double u, int levels = 1000)
+double KAtu(double u, int fixedDepth = 0, double tailTol = 1e-18)
 {
-    double delta = 1, u0 = 1, sigma = 1, n1 = 0;
-
-    while (std::abs(u0) > 1e-18 && n1 <= levels)
-    {
-        if (n1 == 0)
-        {
-            double gamma = 4. / 27.;
-            delta = 1. / (1 - gamma * u * delta);
-            u0 = u0 * (delta - 1.);
-            sigma = sigma + u0;
-        }
-        else
-        {
-            for (int val: {1, 2})
-            {
-                double gamma;
-                if (val == 1)
-                {
-                    gamma = (2.0
-                             * (3. * n1 + 1)
-                             * (6. * n1 - 1)
-                             / (9.0 * (4 * n1 - 1) * (4 * n1 + 1)));
-                }
-                else
-                {
-                    gamma = (2.0
-                             * (3. * n1 + 2)
-                             * (6. * n1 + 1)
-                             / (9.0 * (4 * n1 - 1) * (4 * n1 + 1)));
-                }
-
-                delta = 1.0 / (1.0 - gamma * u * delta);
-                u0 = u0 * (delta - 1.0);
-                sigma = sigma + u0;
-            }
-        }
+    double sigma = evaluateContinuedFraction(K_GAMMA.data(), K_LEVELS, -u, fixedDepth, tailTol);
 
-        ++n1;
-    }
+#ifdef LAMBERT_INSTRUMENT
+    SolveTrace &trace = solveTrace();
+    trace.k_depth = std::max(trace.k_depth, trace.last_cf_depth);
+#endif
 
     double K = std::pow(sigma / 3.0, 2);
     return K;
@@ -176,92 +164,213 @@ double battinFirstEq(double y, double l1, double m)
     return x;
 }
 
-double battinSecondEq(double u, double h1, double h2)
+double battinSecondEq(double u, double h1, double h2, const ContinuedFractionDepth &depth = {0, 0, 1e-18})
 {
     double B = BAtH(h1, h2);
-    double K = KAtu(u);
+    double K = KAtu(u, depth.k, depth.tail_tol);
 
     double y = ((1. + h1) / 3.0) * (2. + std::sqrt(B + 1) / (1. - 2. * u * K));
     return y;
 }
 
-std::tuple<vec3d, vec3d> battin1984(double mu, vec3d &r1, vec3d &r2, double tof,
-                                    bool prograde, bool shortPath, int maxIter, double atol, int nRev)
+BattinParameters getBattinParameters(double mu, const TransferGeometry &g, double tof,
+                                     bool prograde, bool shortPath, int nRev)
 {
-    double r1_norm = r1.norm();
-    double r2_norm = r2.norm();
-    double c_norm = (r2 - r1).norm();
-
-    double semiperimeter = (r1_norm + r2_norm + c_norm) / 2.0;
-    double dtheta = getTransferAngle(r1, r2, prograde, shortPath);
+    double dtheta = getTransferAngle(g, prograde, shortPath);
     if (nRev > 0)
     {
         dtheta += 2 * M_PI * nRev;
     }
 
-    double lambda = getLambda(c_norm, semiperimeter, dtheta);
+    BattinParameters p;
+    p.semiperimeter = g.semiperimeter;
+    p.lambda = getLambda(g.c_norm, g.semiperimeter, dtheta);
 
-    double l1 = getL1(lambda);
-    double m = getM(mu, tof, semiperimeter, lambda);
+    p.l1 = getL1(p.lambda);
+    p.m = getM(mu, tof, g.semiperimeter, p.lambda);
 
-    double T = std::sqrt(8. * mu / std::pow(semiperimeter, 3)) * tof;
-    double Tp = (4. / 3.) * (1 - std::pow(lambda, 3));
+    double T = std::sqrt(8. * mu / std::pow(g.semiperimeter, 3)) * tof;
+    double Tp = (4. / 3.) * (1 - std::pow(p.lambda, 3));
 
-    double x0 = (T > Tp) ? l1 : 0;
+    p.x0 = (T > Tp) ? p.l1 : 0;
 
-    double x, y;
+    return p;
+}
+
+BattinParameters getBattinParameters(double mu, vec3d &r1, vec3d &r2, double tof,
+                                     bool prograde, bool shortPath, int nRev)
+{
+    TransferGeometry g = getTransferGeometry(r1, r2, r1.norm());
+    return getBattinParameters(mu, g, tof, prograde, shortPath, nRev);
+}
+
+std::tuple<vec3d, vec3d> battinVelocities(const BattinParameters &p, const TransferGeometry &g,
+                                          vec3d &r1, vec3d &r2, double tof, double x, double y)
+{
+    double r11 = std::pow(1 + p.lambda, 2) / (4 * tof * p.lambda);
+    double s11 = y * (1 + x);
+    double t11 = (p.m * p.semiperimeter * std::pow(1 + p.lambda, 2)) / s11;
+
+    vec3d v1 = -r11 * (s11 * (r1 - r2) - t11 * r1 / g.r1_norm);
+    vec3d v2 = -r11 * (s11 * (r1 - r2) + t11 * r2 / g.r2_norm);
+
+    auto ret = std::tuple<vec3d, vec3d>(v1, v2);
+    return ret;
+}
+
+int battinIterate(double l1, double m, double x0, int maxIter, double atol,
+                  const ContinuedFractionDepth &depth, double &x, double &y, bool *converged_out)
+{
+    int i = 0;
+    bool converged = false;
+    x = x0;
+    y = 0;
 
-    for (int i = 0; i < maxIter; ++i)
+    while (i < maxIter)
     {
-        auto [h1, h2] = getH(x0, l1, m);
+        auto [h1, h2] = getH(x0, l1, m, depth);
 
         double u = uAtH(h1, h2);
-        y = battinSecondEq(u, h1, h2);
+        y = battinSecondEq(u, h1, h2, depth);
         x = battinFirstEq(y, l1, m);
+        ++i;
 
         if (std::abs(x - x0) <= atol)
         {
+            converged = true;
             break;
         }
         else
             x0 = x;
     }
 
-    double r11 = std::pow(1 + lambda, 2) / (4 * tof * lambda);
-    double s11 = y * (1 + x);
-    double t11 = (m * semiperimeter * std::pow(1 + lambda, 2)) / s11;
+#ifdef LAMBERT_INSTRUMENT
+    SolveTrace &trace = solveTrace();
+    ++trace.solves;
+    trace.iterations += i;
+    trace.not_converged += !converged;
+#endif
 
-    vec3d v1 = -r11 * (s11 * (r1 - r2) - t11 * r1 / r1_norm);
-    vec3d v2 = -r11 * (s11 * (r1 - r2) + t11 * r2 / r2_norm);
+    if (converged_out)
+        *converged_out = converged;
+    return i;
+}
 
-    auto ret = std::tuple<vec3d, vec3d>(v1, v2);
-    return ret;
+std::tuple<vec3d, vec3d> battin1984(double mu, vec3d &r1, vec3d &r2, double tof,
+                                    bool prograde, bool shortPath, int maxIter, double atol, int nRev,
+                                    ContinuedFractionMode cfMode)
+{
+    TransferGeometry g = getTransferGeometry(r1, r2, r1.norm());
+    BattinParameters p = getBattinParameters(mu, g, tof, prograde, shortPath, nRev);
+
+    double x, y;
+    battinIterate(p.l1, p.m, p.x0, maxIter, atol, continuedFractionDepth(cfMode, atol), x, y);
+
+    return battinVelocities(p, g, r1, r2, tof, x, y);
 }
 
-double julianDateToSeconds(double julianDate)
+IterationStats &IterationStats::operator+=(const IterationStats &other)
 {
-    const double SECONDS_PER_DAY = 86400.0;
-    return (julianDate - 2451545.0) * SECONDS_PER_DAY;
+    solves += other.solves;
+    iterations += other.iterations;
+    cold_iterations += other.cold_iterations;
+    warm_starts += other.warm_starts;
+    fallbacks += other.fallbacks;
+    return *this;
 }
 
-#ifdef EMSCRIPTEN
+void WarmSeed::push(double x)
+{
+    if (std::isfinite(x))
+    {
+        x_prev = x_last;
+        x_last = x;
+    }
+    else
+        *this = WarmSeed();
+}
 
-v128_t julianDateToSeconds_simd(v128_t julianDates)
+// Iterates from the predicted seed when there is one; a seed that does not converge within maxIter falls
+// back to the cold x0.
+static void battinIterateSeeded(const BattinParameters &p, WarmSeed *seed, int maxIter, double atol,
+                                const ContinuedFractionDepth &depth, IterationStats *stats, double &x, double &y)
 {
-    const double JULIAN_EPOCH = 2451545.0;
-    const double SECONDS_PER_DAY = 86400.0;
+    int iterations = 0;
+    bool warm = seed && std::isfinite(seed->x_last);
 
-    v128_t epoch = wasm_f64x2_splat(JULIAN_EPOCH);
-    v128_t secondsPerDay = wasm_f64x2_splat(SECONDS_PER_DAY);
+    if (warm)
+    {
+        bool converged;
+        iterations = battinIterate(p.l1, p.m, seed->predict(), maxIter, atol, depth, x, y, &converged);
+        if (!converged || !std::isfinite(x))
+        {
+            warm = false;
+            if (stats)
+                ++stats->fallbacks;
+        }
+    }
 
-    // (julianDates - epoch) * secondsPerDay
-    v128_t delta = wasm_f64x2_sub(julianDates, epoch);
-    v128_t result = wasm_f64x2_mul(delta, secondsPerDay);
+    if (!warm)
+        iterations += battinIterate(p.l1, p.m, p.x0, maxIter, atol, depth, x, y);
 
-    return result;
-}
+    if (seed)
+        seed->push(x);
+
+    if (stats)
+    {
+        ++stats->solves;
+        stats->iterations += iterations;
+        if (warm)
+        {
+            double x_cold, y_cold;
+            ++stats->warm_starts;
 
+#ifdef LAMBERT_INSTRUMENT
+            // the comparison solve is not part of the cell's trace
+            SolveTrace saved = solveTrace();
+#endif
+            stats->cold_iterations += battinIterate(p.l1, p.m, p.x0, maxIter, atol, depth, x_cold, y_cold);
+#ifdef LAMBERT_INSTRUMENT
+            solveTrace() = saved;
 #endif
+        }
+        else
+            stats->cold_iterations += iterations;
+    }
+}
+
+LambertBranches battin1984Branches(double mu, const TransferGeometry &g, vec3d &r1, vec3d &r2, double tof,
+                                   bool prograde, int maxIter, double atol, ContinuedFractionMode cfMode,
+                                   WarmStart *warm, IterationStats *stats)
+{
+    ContinuedFractionDepth depth = continuedFractionDepth(cfMode, atol);
+    LambertBranches branches;
+
+    double x, y;
+
+    BattinParameters p_short = getBattinParameters(mu, g, tof, prograde, true);
+    battinIterateSeeded(p_short, warm ? &warm->short_path : nullptr, maxIter, atol, depth, stats, x, y);
+    std::tie(branches.v1_short, branches.v2_short) = battinVelocities(p_short, g, r1, r2, tof, x, y);
+
+    BattinParameters p_long = getBattinParameters(mu, g, tof, prograde, false);
+    battinIterateSeeded(p_long, warm ? &warm->long_path : nullptr, maxIter, atol, depth, stats, x, y);
+    std::tie(branches.v1_long, branches.v2_long) = battinVelocities(p_long, g, r1, r2, tof, x, y);
+
+    return branches;
+}
+
+LambertBranches battin1984Branches(double mu, vec3d &r1, vec3d &r2, double tof,
+                                   bool prograde, int maxIter, double atol, ContinuedFractionMode cfMode)
+{
+    TransferGeometry g = getTransferGeometry(r1, r2, r1.norm());
+    return battin1984Branches(mu, g, r1, r2, tof, prograde, maxIter, atol, cfMode);
+}
+
+double julianDateToSeconds(double julianDate)
+{
+    const double SECONDS_PER_DAY = 86400.0;
+    return (julianDate - 2451545.0) * SECONDS_PER_DAY;
+}
 
 #ifdef EMSCRIPTEN
 
@@ -288,9 +397,71 @@ void battin1984_wrapper(double mu, const double r1[3], const double r2[3], doubl
     result[5] = v2[2];
 }
 
-#ifdef EMSCRPTEN
-EMSCRIPTEN_KEEPALIVE
-#endif
+void computePorkchopCell(double mu, vec3d &r1_departure, double r1_norm, const vec3d &v1_departure,
+                         vec3d &r2_arrival, const vec3d &v2_arrival,
+                         double departure_time, double arrival_time,
+                         double v_orbit_dep, double v_orbit_arr,
+                         double &c3, double &dv1, double &total_dv,
+                         WarmStart *warm, IterationStats *stats, LambertBackend backend)
+{
+    bool prograde = true;
+
+    c3 = INVALID_MARKER;
+    dv1 = INVALID_MARKER;
+    total_dv = INVALID_MARKER;
+
+    double tof = arrival_time - departure_time;
+
+    if (arrival_time <= departure_time || tof < MIN_TOF)
+    {
+        c3 = MAX_C3_CUTOFF;
+        dv1 = MAX_DV_CUTOFF;
+        total_dv = MAX_DV_CUTOFF;
+        return;
+    }
+
+    if (tof < 86400.0)
+        return;
+
+
+    double best_total_dv = std::numeric_limits<double>::infinity();
+    double best_dv1 = MAX_DV_CUTOFF;
+    double best_c3 = MAX_C3_CUTOFF;
+
+    TransferGeometry geometry = getTransferGeometry(r1_departure, r2_arrival, r1_norm);
+    LambertBranches branches = lambertBranches(backend, mu, geometry, r1_departure, r2_arrival, tof, prograde,
+                                               warm, stats);
+
+    for (bool shortPath: {true, false})
+    {
+        const vec3d &v1_transfer = shortPath ? branches.v1_short : branches.v1_long;
+        const vec3d &v2_transfer = shortPath ? branches.v2_short : branches.v2_long;
+
+        vec3d v_inf_departure = v1_transfer - v1_departure;
+        vec3d v_inf_arrival = v2_arrival - v2_transfer;
+
+        double c3_departure = std::pow(v_inf_departure.norm(), 2);
+        double c3_clamped = std::min(c3_departure, MAX_C3_CUTOFF);
+
+        double dv1_candidate = std::sqrt(2 * v_orbit_dep * v_orbit_dep + c3_clamped) - v_orbit_dep;
+
+        double c3_arrival = std::pow(v_inf_arrival.norm(), 2);
+        double dv2 = std::sqrt(2 * v_orbit_arr * v_orbit_arr + c3_arrival) - v_orbit_arr;
+
+        double total_dv_candidate = dv1_candidate + dv2;
+
+        if (total_dv_candidate < best_total_dv)
+        {
+            best_total_dv = total_dv_candidate;
+            best_dv1 = dv1_candidate;
+            best_c3 = c3_clamped;
+        }
+    }
+
+    c3 = std::min(best_c3, MAX_C3_CUTOFF);
+    dv1 = std::min(best_dv1, MAX_DV_CUTOFF);
+    total_dv = std::min(best_total_dv, MAX_DV_CUTOFF);
+}
 
 void computePorkchopPlot(
         double mu,
@@ -311,13 +482,15 @@ void computePorkchopPlot(
         double *result_total_dv
 )
 {
-    bool prograde = true;
+    double v_orbit_dep = std::sqrt(departure_planet_mu / departure_orbit_radius);
+    double v_orbit_arr = std::sqrt(arrival_planet_mu / arrival_orbit_radius);
 
     for (int i = 0; i < num_departure_dates; ++i)
     {
         double departure_time = julianDateToSeconds(d1[i]);
         vec3d r1_departure = {r1[i * 3], r1[i * 3 + 1], r1[i * 3 + 2]};
         vec3d v1_departure = {v1[i * 3], v1[i * 3 + 1], v1[i * 3 + 2]};
+        double r1_norm = r1_departure.norm();
 
         for (int j = 0; j < num_arrival_dates; ++j)
         {
@@ -327,325 +500,507 @@ void computePorkchopPlot(
 
             int index = i * num_arrival_dates + j;
 
-            result_c3[index] = INVALID_MARKER;
-            result_dv1[index] = INVALID_MARKER;
-            result_total_dv[index] = INVALID_MARKER;
+            computePorkchopCell(mu, r1_departure, r1_norm, v1_departure, r2_arrival, v2_arrival,
+                                departure_time, arrival_time, v_orbit_dep, v_orbit_arr,
+                                result_c3[index], result_dv1[index], result_total_dv[index]);
+        }
+    }
+}
+
+void computePorkchopPlot_SIMD(
+        double mu,
+        const double *r1,
+        const double *v1,
+        const double *r2,
+        const double *v2,
+        const double *d1,
+        const double *d2,
+        int num_departure_dates,
+        int num_arrival_dates,
+        double departure_planet_mu,
+        double arrival_planet_mu,
+        double departure_orbit_radius,
+        double arrival_orbit_radius,
+        double *result_c3,
+        double *result_dv1,
+        double *result_total_dv
+)
+{
+    const MetricOutput outputs[] = {
+            {METRIC_C3, METRIC_FLOAT64, result_c3},
+            {METRIC_DV1, METRIC_FLOAT64, result_dv1},
+            {METRIC_TOTAL_DV, METRIC_FLOAT64, result_total_dv}
+    };
+
+    computePorkchopMetrics(mu, r1, v1, r2, v2, d1, d2, num_departure_dates, num_arrival_dates,
+                           departure_planet_mu, arrival_planet_mu, departure_orbit_radius, arrival_orbit_radius,
+                           outputs, 3);
+}
 
-            double tof = arrival_time - departure_time;
+#ifdef EMSCRIPTEN
+
+EMSCRIPTEN_KEEPALIVE
+std::vector<double> computePorkchopPlotWrapper(
+        double mu,
+        const emscripten::val &r1_js,
+        const emscripten::val &v1_js,
+        const emscripten::val &r2_js,
+        const emscripten::val &v2_js,
+        const emscripten::val &d1_js,
+        const emscripten::val &d2_js,
+        int num_departure_dates,
+        int num_arrival_dates,
+        double departure_planet_mu,
+        double arrival_planet_mu,
+        double departure_orbit_radius,
+        double arrival_orbit_radius
+)
+{
+    std::vector<double> r1 = emscripten::vecFromJSArray<double>(r1_js);
+    std::vector<double> v1 = emscripten::vecFromJSArray<double>(v1_js);
+    std::vector<double> r2 = emscripten::vecFromJSArray<double>(r2_js);
+    std::vector<double> v2 = emscripten::vecFromJSArray<double>(v2_js);
+    std::vector<double> d1 = emscripten::vecFromJSArray<double>(d1_js);
+    std::vector<double> d2 = emscripten::vecFromJSArray<double>(d2_js);
 
-            if (arrival_time <= departure_time || tof < MIN_TOF)
-            {
-                result_c3[index] = MAX_C3_CUTOFF;
-                result_dv1[index] = MAX_DV_CUTOFF;
-                result_total_dv[index] = MAX_DV_CUTOFF;
-                continue;
-            }
+    int total_results = num_departure_dates * num_arrival_dates;
+    std::vector<double> result_c3(total_results);
+    std::vector<double> result_dv1(total_results);
+    std::vector<double> result_total_dv(total_results);
 
-            if (tof < 86400.0)
-                continue;
 
+    auto start = std::chrono::high_resolution_clock::now();
 
-            double best_total_dv = std::numeric_limits<double>::infinity();
-            double best_dv1 = MAX_DV_CUTOFF;
-            double best_c3 = MAX_C3_CUTOFF;
+    computePorkchopPlot_SIMD(mu, r1.data(), v1.data(), r2.data(), v2.data(), d1.data(), d2.data(),
+                             num_departure_dates, num_arrival_dates, departure_planet_mu, arrival_planet_mu,
+                             departure_orbit_radius, arrival_orbit_radius,
+                             result_c3.data(), result_dv1.data(), result_total_dv.data());
 
-            for (bool shortPath: {true, false})
-            {
-                auto [v1_transfer, v2_transfer] =
-                        battin1984(mu, r1_departure, r2_arrival, tof, prograde, shortPath);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> duration = end - start;
 
-                vec3d v_inf_departure = v1_transfer - v1_departure;
-                vec3d v_inf_arrival = v2_arrival - v2_transfer;
+    std::cout << "Execution time: " << duration.count() << " milliseconds" << std::endl;
 
-                double c3_departure = std::pow(v_inf_departure.norm(), 2);
-                double c3_clamped = std::min(c3_departure, MAX_C3_CUTOFF);
+    std::vector<double> all_results;
+    all_results.insert(all_results.end(), result_c3.begin(), result_c3.end());
+    all_results.insert(all_results.end(), result_dv1.begin(), result_dv1.end());
+    all_results.insert(all_results.end(), result_total_dv.begin(), result_total_dv.end());
 
-                double v_orbit_dep = std::sqrt(departure_planet_mu / departure_orbit_radius);
-                double dv1 = std::sqrt(2 * v_orbit_dep * v_orbit_dep + c3_clamped) - v_orbit_dep;
+    return all_results;
+}
 
-                double c3_arrival = std::pow(v_inf_arrival.norm(), 2);
-                double v_orbit_arr = std::sqrt(arrival_planet_mu / arrival_orbit_radius);
-                double dv2 = std::sqrt(2 * v_orbit_arr * v_orbit_arr + c3_arrival) - v_orbit_arr;
+// Zero-copy interface: inputs and results live in module-owned buffers that JS reads and writes through
+// typed-array views over the wasm heap. Views stay valid until the next preparePorkchopBuffers call.
+struct PorkchopBuffers
+{
+    int num_departure_dates = 0;
+    int num_arrival_dates = 0;
 
-                double total_dv = dv1 + dv2;
+    std::vector<double> r1, v1, d1;
+    std::vector<double> r2, v2, d2;
 
-                if (total_dv < best_total_dv)
-                {
-                    best_total_dv = total_dv;
-                    best_dv1 = dv1;
-                    best_c3 = c3_clamped;
-                }
-            }
+    // result grid per metric in its requested format; empty when the last solve did not ask for it
+    std::vector<unsigned char> metrics[NUM_PORKCHOP_METRICS];
+    MetricFormat formats[NUM_PORKCHOP_METRICS] = {};
+};
 
-            result_c3[index] = std::min(best_c3, MAX_C3_CUTOFF);
-            result_dv1[index] = std::min(best_dv1, MAX_DV_CUTOFF);
-            result_total_dv[index] = std::min(best_total_dv, MAX_DV_CUTOFF);
+static PorkchopBuffers porkchop_buffers;
 
-        }
-    }
+void preparePorkchopBuffers(int num_departure_dates, int num_arrival_dates)
+{
+    PorkchopBuffers &b = porkchop_buffers;
+    b.num_departure_dates = num_departure_dates;
+    b.num_arrival_dates = num_arrival_dates;
+
+    b.r1.resize(3 * num_departure_dates);
+    b.v1.resize(3 * num_departure_dates);
+    b.d1.resize(num_departure_dates);
+    b.r2.resize(3 * num_arrival_dates);
+    b.v2.resize(3 * num_arrival_dates);
+    b.d2.resize(num_arrival_dates);
 }
 
-#ifdef EMSCRPTEN
-EMSCRIPTEN_KEEPALIVE
-#endif
-
-void computePorkchopPlot_SIMD(
-        double mu,
-        const std::vector<double> &r1,
-        const std::vector<double> &v1,
-        const std::vector<double> &r2,
-        const std::vector<double> &v2,
-        const std::vector<double> &d1,
-        const std::vector<double> &d2,
-        int num_departure_dates,
-        int num_arrival_dates,
-        double departure_planet_mu,
-        double arrival_planet_mu,
-        double departure_orbit_radius,
-        double arrival_orbit_radius,
-        std::vector<double> &result_c3,
-        std::vector<double> &result_dv1,
-        std::vector<double> &result_total_dv
-)
+// Fills the input buffers from the analytic mean-element ephemeris instead of sampled tables; dates are in
+// JD and steps in days, as dateRange counts them. Returns false when either body is not a tabulated planet.
+bool preparePorkchopBodies(double mu, int departure_body, double departure_start_jd, double departure_end_jd,
+                           double departure_step_days, int arrival_body, double arrival_start_jd,
+                           double arrival_end_jd, double arrival_step_days)
 {
-    bool prograde = true;
+    const MeanElements *departure_elements = planetMeanElements(departure_body);
+    const MeanElements *arrival_elements = planetMeanElements(arrival_body);
+    if (!departure_elements || !arrival_elements)
+        return false;
+
+    DateRange departure_dates = dateRange(departure_start_jd, departure_end_jd, departure_step_days);
+    DateRange arrival_dates = dateRange(arrival_start_jd, arrival_end_jd, arrival_step_days);
+
+    preparePorkchopBuffers(departure_dates.count, arrival_dates.count);
+
+    PorkchopBuffers &b = porkchop_buffers;
+    sampleEphemeris(MeanElementsEphemeris(*departure_elements, mu), departure_dates,
+                    b.d1.data(), b.r1.data(), b.v1.data());
+    sampleEphemeris(MeanElementsEphemeris(*arrival_elements, mu), arrival_dates,
+                    b.d2.data(), b.r2.data(), b.v2.data());
+    return true;
+}
 
-    const v128_t v_max_c3_cutoff = wasm_f64x2_splat(MAX_DV_CUTOFF);
-    const v128_t v_max_dv_cutoff = wasm_f64x2_splat(MAX_DV_CUTOFF);
-    const v128_t v_min_tof = wasm_f64x2_splat(MIN_TOF);
-    const v128_t v_zero = wasm_f64x2_splat(0.0);
-    const v128_t v_two = wasm_f64x2_splat(2.0);
-    const v128_t v_inf = wasm_f64x2_splat(std::numeric_limits<double>::infinity());
+template<typename T>
+emscripten::val heapView(std::vector<T> &buffer)
+{
+    return emscripten::val(emscripten::typed_memory_view(buffer.size(), buffer.data()));
+}
 
-    const double v_orbit_dep_sq = departure_planet_mu / departure_orbit_radius;
-    const double v_orbit_arr_sq = arrival_planet_mu / arrival_orbit_radius;
-    const double v_orbit_dep = std::sqrt(v_orbit_dep_sq);
-    const double v_orbit_arr = std::sqrt(v_orbit_arr_sq);
+emscripten::val departurePositionsView() { return heapView(porkchop_buffers.r1); }
+emscripten::val departureVelocitiesView() { return heapView(porkchop_buffers.v1); }
+emscripten::val departureDatesView() { return heapView(porkchop_buffers.d1); }
+emscripten::val arrivalPositionsView() { return heapView(porkchop_buffers.r2); }
+emscripten::val arrivalVelocitiesView() { return heapView(porkchop_buffers.v2); }
+emscripten::val arrivalDatesView() { return heapView(porkchop_buffers.d2); }
 
-    const v128_t v_v_orbit_dep_sq = wasm_f64x2_splat(v_orbit_dep_sq);
-    const v128_t v_v_orbit_arr_sq = wasm_f64x2_splat(v_orbit_arr_sq);
-    const v128_t v_v_orbit_dep = wasm_f64x2_splat(v_orbit_dep);
-    const v128_t v_v_orbit_arr = wasm_f64x2_splat(v_orbit_arr);
+// Sizes the grids of the requested metrics (formats[metric] >= 0) and releases all others. With fill, the grids
+// start out NaN (QUANTIZED_INVALID when quantized) so unsolved cells can be told apart.
+static std::vector<MetricOutput> allocateMetrics(const int formats[NUM_PORKCHOP_METRICS], bool fill)
+{
+    PorkchopBuffers &b = porkchop_buffers;
+    size_t total_results = static_cast<size_t>(b.num_departure_dates) * b.num_arrival_dates;
 
-    for (int i = 0; i < num_departure_dates; ++i)
+    std::vector<MetricOutput> outputs;
+    for (int metric = 0; metric < NUM_PORKCHOP_METRICS; ++metric)
     {
-        double departure_jd = d1[i];
-        double departure_time = julianDateToSeconds(departure_jd);
-        vec3d r1_departure = {r1[i * 3], r1[i * 3 + 1], r1[i * 3 + 2]};
-        vec3d v1_departure = {v1[i * 3], v1[i * 3 + 1], v1[i * 3 + 2]};
+        std::vector<unsigned char> &grid = b.metrics[metric];
+
+        if (formats[metric] < METRIC_FLOAT64 || formats[metric] > METRIC_UINT16)
+        {
+            std::vector<unsigned char>().swap(grid);
+            continue;
+        }
 
-        v128_t departure_time_v = wasm_f64x2_splat(departure_time);
+        MetricFormat format = static_cast<MetricFormat>(formats[metric]);
+        b.formats[metric] = format;
+        grid.resize(total_results * metricFormatBytes(format));
 
-        int j = 0;
-        for (; j < num_arrival_dates - 1; j += 2)
+        if (fill)
         {
-            int index0 = i * num_arrival_dates + j;
-            int index1 = index0 + 1;
+            if (format == METRIC_FLOAT64)
+                std::fill_n(reinterpret_cast<double *>(grid.data()), total_results, NAN);
+            else if (format == METRIC_FLOAT32)
+                std::fill_n(reinterpret_cast<float *>(grid.data()), total_results, NAN);
+            else
+                std::fill_n(reinterpret_cast<uint16_t *>(grid.data()), total_results, QUANTIZED_INVALID);
+        }
 
-            v128_t arrival_jd_v = wasm_v128_load(&d2[j]);
-            v128_t arrival_time_v = julianDateToSeconds_simd(arrival_jd_v);
+        outputs.push_back({static_cast<PorkchopMetric>(metric), format, grid.data()});
+    }
 
-            v128_t tof_v = wasm_f64x2_sub(arrival_time_v, departure_time_v);
+    return outputs;
+}
 
-            //-------------------------------------------------------------------------------
-            v128_t le_mask = wasm_f64x2_le(arrival_time_v, departure_time_v);
-            v128_t lt_mask = wasm_f64x2_lt(tof_v, v_min_tof);
+// JS passes one entry per PorkchopMetric: the MetricFormat to return it in, or -1 / undefined to skip it.
+static std::vector<MetricOutput> allocateMetrics(const emscripten::val &formats, bool fill)
+{
+    int requested[NUM_PORKCHOP_METRICS];
+    int length = formats["length"].as<int>();
 
-            v128_t invalid_mask = wasm_v128_or(le_mask, lt_mask);
-            //Invalid date bit mask
+    for (int metric = 0; metric < NUM_PORKCHOP_METRICS; ++metric)
+    {
+        emscripten::val format = metric < length ? formats[metric] : emscripten::val::undefined();
+        requested[metric] = format.isNumber() ? format.as<int>() : -1;
+    }
 
-            double results[2][3]; //C3, dv1, total_dv (j, j+1)
-            bool possible[2] = {true, true};
+    return allocateMetrics(requested, fill);
+}
 
-            for (int k = 0; k < 2; ++k)
-            {
-                int current_j = j + k;
-                int current_index = i * num_arrival_dates + current_j;
-                double arrival_time = (k == 0)
-                                      ? wasm_f64x2_extract_lane(arrival_time_v, 0)
-                                      : wasm_f64x2_extract_lane(arrival_time_v, 1);
-                double tof = (k == 0)
-                             ? wasm_f64x2_extract_lane(tof_v, 0)
-                             : wasm_f64x2_extract_lane(tof_v, 1);
+// The three grids of the original interface, in float64 or float32.
+static std::vector<MetricOutput> allocateLegacyMetrics(bool float32, bool fill)
+{
+    int format = float32 ? METRIC_FLOAT32 : METRIC_FLOAT64;
+    int requested[NUM_PORKCHOP_METRICS] = {format, format, -1, format, -1, -1, -1};
+    return allocateMetrics(requested, fill);
+}
 
-                if (arrival_time <= departure_time || tof < MIN_TOF)
-                {
-                    results[k][0] = MAX_C3_CUTOFF;
-                    results[k][1] = MAX_DV_CUTOFF;
-                    results[k][2] = MAX_DV_CUTOFF;
-                    possible[k] = false;
-                    continue;
-                }
+// Float64Array, Float32Array or Uint16Array over a metric grid, or null when the last solve did not produce it.
+emscripten::val porkchopMetricView(int metric)
+{
+    if (metric < 0 || metric >= NUM_PORKCHOP_METRICS || porkchop_buffers.metrics[metric].empty())
+        return emscripten::val::null();
+
+    std::vector<unsigned char> &grid = porkchop_buffers.metrics[metric];
+    MetricFormat format = porkchop_buffers.formats[metric];
+    size_t count = grid.size() / metricFormatBytes(format);
+
+    if (format == METRIC_FLOAT64)
+        return emscripten::val(emscripten::typed_memory_view(count, reinterpret_cast<double *>(grid.data())));
+    if (format == METRIC_FLOAT32)
+        return emscripten::val(emscripten::typed_memory_view(count, reinterpret_cast<float *>(grid.data())));
+    return emscripten::val(emscripten::typed_memory_view(count, reinterpret_cast<uint16_t *>(grid.data())));
+}
 
-                vec3d r2_arrival = {r2[current_j * 3 + 0], r2[current_j * 3 + 1], r2[current_j * 3 + 2]};
-                vec3d v2_arrival = {v2[current_j * 3 + 0], v2[current_j * 3 + 1], v2[current_j * 3 + 2]};
+// { min, max } of the uint16 quantization of a metric.
+emscripten::val porkchopMetricRange(int metric)
+{
+    MetricRange range = metricRange(static_cast<PorkchopMetric>(metric));
 
+    emscripten::val result = emscripten::val::object();
+    result.set("min", range.min);
+    result.set("max", range.max);
+    return result;
+}
 
-                double best_total_dv = MAX_DV_CUTOFF;
-                double best_dv1 = MAX_DV_CUTOFF;
-                double best_c3 = MAX_C3_CUTOFF;
+emscripten::val porkchopC3View() { return porkchopMetricView(METRIC_C3); }
+emscripten::val porkchopDv1View() { return porkchopMetricView(METRIC_DV1); }
+emscripten::val porkchopTotalDvView() { return porkchopMetricView(METRIC_TOTAL_DV); }
 
-                for (bool shortPath: {true, false})
-                {
-                    auto [v1_transfer, v2_transfer] =
-                            battin1984(mu, r1_departure, r2_arrival, tof, prograde, shortPath);
+// Pruning applied to the following solves, off until setPorkchopPruning.
+static PorkchopPruning porkchop_pruning;
+static bool porkchop_pruning_enabled = false;
 
-                    vec3d v_inf_departure = v1_transfer - v1_departure;
-                    vec3d v_inf_arrival = v2_arrival - v2_transfer;
+// Cells above max_total_dv (km/s) come back as PRUNED_MARKER; 0 solves every cell fully again.
+void setPorkchopPruning(double max_total_dv)
+{
+    porkchop_pruning.max_total_dv = max_total_dv;
+    porkchop_pruning_enabled = max_total_dv > 0;
+}
 
-                    double c3_departure_sq = v_inf_departure.x() * v_inf_departure.x() +
-                                             v_inf_departure.y() * v_inf_departure.y() +
-                                             v_inf_departure.z() * v_inf_departure.z();
-                    double c3_clamped = std::min(c3_departure_sq, MAX_C3_CUTOFF);
+// Kernel arithmetic of the following solves (a SolverPrecision), PRECISION_DOUBLE until setPorkchopPrecision.
+static SolverPrecision porkchop_precision = PRECISION_DOUBLE;
 
-                    double dv1 = std::sqrt(2.0 * v_orbit_dep_sq + c3_clamped) - v_orbit_dep;
+void setPorkchopPrecision(int precision)
+{
+    porkchop_precision = precision == PRECISION_MIXED || precision == PRECISION_FLOAT
+                         ? static_cast<SolverPrecision>(precision) : PRECISION_DOUBLE;
+}
 
-                    double c3_arrival_sq = v_inf_arrival.x() * v_inf_arrival.x() +
-                                           v_inf_arrival.y() * v_inf_arrival.y() +
-                                           v_inf_arrival.z() * v_inf_arrival.z();
+// Zero-revolution solver of the following solves and optimum searches (a LambertBackend), LAMBERT_BATTIN until
+// setPorkchopSolver.
+static LambertBackend porkchop_backend = LAMBERT_BATTIN;
 
-                    double dv2 = std::sqrt(2.0 * v_orbit_arr_sq + c3_arrival_sq) - v_orbit_arr;
+void setPorkchopSolver(int backend)
+{
+    porkchop_backend = backend >= LAMBERT_BATTIN && backend <= LAMBERT_AUTO
+                       ? static_cast<LambertBackend>(backend) : LAMBERT_BATTIN;
+}
 
-                    double total_dv = dv1 + dv2;
+// Solves the whole buffered grid into the given outputs. The pthreads build spreads blocks of rows over the
+// worker pool (PTHREAD_POOL_SIZE workers are spawned at startup, so the main thread never waits on worker
+// creation).
+static void solvePorkchopMetrics(double mu, double departure_planet_mu, double arrival_planet_mu,
+                                 double departure_orbit_radius, double arrival_orbit_radius,
+                                 const std::vector<MetricOutput> &outputs)
+{
+    PorkchopBuffers &b = porkchop_buffers;
+
+#ifdef LAMBERT_WASM_THREADS
+    PorkchopOptions options;
+    options.pruning = porkchop_pruning_enabled ? &porkchop_pruning : nullptr;
+    options.precision = porkchop_precision;
+    options.backend = porkchop_backend;
+    computePorkchopMetricsParallel(mu, b.r1.data(), b.v1.data(), b.r2.data(), b.v2.data(), b.d1.data(),
+                                   b.d2.data(), b.num_departure_dates, b.num_arrival_dates,
+                                   departure_planet_mu, arrival_planet_mu, departure_orbit_radius,
+                                   arrival_orbit_radius, outputs.data(), static_cast<int>(outputs.size()), options);
+#else
+    computePorkchopMetrics(mu, b.r1.data(), b.v1.data(), b.r2.data(), b.v2.data(), b.d1.data(), b.d2.data(),
+                           b.num_departure_dates, b.num_arrival_dates, departure_planet_mu, arrival_planet_mu,
+                           departure_orbit_radius, arrival_orbit_radius,
+                           outputs.data(), static_cast<int>(outputs.size()),
+                           porkchop_pruning_enabled ? &porkchop_pruning : nullptr, porkchop_precision,
+                           porkchop_backend);
+#endif
+}
 
-                    if (total_dv < best_total_dv)
-                    {
-                        best_total_dv = total_dv;
-                        best_dv1 = dv1;
-                        best_c3 = c3_clamped;
-                    }
-                }
+int porkchopThreadCount()
+{
+#ifdef LAMBERT_WASM_THREADS
+    unsigned int hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? static_cast<int>(hardware) : 1;
+#else
+    return 1;
+#endif
+}
 
-                results[k][0] = std::min(best_c3, MAX_C3_CUTOFF);
-                results[k][1] = std::min(best_dv1, MAX_DV_CUTOFF);
-                results[k][2] = std::min(best_total_dv, MAX_DV_CUTOFF);
+// Solves the grid held in the buffers into the C3, Δv1 and total Δv grids; returns the execution time in
+// milliseconds. Results are written straight in the requested precision, so float32 never allocates double grids.
+double computePorkchopPlotInPlace(double mu, double departure_planet_mu, double arrival_planet_mu,
+                                  double departure_orbit_radius, double arrival_orbit_radius, bool float32)
+{
+    std::vector<MetricOutput> outputs = allocateLegacyMetrics(float32, false);
 
-            }
+    auto start = std::chrono::high_resolution_clock::now();
 
-            v128_t result_c3_v = wasm_f64x2_make(results[0][0], results[1][0]);
-            v128_t result_dv1_v = wasm_f64x2_make(results[0][1], results[1][1]);
-            v128_t result_total_dv_v = wasm_f64x2_make(results[0][2], results[1][2]);
+    solvePorkchopMetrics(mu, departure_planet_mu, arrival_planet_mu, departure_orbit_radius, arrival_orbit_radius,
+                         outputs);
 
-            v128_t final_c3_v = wasm_v128_bitselect(v_max_c3_cutoff, result_c3_v, invalid_mask);
-            v128_t final_dv1_v = wasm_v128_bitselect(v_max_dv_cutoff, result_dv1_v, invalid_mask);
-            v128_t final_total_dv_v = wasm_v128_bitselect(v_max_dv_cutoff, result_total_dv_v, invalid_mask);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> duration = end - start;
 
-            wasm_v128_store(&result_c3[index0], final_c3_v);
-            wasm_v128_store(&result_dv1[index0], final_dv1_v);
-            wasm_v128_store(&result_total_dv[index0], final_total_dv_v);
-        }
+    return duration.count();
+}
 
-        if (j < num_arrival_dates)
-        {
-            int index = i * num_arrival_dates + j;
+// Same, for any set of metrics and formats (see allocateMetrics); metrics not asked for are neither computed nor
+// stored. Read the grids with porkchopMetricView.
+double computePorkchopMetricsInPlace(double mu, double departure_planet_mu, double arrival_planet_mu,
+                                     double departure_orbit_radius, double arrival_orbit_radius,
+                                     const emscripten::val &formats)
+{
+    std::vector<MetricOutput> outputs = allocateMetrics(formats, false);
 
-            result_c3[index] = MAX_C3_CUTOFF;
-            result_dv1[index] = MAX_DV_CUTOFF;
-            result_total_dv[index] = MAX_DV_CUTOFF;
+    auto start = std::chrono::high_resolution_clock::now();
 
-            double arrival_jd = d2[j];
-            double arrival_time_sec = julianDateToSeconds(arrival_jd);
-            double tof = arrival_time_sec - departure_time;
+    solvePorkchopMetrics(mu, departure_planet_mu, arrival_planet_mu, departure_orbit_radius, arrival_orbit_radius,
+                         outputs);
 
-            if (arrival_time_sec <= departure_time || tof < MIN_TOF)
-            {
-                continue;
-            }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> duration = end - start;
 
-            vec3d r2_arrival = {r2[j * 3 + 0], r2[j * 3 + 1], r2[j * 3 + 2]};
-            vec3d v2_arrival = {v2[j * 3 + 0], v2[j * 3 + 1], v2[j * 3 + 2]};
+    return duration.count();
+}
 
-            double best_total_dv = std::numeric_limits<double>::infinity();
-            double best_dv1 = MAX_DV_CUTOFF;
-            double best_c3 = MAX_C3_CUTOFF;
+// Streaming interface over the same buffers: startPorkchopJob sizes the result grids (filled with NaN until
+// solved), and each stepPorkchopJob call solves the next batch of departure rows so JS can draw finished rows
+// and cancel between batches.
+static std::unique_ptr<PorkchopJob> porkchop_job;
 
-            for (bool shortPath: {true, false})
-            {
-                auto [v1_transfer, v2_transfer] =
-                        battin1984(mu, r1_departure, r2_arrival, tof, prograde, shortPath);
+static void startJob(double mu, double departure_planet_mu, double arrival_planet_mu,
+                     double departure_orbit_radius, double arrival_orbit_radius,
+                     const std::vector<MetricOutput> &outputs)
+{
+    PorkchopBuffers &b = porkchop_buffers;
+
+    porkchop_job = std::make_unique<PorkchopJob>(
+            mu, b.r1.data(), b.v1.data(), b.r2.data(), b.v2.data(), b.d1.data(), b.d2.data(),
+            b.num_departure_dates, b.num_arrival_dates, departure_planet_mu, arrival_planet_mu,
+            departure_orbit_radius, arrival_orbit_radius);
+    porkchop_job->setMetricOutputs(outputs.data(), static_cast<int>(outputs.size()));
+    if (porkchop_pruning_enabled)
+        porkchop_job->setPruning(porkchop_pruning);
+    porkchop_job->setPrecision(porkchop_precision);
+    porkchop_job->setBackend(porkchop_backend);
+}
 
-                vec3d v_inf_departure = v1_transfer - v1_departure;
-                vec3d v_inf_arrival = v2_arrival - v2_transfer;
+void startPorkchopJob(double mu, double departure_planet_mu, double arrival_planet_mu,
+                      double departure_orbit_radius, double arrival_orbit_radius, bool float32)
+{
+    startJob(mu, departure_planet_mu, arrival_planet_mu, departure_orbit_radius, arrival_orbit_radius,
+             allocateLegacyMetrics(float32, true));
+}
 
-                double c3_departure_sq = v_inf_departure.x() * v_inf_departure.x() +
-                                         v_inf_departure.y() * v_inf_departure.y() +
-                                         v_inf_departure.z() * v_inf_departure.z();
-                double c3_clamped = std::min(c3_departure_sq, MAX_C3_CUTOFF);
+void startPorkchopMetricsJob(double mu, double departure_planet_mu, double arrival_planet_mu,
+                             double departure_orbit_radius, double arrival_orbit_radius,
+                             const emscripten::val &formats)
+{
+    startJob(mu, departure_planet_mu, arrival_planet_mu, departure_orbit_radius, arrival_orbit_radius,
+             allocateMetrics(formats, true));
+}
 
-                double dv1 = std::sqrt(2.0 * v_orbit_dep_sq + c3_clamped) - v_orbit_dep;
+// Returns the number of rows finished so far, or -1 when there is no job or it was cancelled.
+int stepPorkchopJob(int max_rows)
+{
+    if (!porkchop_job || porkchop_job->isCancelled())
+        return -1;
 
-                double c3_arrival_sq = v_inf_arrival.x() * v_inf_arrival.x() +
-                                       v_inf_arrival.y() * v_inf_arrival.y() +
-                                       v_inf_arrival.z() * v_inf_arrival.z();
-                double dv2 = std::sqrt(2.0 * v_orbit_arr_sq + c3_arrival_sq) - v_orbit_arr;
+    porkchop_job->step(max_rows);
+    return porkchop_job->rowsCompleted();
+}
 
-                double total_dv = dv1 + dv2;
+void cancelPorkchopJob()
+{
+    if (porkchop_job)
+        porkchop_job->cancel();
+}
 
-                if (total_dv < best_total_dv)
-                {
-                    best_total_dv = total_dv;
-                    best_dv1 = dv1;
-                    best_c3 = c3_clamped;
-                }
-            }
+// Optima of the last solve's total Δv (objective 0) or C3 (1) grid, best first: an array of { departureJd,
+// arrivalJd, c3, dv1, totalDv, departureIndex, arrivalIndex }. Refinement runs against Hermite
+// interpolants of the buffered tables. Empty when that grid was not solved.
+emscripten::val findPorkchopOptimaInPlace(double mu, double departure_planet_mu, double arrival_planet_mu,
+                                          double departure_orbit_radius, double arrival_orbit_radius,
+                                          int objective, int max_count)
+{
+    PorkchopBuffers &b = porkchop_buffers;
+    PorkchopMetric metric = objective == OPTIMUM_C3 ? METRIC_C3 : METRIC_TOTAL_DV;
 
-            result_c3[index] = std::min(best_c3, MAX_C3_CUTOFF);
-            result_dv1[index] = std::min(best_dv1, MAX_DV_CUTOFF);
-            result_total_dv[index] = std::min(best_total_dv, MAX_DV_CUTOFF);
-        }
+    emscripten::val result = emscripten::val::array();
+    if (b.metrics[metric].empty())
+        return result;
+
+    OptimumSearch search;
+    search.objective = objective == OPTIMUM_C3 ? OPTIMUM_C3 : OPTIMUM_TOTAL_DV;
+    search.max_count = max_count;
+    search.backend = porkchop_backend;
+
+    HermiteEphemeris departure(b.d1.data(), b.r1.data(), b.v1.data(), b.num_departure_dates, mu);
+    HermiteEphemeris arrival(b.d2.data(), b.r2.data(), b.v2.data(), b.num_arrival_dates, mu);
+    MetricOutput grid = {metric, b.formats[metric], b.metrics[metric].data()};
+
+    std::vector<PorkchopOptimum> optima = findPorkchopOptima(
+            mu, departure, arrival, b.d1.data(), b.d2.data(), b.num_departure_dates, b.num_arrival_dates,
+            departure_planet_mu, arrival_planet_mu, departure_orbit_radius, arrival_orbit_radius, grid, search);
+
+    for (size_t k = 0; k < optima.size(); ++k)
+    {
+        const PorkchopOptimum &o = optima[k];
+        emscripten::val entry = emscripten::val::object();
+        entry.set("departureJd", o.departure_jd);
+        entry.set("arrivalJd", o.arrival_jd);
+        entry.set("c3", o.c3);
+        entry.set("dv1", o.dv1);
+        entry.set("totalDv", o.total_dv);
+        entry.set("departureIndex", o.departure_index);
+        entry.set("arrivalIndex", o.arrival_index);
+        result.set(k, entry);
     }
+
+    return result;
 }
 
-#ifdef EMSCRIPTEN
+// Isolines of the buffered grids, so plots can draw contours from polylines instead of the grids: each call
+// returns { levels: Float64Array, offsets: Uint32Array, points: Float32Array } (see ContourSet) over one shared
+// buffer, valid until the next contour call.
+static ContourSet porkchop_contours;
 
-EMSCRIPTEN_KEEPALIVE
-#endif
-std::vector<double> computePorkchopPlotWrapper(
-        double mu,
-        const emscripten::val &r1_js,
-        const emscripten::val &v1_js,
-        const emscripten::val &r2_js,
-        const emscripten::val &v2_js,
-        const emscripten::val &d1_js,
-        const emscripten::val &d2_js,
-        int num_departure_dates,
-        int num_arrival_dates,
-        double departure_planet_mu,
-        double arrival_planet_mu,
-        double departure_orbit_radius,
-        double arrival_orbit_radius
-)
+static emscripten::val contourViews()
 {
-    std::vector<double> r1 = emscripten::vecFromJSArray<double>(r1_js);
-    std::vector<double> v1 = emscripten::vecFromJSArray<double>(v1_js);
-    std::vector<double> r2 = emscripten::vecFromJSArray<double>(r2_js);
-    std::vector<double> v2 = emscripten::vecFromJSArray<double>(v2_js);
-    std::vector<double> d1 = emscripten::vecFromJSArray<double>(d1_js);
-    std::vector<double> d2 = emscripten::vecFromJSArray<double>(d2_js);
-
-    int total_results = num_departure_dates * num_arrival_dates;
-    std::vector<double> result_c3(total_results);
-    std::vector<double> result_dv1(total_results);
-    std::vector<double> result_total_dv(total_results);
+    emscripten::val result = emscripten::val::object();
+    result.set("levels", heapView(porkchop_contours.levels));
+    result.set("offsets", heapView(porkchop_contours.offsets));
+    result.set("points", heapView(porkchop_contours.points));
+    return result;
+}
 
+// Contours of a metric grid of the last solve; null when that grid was not solved.
+emscripten::val contourPorkchopMetricInPlace(int metric, const emscripten::val &levels_js)
+{
+    if (metric < 0 || metric >= NUM_PORKCHOP_METRICS || porkchop_buffers.metrics[metric].empty())
+        return emscripten::val::null();
 
-    auto start = std::chrono::high_resolution_clock::now();
+    PorkchopBuffers &b = porkchop_buffers;
+    std::vector<double> levels = emscripten::vecFromJSArray<double>(levels_js);
+    MetricOutput grid = {static_cast<PorkchopMetric>(metric), b.formats[metric], b.metrics[metric].data()};
 
-    computePorkchopPlot_SIMD(mu, r1, v1, r2, v2, d1, d2,
-                             num_departure_dates, num_arrival_dates, departure_planet_mu, arrival_planet_mu,
-                             departure_orbit_radius, arrival_orbit_radius, result_c3, result_dv1, result_total_dv);
+    contourPorkchopMetric(grid, b.num_departure_dates, b.num_arrival_dates, levels.data(),
+                          static_cast<int>(levels.size()), porkchop_contours);
+    return contourViews();
+}
 
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double, std::milli> duration = end - start;
+// Isochrones over the buffered dates, levels in days.
+emscripten::val contourTimeOfFlightInPlace(const emscripten::val &levels_js)
+{
+    PorkchopBuffers &b = porkchop_buffers;
+    std::vector<double> levels = emscripten::vecFromJSArray<double>(levels_js);
 
-    std::cout << "Execution time: " << duration.count() << " milliseconds" << std::endl;
+    contourTimeOfFlight(b.d1.data(), b.d2.data(), b.num_departure_dates, b.num_arrival_dates, levels.data(),
+                        static_cast<int>(levels.size()), porkchop_contours);
+    return contourViews();
+}
 
-    std::vector<double> all_results;
-    all_results.insert(all_results.end(), result_c3.begin(), result_c3.end());
-    all_results.insert(all_results.end(), result_dv1.begin(), result_dv1.end());
-    all_results.insert(all_results.end(), result_total_dv.begin(), result_total_dv.end());
+// Lines of constant arrival date, levels in JD.
+emscripten::val contourArrivalDateInPlace(const emscripten::val &levels_js)
+{
+    PorkchopBuffers &b = porkchop_buffers;
+    std::vector<double> levels = emscripten::vecFromJSArray<double>(levels_js);
 
-    return all_results;
+    contourArrivalDate(b.d2.data(), b.num_departure_dates, b.num_arrival_dates, levels.data(),
+                       static_cast<int>(levels.size()), porkchop_contours);
+    return contourViews();
 }
 
 EMSCRIPTEN_BINDINGS(porkchop_module)
@@ -654,4 +1009,34 @@ EMSCRIPTEN_BINDINGS(porkchop_module)
 
     emscripten::function("computePorkchopPlot", &computePorkchopPlotWrapper,
                          emscripten::allow_raw_pointers());
-}
\ No newline at end of file
+
+    emscripten::function("preparePorkchopBuffers", &preparePorkchopBuffers);
+    emscripten::function("preparePorkchopBodies", &preparePorkchopBodies);
+    emscripten::function("departurePositionsView", &departurePositionsView);
+    emscripten::function("departureVelocitiesView", &departureVelocitiesView);
+    emscripten::function("departureDatesView", &departureDatesView);
+    emscripten::function("arrivalPositionsView", &arrivalPositionsView);
+    emscripten::function("arrivalVelocitiesView", &arrivalVelocitiesView);
+    emscripten::function("arrivalDatesView", &arrivalDatesView);
+    emscripten::function("computePorkchopPlotInPlace", &computePorkchopPlotInPlace);
+    emscripten::function("porkchopC3View", &porkchopC3View);
+    emscripten::function("porkchopDv1View", &porkchopDv1View);
+    emscripten::function("porkchopTotalDvView", &porkchopTotalDvView);
+    emscripten::function("porkchopThreadCount", &porkchopThreadCount);
+    emscripten::function("startPorkchopJob", &startPorkchopJob);
+    emscripten::function("stepPorkchopJob", &stepPorkchopJob);
+    emscripten::function("cancelPorkchopJob", &cancelPorkchopJob);
+    emscripten::function("computePorkchopMetricsInPlace", &computePorkchopMetricsInPlace);
+    emscripten::function("startPorkchopMetricsJob", &startPorkchopMetricsJob);
+    emscripten::function("porkchopMetricView", &porkchopMetricView);
+    emscripten::function("porkchopMetricRange", &porkchopMetricRange);
+    emscripten::function("setPorkchopPruning", &setPorkchopPruning);
+    emscripten::function("findPorkchopOptima", &findPorkchopOptimaInPlace);
+    emscripten::function("setPorkchopPrecision", &setPorkchopPrecision);
+    emscripten::function("setPorkchopSolver", &setPorkchopSolver);
+    emscripten::function("contourPorkchopMetric", &contourPorkchopMetricInPlace);
+    emscripten::function("contourPorkchopTimeOfFlight", &contourTimeOfFlightInPlace);
+    emscripten::function("contourPorkchopArrivalDate", &contourArrivalDateInPlace);
+}
+
+#endif
\ No newline at end of file
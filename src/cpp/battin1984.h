@@ -2,8 +2,10 @@
 #define LAMBERT_BATTIN1984_H
 
 #include <Eigen/Dense>
+#include "continued_fractions.h"
 #include <tuple>
 #include <chrono>
+#include <limits>
 
 #ifdef EMSCRIPTEN
 #include <emscripten.h>
@@ -17,9 +19,132 @@ constexpr double MAX_TOF = 86400.0 * 365 * 20;
 constexpr double MAX_DV_CUTOFF = 50.0;
 constexpr double MAX_C3_CUTOFF = 250.0;
 constexpr double INVALID_MARKER = -1.0;
+constexpr double PRUNED_MARKER = -2.0;     // rejected by a pruned sweep without a full solve
+
+// Geometry shared by the short- and long-path solves between r1 and r2.
+struct TransferGeometry
+{
+    double r1_norm;
+    double r2_norm;
+    double c_norm;
+    double semiperimeter;
+    double theta0;      // angle between r1 and r2 in [0, pi]
+    double alpha;       // z component of the unit angular momentum
+    bool degenerate;    // r1 and r2 are collinear
+};
+
+// r1_norm is passed in so porkchop rows can reuse it across the arrival loop.
+TransferGeometry getTransferGeometry(vec3d &r1, vec3d &r2, double r1_norm);
+
+// Iteration-independent quantities of one Battin-Vaughan solve.
+struct BattinParameters
+{
+    double lambda;
+    double l1;
+    double m;
+    double semiperimeter;
+    double x0;
+};
+
+BattinParameters getBattinParameters(double mu, const TransferGeometry &g, double tof,
+                                     bool prograde, bool shortPath, int nRev = 0);
+
+BattinParameters getBattinParameters(double mu, vec3d &r1, vec3d &r2, double tof,
+                                     bool prograde, bool shortPath, int nRev = 0);
+
+std::tuple<vec3d, vec3d> battinVelocities(const BattinParameters &p, const TransferGeometry &g,
+                                          vec3d &r1, vec3d &r2, double tof, double x, double y);
+
+// Fixed-point iteration from x0; returns the number of iterations performed. converged, when given, tells whether
+// the step fell within atol before maxIter ran out.
+int battinIterate(double l1, double m, double x0, int maxIter, double atol,
+                  const ContinuedFractionDepth &depth, double &x, double &y, bool *converged = nullptr);
 
 std::tuple<vec3d, vec3d> battin1984(double mu, vec3d &r1, vec3d &r2, double tof,
-                                    bool prograde = true, bool shortPath = true, int maxIter = 100, double atol = tol, int nRev = 0);
+                                    bool prograde = true, bool shortPath = true, int maxIter = 100, double atol = tol, int nRev = 0,
+                                    ContinuedFractionMode cfMode = CF_ADAPTIVE);
+
+// Zero-revolution solvers a sweep can run on; see lambert_solver.h.
+enum LambertBackend
+{
+    LAMBERT_BATTIN,     // Battin-Vaughan fixed-point iteration below
+    LAMBERT_IZZO,       // Izzo (2015) Householder iteration, izzo2015.h
+    LAMBERT_GOODING,    // Gooding (1990) Halley iteration, gooding1990.h
+    LAMBERT_AUTO        // per transfer, whichever is fastest for its geometry
+};
+
+struct LambertBranches
+{
+    vec3d v1_short;
+    vec3d v2_short;
+    vec3d v1_long;
+    vec3d v2_long;
+};
+
+// Continuation state along a porkchop row: the converged x of the last two cells, per branch.
+// The seed is their linear extrapolation, or the last x alone after one cell. NaN means no seed (cold start).
+struct WarmSeed
+{
+    double x_prev = std::numeric_limits<double>::quiet_NaN();
+    double x_last = std::numeric_limits<double>::quiet_NaN();
+
+    double predict() const { return std::isfinite(x_prev) ? 2. * x_last - x_prev : x_last; }
+    void push(double x);
+};
+
+struct WarmStart
+{
+    WarmSeed short_path;
+    WarmSeed long_path;
+};
+
+struct IterationStats
+{
+    long long solves = 0;
+    long long iterations = 0;       // iterations actually spent, including failed seeds
+    long long cold_iterations = 0;  // iterations the same solves take from the cold start
+    long long warm_starts = 0;
+    long long fallbacks = 0;        // seeds that did not converge and were retried cold
+
+    long long saved() const { return cold_iterations - iterations; }
+
+    IterationStats &operator+=(const IterationStats &other);
+};
+
+// Short- and long-path solutions from a single geometry evaluation.
+LambertBranches battin1984Branches(double mu, vec3d &r1, vec3d &r2, double tof, bool prograde = true,
+                                   int maxIter = 100, double atol = tol, ContinuedFractionMode cfMode = CF_ADAPTIVE);
+
+// With `warm`, each branch is seeded from the previous solve and the seeds are updated on return.
+// Passing `stats` also runs the cold start of every warm-started solve, to count the iterations saved.
+LambertBranches battin1984Branches(double mu, const TransferGeometry &g, vec3d &r1, vec3d &r2, double tof,
+                                   bool prograde = true, int maxIter = 100, double atol = tol,
+                                   ContinuedFractionMode cfMode = CF_ADAPTIVE,
+                                   WarmStart *warm = nullptr, IterationStats *stats = nullptr);
+
+double julianDateToSeconds(double julianDate);
+
+// warm and stats apply to the Battin solves only; the other backends do not need a seed.
+void computePorkchopCell(double mu, vec3d &r1_departure, double r1_norm, const vec3d &v1_departure,
+                         vec3d &r2_arrival, const vec3d &v2_arrival,
+                         double departure_time, double arrival_time,
+                         double v_orbit_dep, double v_orbit_arr,
+                         double &c3, double &dv1, double &total_dv,
+                         WarmStart *warm = nullptr, IterationStats *stats = nullptr,
+                         LambertBackend backend = LAMBERT_BATTIN);
+
+void computePorkchopPlot(double mu, const double *r1, const double *v1, const double *r2, const double *v2,
+                         const double *d1, const double *d2, int num_departure_dates, int num_arrival_dates,
+                         double departure_planet_mu, double arrival_planet_mu,
+                         double departure_orbit_radius, double arrival_orbit_radius,
+                         double *result_c3, double *result_dv1, double *result_total_dv);
+
+// Same grid as computePorkchopPlot, with the iteration of every row run through the lane-parallel batch kernel.
+void computePorkchopPlot_SIMD(double mu, const double *r1, const double *v1, const double *r2, const double *v2,
+                              const double *d1, const double *d2, int num_departure_dates, int num_arrival_dates,
+                              double departure_planet_mu, double arrival_planet_mu,
+                              double departure_orbit_radius, double arrival_orbit_radius,
+                              double *result_c3, double *result_dv1, double *result_total_dv);
 
 extern "C"
 {
@@ -0,0 +1,343 @@
+#include "battin1984_batch.h"
+#include "simd_lanes.h"
+#include <algorithm>
+
+const char *battinBatchInstructionSet()
+{
+    return LAMBERT_SIMD_NAME;
+}
+
+int battinBatchLanes()
+{
+    return LANES;
+}
+
+// Lane version of evaluateContinuedFraction: branch-free for the first `fixed` levels, then masked per lane.
+LaneD continuedFractionLanes(const double *gamma, int levels, LaneD z, LaneMask active, int fixed, double tail_tol)
+{
+    const LaneD one = laneSet(1.);
+    const LaneD threshold = laneSet(tail_tol);
+
+    LaneD delta = one, u = one, sigma = one;
+
+    int level = 0;
+    for (; level < fixed; ++level)
+    {
+        delta = one / (one + laneSet(gamma[level]) * z * delta);
+        u = u * (delta - one);
+        sigma = sigma + u;
+    }
+
+    active = maskAnd(active, laneGt(laneAbs(u), threshold));
+
+    for (; level < levels && maskAny(active); ++level)
+    {
+        LaneD delta_next = one / (one + laneSet(gamma[level]) * z * delta);
+        LaneD u_next = u * (delta_next - one);
+
+        delta = laneSelect(active, delta_next, delta);
+        u = laneSelect(active, u_next, u);
+        sigma = laneSelect(active, sigma + u_next, sigma);
+
+        active = maskAnd(active, laneGt(laneAbs(u), threshold));
+    }
+
+    return sigma;
+}
+
+LaneD xiAtXLanes(LaneD x, LaneMask active, const ContinuedFractionDepth &depth)
+{
+    const LaneD one = laneSet(1.);
+
+    LaneD sqrt_term = laneSqrt(one + x) + one;
+    LaneD eta = x / (sqrt_term * sqrt_term);
+    LaneD sigma = continuedFractionLanes(XI_GAMMA.data(), XI_LEVELS, eta, active, depth.xi, depth.tail_tol);
+
+    LaneD inner = laneSet(5.) + eta + (laneSet(9.) * eta / laneSet(7.)) * sigma;
+    return laneSet(8.) * sqrt_term / (laneSet(3.) + one / inner);
+}
+
+LaneD KAtuLanes(LaneD u, LaneMask active, const ContinuedFractionDepth &depth)
+{
+    LaneD sigma = continuedFractionLanes(K_GAMMA.data(), K_LEVELS, laneSet(0.) - u, active, depth.k, depth.tail_tol);
+
+    LaneD third = sigma / laneSet(3.0);
+    return third * third;
+}
+
+void iterateLanes(LaneD l1, LaneD m, LaneD x0, LaneD &x, LaneD &y, int maxIter, double atol,
+                  const ContinuedFractionDepth &depth)
+{
+    const LaneD one = laneSet(1.);
+    const LaneD two = laneSet(2.);
+    const LaneD three = laneSet(3.);
+    const LaneD tolerance = laneSet(atol);
+
+    LaneMask done = maskNone();
+    x = x0;
+    y = laneSet(0.);
+
+    for (int i = 0; i < maxIter && !maskAll(done); ++i)
+    {
+        LaneMask active = maskNot(done);
+
+        // getH
+        LaneD xi = xiAtXLanes(x0, active, depth);
+        LaneD h_denom = (one + two * x0 + l1) * (laneSet(4.) * x0 + xi * (three + x0));
+        LaneD l1x = l1 + x0;
+        LaneD h1 = (l1x * l1x * (one + three * x0 + xi)) / h_denom;
+        LaneD h2 = (m * (x0 - l1 + xi)) / h_denom;
+
+        // uAtH
+        LaneD h1p = one + h1;
+        LaneD B = (laneSet(27.) * h2) / (laneSet(4.) * h1p * h1p * h1p);
+        LaneD sqrt_b = laneSqrt(one + B);
+        LaneD u = (laneSet(0.) - B) / (two * (sqrt_b + one));
+
+        // battinSecondEq
+        LaneD K = KAtuLanes(u, active, depth);
+        LaneD y_next = (h1p / three) * (two + sqrt_b / (one - two * u * K));
+
+        // battinFirstEq
+        LaneD half_diff = (one - l1) / two;
+        LaneD x_next = laneSqrt(half_diff * half_diff + m / (y_next * y_next)) - (one + l1) / two;
+
+        x = laneSelect(active, x_next, x);
+        y = laneSelect(active, y_next, y);
+        done = maskOr(done, maskAnd(active, laneLe(laneAbs(x_next - x0), tolerance)));
+        x0 = laneSelect(active, x_next, x0);
+    }
+}
+
+// Single-precision versions of the lane functions above, LANES_F problems per register.
+LaneF continuedFractionLanesF(const float *gamma, int levels, LaneF z, LaneMaskF active, int fixed, float tail_tol)
+{
+    const LaneF one = laneSetF(1.f);
+    const LaneF threshold = laneSetF(tail_tol);
+
+    LaneF delta = one, u = one, sigma = one;
+
+    int level = 0;
+    for (; level < fixed; ++level)
+    {
+        delta = one / (one + laneSetF(gamma[level]) * z * delta);
+        u = u * (delta - one);
+        sigma = sigma + u;
+    }
+
+    active = maskAndF(active, laneGtF(laneAbsF(u), threshold));
+
+    for (; level < levels && maskAnyF(active); ++level)
+    {
+        LaneF delta_next = one / (one + laneSetF(gamma[level]) * z * delta);
+        LaneF u_next = u * (delta_next - one);
+
+        delta = laneSelectF(active, delta_next, delta);
+        u = laneSelectF(active, u_next, u);
+        sigma = laneSelectF(active, sigma + u_next, sigma);
+
+        active = maskAndF(active, laneGtF(laneAbsF(u), threshold));
+    }
+
+    return sigma;
+}
+
+LaneF xiAtXLanesF(LaneF x, LaneMaskF active, const ContinuedFractionDepth &depth)
+{
+    const LaneF one = laneSetF(1.f);
+
+    LaneF sqrt_term = laneSqrtF(one + x) + one;
+    LaneF eta = x / (sqrt_term * sqrt_term);
+    LaneF sigma = continuedFractionLanesF(XI_GAMMA_F.data(), XI_LEVELS, eta, active, depth.xi,
+                                          static_cast<float>(depth.tail_tol));
+
+    LaneF inner = laneSetF(5.f) + eta + (laneSetF(9.f) * eta / laneSetF(7.f)) * sigma;
+    return laneSetF(8.f) * sqrt_term / (laneSetF(3.f) + one / inner);
+}
+
+LaneF KAtuLanesF(LaneF u, LaneMaskF active, const ContinuedFractionDepth &depth)
+{
+    LaneF sigma = continuedFractionLanesF(K_GAMMA_F.data(), K_LEVELS, laneSetF(0.f) - u, active, depth.k,
+                                          static_cast<float>(depth.tail_tol));
+
+    LaneF third = sigma / laneSetF(3.f);
+    return third * third;
+}
+
+void iterateLanesF(LaneF l1, LaneF m, LaneF x0, LaneF &x, LaneF &y, int maxIter, float atol,
+                   const ContinuedFractionDepth &depth)
+{
+    const LaneF one = laneSetF(1.f);
+    const LaneF two = laneSetF(2.f);
+    const LaneF three = laneSetF(3.f);
+    const LaneF tolerance = laneSetF(atol);
+
+    LaneMaskF done = maskNoneF();
+    x = x0;
+    y = laneSetF(0.f);
+
+    for (int i = 0; i < maxIter && !maskAllF(done); ++i)
+    {
+        LaneMaskF active = maskNotF(done);
+
+        LaneF xi = xiAtXLanesF(x0, active, depth);
+        LaneF h_denom = (one + two * x0 + l1) * (laneSetF(4.f) * x0 + xi * (three + x0));
+        LaneF l1x = l1 + x0;
+        LaneF h1 = (l1x * l1x * (one + three * x0 + xi)) / h_denom;
+        LaneF h2 = (m * (x0 - l1 + xi)) / h_denom;
+
+        LaneF h1p = one + h1;
+        LaneF B = (laneSetF(27.f) * h2) / (laneSetF(4.f) * h1p * h1p * h1p);
+        LaneF sqrt_b = laneSqrtF(one + B);
+        LaneF u = (laneSetF(0.f) - B) / (two * (sqrt_b + one));
+
+        LaneF K = KAtuLanesF(u, active, depth);
+        LaneF y_next = (h1p / three) * (two + sqrt_b / (one - two * u * K));
+
+        LaneF half_diff = (one - l1) / two;
+        LaneF x_next = laneSqrtF(half_diff * half_diff + m / (y_next * y_next)) - (one + l1) / two;
+
+        x = laneSelectF(active, x_next, x);
+        y = laneSelectF(active, y_next, y);
+        // relative to |x|, since far from x = 0 the absolute tolerance is below float resolution
+        LaneF step = laneAbsF(x_next - x0);
+        done = maskOrF(done, maskAndF(active, laneLeF(step, tolerance * (one + laneAbsF(x_next)))));
+        x0 = laneSelectF(active, x_next, x0);
+    }
+}
+
+// Calls solve(l1, m, x0, x, y) on consecutive blocks of `width` problems; the tail is padded by repeating the last
+// problem.
+template<int width, typename Solve>
+static void solveInBlocks(const double *l1, const double *m, const double *x0, double *x, double *y, int n,
+                          Solve solve)
+{
+    int k = 0;
+    for (; k + width <= n; k += width)
+        solve(l1 + k, m + k, x0 + k, x + k, y + k);
+
+    if (k < n)
+    {
+        double l1_tail[width], m_tail[width], x0_tail[width], x_tail[width], y_tail[width];
+        for (int lane = 0; lane < width; ++lane)
+        {
+            int src = std::min(k + lane, n - 1);
+            l1_tail[lane] = l1[src];
+            m_tail[lane] = m[src];
+            x0_tail[lane] = x0[src];
+        }
+
+        solve(l1_tail, m_tail, x0_tail, x_tail, y_tail);
+
+        for (int lane = 0; k + lane < n; ++lane)
+        {
+            x[k + lane] = x_tail[lane];
+            y[k + lane] = y_tail[lane];
+        }
+    }
+}
+
+void battinIterateBatch(const double *l1, const double *m, const double *x0, double *x, double *y, int n,
+                        int maxIter, double atol, ContinuedFractionMode cfMode, SolverPrecision precision)
+{
+    if (precision != PRECISION_DOUBLE)
+    {
+        double float_tol = std::max(atol, FLOAT_ITERATION_TOL);
+
+        // terms below float epsilon cannot change a float sum, so the adaptive tail stops there
+        ContinuedFractionDepth depth = continuedFractionDepth(cfMode, float_tol);
+        depth.tail_tol = std::max(depth.tail_tol, 1e-8);
+
+        solveInBlocks<LANES_F>(l1, m, x0, x, y, n, [&](const double *l1, const double *m, const double *x0,
+                                                        double *x, double *y)
+        {
+            LaneF x_lane, y_lane;
+            iterateLanesF(laneLoadF(l1), laneLoadF(m), laneLoadF(x0), x_lane, y_lane, maxIter,
+                          static_cast<float>(float_tol), depth);
+            laneStoreF(x, x_lane);
+            laneStoreF(y, y_lane);
+        });
+
+        if (precision == PRECISION_FLOAT || atol >= float_tol)
+            return;
+
+        // polish: the double iteration restarted from the float32 solution
+        x0 = x;
+    }
+
+    ContinuedFractionDepth depth = continuedFractionDepth(cfMode, atol);
+
+    // Near the solution each step squares the error, so once a step is below sqrt(atol) the x it produced is
+    // already within atol: a polish from a converged float32 x stops after its first, correcting, step.
+    double stop_tol = precision == PRECISION_MIXED ? std::sqrt(atol) : atol;
+
+    solveInBlocks<LANES>(l1, m, x0, x, y, n, [&](const double *l1, const double *m, const double *x0,
+                                                  double *x, double *y)
+    {
+        LaneD x_lane, y_lane;
+        iterateLanes(laneLoad(l1), laneLoad(m), laneLoad(x0), x_lane, y_lane, maxIter, stop_tol, depth);
+        laneStore(x, x_lane);
+        laneStore(y, y_lane);
+    });
+}
+
+void battin1984Batch(double mu,
+                     const double *r1x, const double *r1y, const double *r1z,
+                     const double *r2x, const double *r2y, const double *r2z,
+                     const double *tof,
+                     double *v1x, double *v1y, double *v1z,
+                     double *v2x, double *v2y, double *v2z,
+                     int n, bool prograde, bool shortPath, int maxIter, double atol, int nRev,
+                     ContinuedFractionMode cfMode)
+{
+    constexpr int BLOCK = 256;
+
+    double lambda[BLOCK], semiperimeter[BLOCK], m[BLOCK];
+    double l1[BLOCK], x0[BLOCK], x[BLOCK], y[BLOCK];
+
+    for (int begin = 0; begin < n; begin += BLOCK)
+    {
+        int count = std::min(BLOCK, n - begin);
+
+        for (int k = 0; k < count; ++k)
+        {
+            int idx = begin + k;
+            vec3d r1 = {r1x[idx], r1y[idx], r1z[idx]};
+            vec3d r2 = {r2x[idx], r2y[idx], r2z[idx]};
+
+            BattinParameters p = getBattinParameters(mu, r1, r2, tof[idx], prograde, shortPath, nRev);
+            lambda[k] = p.lambda;
+            semiperimeter[k] = p.semiperimeter;
+            m[k] = p.m;
+            l1[k] = p.l1;
+            x0[k] = p.x0;
+        }
+
+        battinIterateBatch(l1, m, x0, x, y, count, maxIter, atol, cfMode);
+
+        for (int k = 0; k < count; ++k)
+        {
+            int idx = begin + k;
+
+            double r1_norm = std::sqrt(r1x[idx] * r1x[idx] + r1y[idx] * r1y[idx] + r1z[idx] * r1z[idx]);
+            double r2_norm = std::sqrt(r2x[idx] * r2x[idx] + r2y[idx] * r2y[idx] + r2z[idx] * r2z[idx]);
+
+            double lambda_sq = (1 + lambda[k]) * (1 + lambda[k]);
+            double r11 = lambda_sq / (4 * tof[idx] * lambda[k]);
+            double s11 = y[k] * (1 + x[k]);
+            double t11 = (m[k] * semiperimeter[k] * lambda_sq) / s11;
+
+            double dx = r1x[idx] - r2x[idx];
+            double dy = r1y[idx] - r2y[idx];
+            double dz = r1z[idx] - r2z[idx];
+
+            v1x[idx] = -r11 * (s11 * dx - t11 * r1x[idx] / r1_norm);
+            v1y[idx] = -r11 * (s11 * dy - t11 * r1y[idx] / r1_norm);
+            v1z[idx] = -r11 * (s11 * dz - t11 * r1z[idx] / r1_norm);
+
+            v2x[idx] = -r11 * (s11 * dx + t11 * r2x[idx] / r2_norm);
+            v2y[idx] = -r11 * (s11 * dy + t11 * r2y[idx] / r2_norm);
+            v2z[idx] = -r11 * (s11 * dz + t11 * r2z[idx] / r2_norm);
+        }
+    }
+}
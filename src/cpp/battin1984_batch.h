@@ -0,0 +1,47 @@
+#ifndef LAMBERT_BATTIN1984_BATCH_H
+#define LAMBERT_BATTIN1984_BATCH_H
+
+#include "battin1984.h"
+
+// Name of the lane instruction set the batch kernel was compiled for ("avx512", "avx2", "wasm-simd128", "scalar").
+const char *battinBatchInstructionSet();
+
+int battinBatchLanes();
+
+enum SolverPrecision
+{
+    PRECISION_DOUBLE,   // float64 throughout
+    PRECISION_MIXED,    // float32 iteration, then a float64 correction step: float64 accuracy, usually one step
+    PRECISION_FLOAT     // float32 iteration only: porkchop Δv within about 10 m/s (worst near 180 deg transfers)
+};
+
+// Convergence tolerance of the float32 iteration, relative to 1 + |x|; tighter atol values are not reachable in
+// single precision.
+constexpr double FLOAT_ITERATION_TOL = 2e-6;
+
+// Runs the Battin-Vaughan fixed-point iteration (getH, uAtH, KAtu, battinFirstEq) for n problems at once,
+// LANES problems per vector register (LANES_F in float32). Each lane stops updating once it has converged.
+// Inputs are the l1, m and x0 fields of BattinParameters in structure-of-arrays form; outputs are the converged x, y.
+void battinIterateBatch(const double *l1, const double *m, const double *x0, double *x, double *y, int n,
+                        int maxIter = 100, double atol = tol, ContinuedFractionMode cfMode = CF_ADAPTIVE,
+                        SolverPrecision precision = PRECISION_DOUBLE);
+
+extern "C"
+{
+
+#ifdef EMSCRIPTEN
+EMSCRIPTEN_KEEPALIVE
+#endif
+// Structure-of-arrays Lambert solve: problem k is (r1x[k], r1y[k], r1z[k]) -> (r2x[k], r2y[k], r2z[k]) in tof[k].
+// v1/v2 are written into caller-owned arrays of length n; nothing is allocated per call.
+void battin1984Batch(double mu,
+                     const double *r1x, const double *r1y, const double *r1z,
+                     const double *r2x, const double *r2y, const double *r2z,
+                     const double *tof,
+                     double *v1x, double *v1y, double *v1z,
+                     double *v2x, double *v2y, double *v2z,
+                     int n, bool prograde, bool shortPath, int maxIter, double atol, int nRev,
+                     ContinuedFractionMode cfMode);
+}
+
+#endif //LAMBERT_BATTIN1984_BATCH_H
@@ -0,0 +1,115 @@
+#ifndef LAMBERT_CONTINUED_FRACTIONS_H
+#define LAMBERT_CONTINUED_FRACTIONS_H
+
+#include <array>
+#include <cmath>
+#include "instrumentation.h"
+
+// Coefficient tables of the two continued fractions of the Battin-Vaughan method, both written as
+//     1 / (1 + g[0] z / (1 + g[1] z / (1 + g[2] z / ...)))
+// xi(x) uses z = eta, K(u) uses z = -u.
+
+constexpr int XI_LEVELS = 125;
+constexpr int K_LEVELS = 2001;
+
+constexpr std::array<double, XI_LEVELS> makeXiGamma()
+{
+    std::array<double, XI_LEVELS> gamma{};
+    for (int n = 1; n <= XI_LEVELS; ++n)
+    {
+        double a = (n + 3.) * (n + 3.);
+        gamma[n - 1] = a / (4. * a - 1.);
+    }
+    return gamma;
+}
+
+constexpr std::array<double, K_LEVELS> makeKGamma()
+{
+    std::array<double, K_LEVELS> gamma{};
+    gamma[0] = 4. / 27.;
+    for (int n = 1; 2 * n < K_LEVELS; ++n)
+    {
+        gamma[2 * n - 1] = 2.0 * (3. * n + 1) * (6. * n - 1) / (9.0 * (4 * n - 1) * (4 * n + 1));
+        gamma[2 * n] = 2.0 * (3. * n + 2) * (6. * n + 1) / (9.0 * (4 * n + 1) * (4 * n + 3));
+    }
+    return gamma;
+}
+
+inline constexpr std::array<double, XI_LEVELS> XI_GAMMA = makeXiGamma();
+inline constexpr std::array<double, K_LEVELS> K_GAMMA = makeKGamma();
+
+template<size_t N>
+constexpr std::array<float, N> narrowGamma(const std::array<double, N> &gamma)
+{
+    std::array<float, N> narrow{};
+    for (size_t n = 0; n < N; ++n)
+        narrow[n] = static_cast<float>(gamma[n]);
+    return narrow;
+}
+
+// Single-precision copies for the float32 batch kernel.
+inline constexpr std::array<float, XI_LEVELS> XI_GAMMA_F = narrowGamma(XI_GAMMA);
+inline constexpr std::array<float, K_LEVELS> K_GAMMA_F = narrowGamma(K_GAMMA);
+
+enum ContinuedFractionMode
+{
+    CF_ADAPTIVE = 0,    // stop as soon as the next term drops below 1e-18
+    CF_FIXED_DEPTH = 1  // evaluate a depth derived from the tolerance without per-level tests
+};
+
+struct ContinuedFractionDepth
+{
+    int xi;
+    int k;
+    double tail_tol;
+};
+
+// Fixed depths are sized so that the truncation error stays below 1e-2 * atol where most iterations of a
+// porkchop sweep land: -0.35 <= eta <= 0.5 for xi (convergence ratio <= 0.1) and |u| <= 0.3 for K
+// (ratio <= 0.08). Lanes outside of that fall through to the adaptive tail.
+inline ContinuedFractionDepth continuedFractionDepth(ContinuedFractionMode mode, double atol)
+{
+    if (mode != CF_FIXED_DEPTH)
+        return {0, 0, 1e-18};
+
+    double tail_tol = 1e-2 * atol;
+    int xi = static_cast<int>(std::ceil(std::log(tail_tol) / std::log(0.1)));
+    int k = static_cast<int>(std::ceil(std::log(tail_tol) / std::log(0.08)));
+
+    xi = xi < 2 ? 2 : (xi > XI_LEVELS ? XI_LEVELS : xi);
+    k = k < 2 ? 2 : (k > K_LEVELS ? K_LEVELS : k);
+
+    return {xi, k, tail_tol};
+}
+
+// Top-down evaluation of the continued fraction. The first `fixed` levels run branch-free; after that,
+// levels are added until the last term drops below tail_tol. With fixed = 0 and tail_tol = 1e-18 this
+// is the original adaptive loop; in fixed-depth mode the tail only runs outside the tuned regime.
+inline double evaluateContinuedFraction(const double *gamma, int levels, double z, int fixed, double tail_tol = 1e-18)
+{
+    double delta = 1., u = 1., sigma = 1.;
+
+    int level = 0;
+    for (; level < fixed; ++level)
+    {
+        delta = 1. / (1. + gamma[level] * z * delta);
+        u = u * (delta - 1.);
+        sigma = sigma + u;
+    }
+
+    while (std::abs(u) > tail_tol && level < levels)
+    {
+        delta = 1. / (1. + gamma[level] * z * delta);
+        u = u * (delta - 1.);
+        sigma = sigma + u;
+        ++level;
+    }
+
+#ifdef LAMBERT_INSTRUMENT
+    solveTrace().last_cf_depth = level;
+#endif
+
+    return sigma;
+}
+
+#endif //LAMBERT_CONTINUED_FRACTIONS_H
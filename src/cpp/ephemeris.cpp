@@ -0,0 +1,312 @@
+#include "ephemeris.h"
+#include "battin1984.h"
+#include <algorithm>
+#include <cmath>
+
+constexpr double DEG = M_PI / 180.0;
+
+// Standish, table 1 (valid 1800 - 2050 AD), mean ecliptic and equinox of J2000.
+static const MeanElements PLANET_MEAN_ELEMENTS[] = {
+        // Mercury
+        {0.38709927, 0.00000037, 0.20563593, 0.00001906, 7.00497902, -0.00594749,
+         252.25032350, 149472.67411175, 77.45779628, 0.16047689, 48.33076593, -0.12534081},
+        // Venus
+        {0.72333566, 0.00000390, 0.00677672, -0.00004107, 3.39467605, -0.00078890,
+         181.97909950, 58517.81538729, 131.60246718, 0.00268329, 76.67984255, -0.27769418},
+        // Earth-Moon barycenter
+        {1.00000261, 0.00000562, 0.01671123, -0.00004392, -0.00001531, -0.01294668,
+         100.46457166, 35999.37244981, 102.93768193, 0.32327364, 0.0, 0.0},
+        // Mars
+        {1.52371034, 0.00001847, 0.09339410, 0.00007882, 1.84969142, -0.00813131,
+         -4.55343205, 19140.30268499, -23.94362959, 0.44441088, 49.55953891, -0.29257343},
+        // Jupiter
+        {5.20288700, -0.00011607, 0.04838624, -0.00013253, 1.30439695, -0.00183714,
+         34.39644051, 3034.74612775, 14.72847983, 0.21252668, 100.47390909, 0.20469106},
+        // Saturn
+        {9.53667594, -0.00125060, 0.05386179, -0.00050991, 2.48599187, 0.00193609,
+         49.95424423, 1222.49362201, 92.59887831, -0.41897216, 113.66242448, -0.28867794},
+        // Uranus
+        {19.18916464, -0.00196176, 0.04725744, -0.00004397, 0.77263783, -0.00242939,
+         313.23810451, 428.48202785, 170.95427630, 0.40805281, 74.01692503, 0.04240589},
+        // Neptune
+        {30.06992276, 0.00026291, 0.00859048, 0.00005105, 1.77004347, 0.00035372,
+         -55.12002969, 218.45945325, 44.96476227, -0.32241464, 131.78422574, -0.00508664},
+        // Pluto
+        {39.48211675, -0.00031596, 0.24882730, 0.00005170, 17.14001206, 0.00004818,
+         238.92903833, 145.20780515, 224.06891629, -0.04062942, 110.30393684, -0.01183482},
+};
+
+const MeanElements *planetMeanElements(int horizons_id)
+{
+    int planet = 0;
+    if (horizons_id >= 1 && horizons_id <= 9)
+        planet = horizons_id;
+    else if (horizons_id >= 199 && horizons_id <= 999 && horizons_id % 100 == 99)
+        planet = horizons_id / 100;
+
+    return planet > 0 ? &PLANET_MEAN_ELEMENTS[planet - 1] : nullptr;
+}
+
+void solveKeplerBatch(const double *mean_anomaly, const double *eccentricity, double *eccentric_anomaly, int count)
+{
+    for (int k = 0; k < count; ++k)
+    {
+        double M = mean_anomaly[k];
+        eccentric_anomaly[k] = M + 0.85 * eccentricity[k] * (std::sin(M) >= 0 ? 1. : -1.);
+    }
+
+    for (int pass = 0; pass < 30; ++pass)
+    {
+        double max_step = 0;
+        for (int k = 0; k < count; ++k)
+        {
+            double E = eccentric_anomaly[k];
+            double e = eccentricity[k];
+            double step = (E - e * std::sin(E) - mean_anomaly[k]) / (1. - e * std::cos(E));
+            eccentric_anomaly[k] = E - step;
+            max_step = std::max(max_step, std::abs(step));
+        }
+
+        if (max_step < 1e-14)
+            break;
+    }
+}
+
+void MeanElementsEphemeris::states(const double *jd, int count, double *r, double *v) const
+{
+    std::vector<double> a(count), e(count), M(count), E(count);
+    std::vector<double> inclination(count), perihelion_argument(count), node(count);
+
+    for (int k = 0; k < count; ++k)
+    {
+        double T = (jd[k] - J2000_JD) / DAYS_PER_CENTURY;
+
+        a[k] = (elements.a + elements.a_rate * T) * AU_KM;
+        e[k] = elements.e + elements.e_rate * T;
+        inclination[k] = (elements.inclination + elements.inclination_rate * T) * DEG;
+        node[k] = (elements.node_longitude + elements.node_longitude_rate * T) * DEG;
+
+        double mean_longitude = (elements.mean_longitude + elements.mean_longitude_rate * T) * DEG;
+        double perihelion_longitude = (elements.perihelion_longitude + elements.perihelion_longitude_rate * T) * DEG;
+
+        perihelion_argument[k] = perihelion_longitude - node[k];
+        M[k] = std::remainder(mean_longitude - perihelion_longitude, 2. * M_PI);
+    }
+
+    solveKeplerBatch(M.data(), e.data(), E.data(), count);
+
+    for (int k = 0; k < count; ++k)
+    {
+        double cos_E = std::cos(E[k]), sin_E = std::sin(E[k]);
+        double b = std::sqrt(1. - e[k] * e[k]);
+        double E_dot = std::sqrt(mu / (a[k] * a[k] * a[k])) / (1. - e[k] * cos_E);
+
+        // perifocal frame
+        double x = a[k] * (cos_E - e[k]);
+        double y = a[k] * b * sin_E;
+        double vx = -a[k] * sin_E * E_dot;
+        double vy = a[k] * b * cos_E * E_dot;
+
+        double cos_w = std::cos(perihelion_argument[k]), sin_w = std::sin(perihelion_argument[k]);
+        double cos_O = std::cos(node[k]), sin_O = std::sin(node[k]);
+        double cos_i = std::cos(inclination[k]), sin_i = std::sin(inclination[k]);
+
+        double xx = cos_w * cos_O - sin_w * sin_O * cos_i, xy = -sin_w * cos_O - cos_w * sin_O * cos_i;
+        double yx = cos_w * sin_O + sin_w * cos_O * cos_i, yy = -sin_w * sin_O + cos_w * cos_O * cos_i;
+        double zx = sin_w * sin_i, zy = cos_w * sin_i;
+
+        r[3 * k] = xx * x + xy * y;
+        r[3 * k + 1] = yx * x + yy * y;
+        r[3 * k + 2] = zx * x + zy * y;
+        v[3 * k] = xx * vx + xy * vy;
+        v[3 * k + 1] = yx * vx + yy * vy;
+        v[3 * k + 2] = zx * vx + zy * vy;
+    }
+}
+
+ChebyshevEphemeris ChebyshevEphemeris::fit(const double *jd, const double *r, const double *v, int count,
+                                           double segment_days, int degree)
+{
+    ChebyshevEphemeris ephemeris;
+    if (count < degree + 1 || segment_days <= 0 || degree < 0)
+        return ephemeris;
+
+    ephemeris.jd_start = jd[0];
+    ephemeris.segment_days = segment_days;
+    ephemeris.degree = degree;
+
+    int num_segments = std::max(1, static_cast<int>(std::ceil((jd[count - 1] - jd[0]) / segment_days - 1e-9)));
+    int terms = degree + 1;
+    ephemeris.coefficients.resize(static_cast<size_t>(num_segments) * 6 * terms);
+
+    int first = 0;
+    for (int s = 0; s < num_segments; ++s)
+    {
+        double t0 = ephemeris.jd_start + s * segment_days;
+        double t1 = t0 + segment_days;
+
+        while (first < count && jd[first] < t0 - 1e-9)
+            ++first;
+        int last = first;
+        while (last < count && jd[last] <= t1 + 1e-9)
+            ++last;
+
+        int samples = last - first;
+        if (samples < terms)
+            return ChebyshevEphemeris();
+
+        Eigen::MatrixXd A(samples, terms);
+        Eigen::MatrixXd b(samples, 6);
+        for (int k = 0; k < samples; ++k)
+        {
+            int n = first + k;
+            double tau = 2. * (jd[n] - t0) / segment_days - 1.;
+
+            double T_prev = 1., T = tau;
+            A(k, 0) = 1.;
+            for (int j = 1; j < terms; ++j)
+            {
+                A(k, j) = T;
+                double T_next = 2. * tau * T - T_prev;
+                T_prev = T;
+                T = T_next;
+            }
+
+            for (int c = 0; c < 3; ++c)
+            {
+                b(k, c) = r[3 * n + c];
+                b(k, 3 + c) = v[3 * n + c];
+            }
+        }
+
+        Eigen::MatrixXd x = A.colPivHouseholderQr().solve(b);
+
+        double *segment = &ephemeris.coefficients[static_cast<size_t>(s) * 6 * terms];
+        for (int c = 0; c < 6; ++c)
+            for (int j = 0; j < terms; ++j)
+                segment[c * terms + j] = x(j, c);
+    }
+
+    ephemeris.num_segments = num_segments;
+    return ephemeris;
+}
+
+// Outside the fitted span the nearest segment is extrapolated.
+void ChebyshevEphemeris::states(const double *jd, int count, double *r, double *v) const
+{
+    int terms = degree + 1;
+
+    for (int k = 0; k < count; ++k)
+    {
+        if (num_segments == 0)
+        {
+            std::fill(r + 3 * k, r + 3 * k + 3, NAN);
+            std::fill(v + 3 * k, v + 3 * k + 3, NAN);
+            continue;
+        }
+
+        int s = std::clamp(static_cast<int>(std::floor((jd[k] - jd_start) / segment_days)), 0, num_segments - 1);
+        double tau = 2. * (jd[k] - jd_start - s * segment_days) / segment_days - 1.;
+        const double *segment = &coefficients[static_cast<size_t>(s) * 6 * terms];
+
+        for (int c = 0; c < 6; ++c)
+        {
+            // Clenshaw recurrence
+            const double *coefficient = segment + c * terms;
+            double b1 = 0, b2 = 0;
+            for (int j = degree; j >= 1; --j)
+            {
+                double b0 = 2. * tau * b1 - b2 + coefficient[j];
+                b2 = b1;
+                b1 = b0;
+            }
+            double value = tau * b1 - b2 + coefficient[0];
+
+            if (c < 3)
+                r[3 * k + c] = value;
+            else
+                v[3 * k + c - 3] = value;
+        }
+    }
+}
+
+HermiteEphemeris::HermiteEphemeris(const double *jd, const double *r, const double *v, int count, double mu)
+        : jd(jd, jd + count), r(r, r + 3 * count), v(v, v + 3 * count), a(3 * count)
+{
+    for (int k = 0; k < count; ++k)
+    {
+        double norm = std::sqrt(r[3 * k] * r[3 * k] + r[3 * k + 1] * r[3 * k + 1] + r[3 * k + 2] * r[3 * k + 2]);
+        double scale = -mu / (norm * norm * norm);
+        for (int c = 0; c < 3; ++c)
+            a[3 * k + c] = scale * r[3 * k + c];
+    }
+}
+
+void HermiteEphemeris::states(const double *dates, int count, double *r_out, double *v_out) const
+{
+    int num_samples = static_cast<int>(jd.size());
+
+    for (int k = 0; k < count; ++k)
+    {
+        if (num_samples < 2)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                r_out[3 * k + c] = num_samples ? r[c] : NAN;
+                v_out[3 * k + c] = num_samples ? v[c] : NAN;
+            }
+            continue;
+        }
+
+        int n = static_cast<int>(std::upper_bound(jd.begin(), jd.end(), dates[k]) - jd.begin()) - 1;
+        n = std::clamp(n, 0, num_samples - 2);
+
+        double h = (jd[n + 1] - jd[n]) * 86400.0;
+        double s = (dates[k] - jd[n]) * 86400.0 / h;
+        double s2 = s * s, s3 = s2 * s;
+
+        double h00 = 2 * s3 - 3 * s2 + 1, h10 = s3 - 2 * s2 + s;
+        double h01 = -2 * s3 + 3 * s2, h11 = s3 - s2;
+
+        for (int c = 0; c < 3; ++c)
+        {
+            int i0 = 3 * n + c, i1 = 3 * (n + 1) + c;
+            r_out[3 * k + c] = h00 * r[i0] + h10 * h * v[i0] + h01 * r[i1] + h11 * h * v[i1];
+            v_out[3 * k + c] = h00 * v[i0] + h10 * h * a[i0] + h01 * v[i1] + h11 * h * a[i1];
+        }
+    }
+}
+
+DateRange dateRange(double start_jd, double end_jd, double step_days)
+{
+    int count = step_days > 0 && end_jd >= start_jd
+                ? static_cast<int>(std::floor((end_jd - start_jd) / step_days + 1e-9)) + 1 : 0;
+    return {start_jd, step_days, count};
+}
+
+void sampleEphemeris(const Ephemeris &ephemeris, const DateRange &range, double *jd, double *r, double *v)
+{
+    for (int k = 0; k < range.count; ++k)
+        jd[k] = range.start_jd + range.step_days * k;
+
+    ephemeris.states(jd, range.count, r, v);
+}
+
+void computePorkchopPlotRange(double mu, const Ephemeris &departure, const DateRange &departure_dates,
+                              const Ephemeris &arrival, const DateRange &arrival_dates,
+                              double departure_planet_mu, double arrival_planet_mu,
+                              double departure_orbit_radius, double arrival_orbit_radius,
+                              double *result_c3, double *result_dv1, double *result_total_dv)
+{
+    int n = departure_dates.count;
+    int m = arrival_dates.count;
+
+    std::vector<double> d1(n), r1(3 * n), v1(3 * n);
+    std::vector<double> d2(m), r2(3 * m), v2(3 * m);
+    sampleEphemeris(departure, departure_dates, d1.data(), r1.data(), v1.data());
+    sampleEphemeris(arrival, arrival_dates, d2.data(), r2.data(), v2.data());
+
+    computePorkchopPlot_SIMD(mu, r1.data(), v1.data(), r2.data(), v2.data(), d1.data(), d2.data(), n, m,
+                             departure_planet_mu, arrival_planet_mu, departure_orbit_radius, arrival_orbit_radius,
+                             result_c3, result_dv1, result_total_dv);
+}
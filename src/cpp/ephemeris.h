@@ -0,0 +1,114 @@
+#ifndef LAMBERT_EPHEMERIS_H
+#define LAMBERT_EPHEMERIS_H
+
+#include <vector>
+
+// Body states at arbitrary epochs, in the frame the Horizons route requests: heliocentric, ecliptic and mean
+// equinox of J2000, km and km/s.
+
+constexpr double J2000_JD = 2451545.0;
+constexpr double DAYS_PER_CENTURY = 36525.0;
+constexpr double AU_KM = 149597870.7;
+
+class Ephemeris
+{
+public:
+    virtual ~Ephemeris() = default;
+
+    // r and v receive 3 * count values.
+    virtual void states(const double *jd, int count, double *r, double *v) const = 0;
+};
+
+// Keplerian elements at J2000 and their rates per Julian century, as tabulated by Standish, "Keplerian
+// Elements for Approximate Positions of the Major Planets" (1800 - 2050 AD fit; about 1e-4 rad or better).
+struct MeanElements
+{
+    double a, a_rate;                       // au
+    double e, e_rate;
+    double inclination, inclination_rate;   // deg
+    double mean_longitude, mean_longitude_rate;
+    double perihelion_longitude, perihelion_longitude_rate;
+    double node_longitude, node_longitude_rate;
+};
+
+// Mean elements of a planet by Horizons id (199 ... 999, or the barycenters 1 ... 9); nullptr for other bodies.
+// Earth resolves to the Earth-Moon barycenter, about 4700 km from the geocenter.
+const MeanElements *planetMeanElements(int horizons_id);
+
+// Solves E - e sin E = M for a batch of anomalies. The loop runs over the whole batch per Newton step, so the
+// stepping is branch-free within a pass and vectorizes where a vector sin/cos is available.
+void solveKeplerBatch(const double *mean_anomaly, const double *eccentricity, double *eccentric_anomaly, int count);
+
+class MeanElementsEphemeris : public Ephemeris
+{
+public:
+    MeanElementsEphemeris(const MeanElements &elements, double mu) : elements(elements), mu(mu) {}
+
+    void states(const double *jd, int count, double *r, double *v) const override;
+
+private:
+    MeanElements elements;
+    double mu;
+};
+
+// Piecewise Chebyshev fit of sampled states: one polynomial of the given degree per coordinate and segment,
+// least-squares fitted to the samples inside the segment. Positions and velocities are fitted separately.
+class ChebyshevEphemeris : public Ephemeris
+{
+public:
+    // Samples must be sorted by date; every segment needs at least degree + 1 of them, otherwise the result is
+    // not valid and evaluates to NaN.
+    static ChebyshevEphemeris fit(const double *jd, const double *r, const double *v, int count,
+                                  double segment_days, int degree);
+
+    void states(const double *jd, int count, double *r, double *v) const override;
+
+    bool isValid() const { return num_segments > 0; }
+    double startDate() const { return jd_start; }
+    double endDate() const { return jd_start + segment_days * num_segments; }
+
+private:
+    double jd_start = 0;
+    double segment_days = 1;
+    int degree = 0;
+    int num_segments = 0;
+    std::vector<double> coefficients;   // per segment: 6 coordinates x (degree + 1)
+};
+
+// Cubic Hermite interpolation between sampled states, for evaluating tabulated ephemerides (e.g. Horizons) off
+// their grid. Positions use the sampled velocities as end-point derivatives and velocities the two-body
+// acceleration -mu r / |r|^3, so both stay third order in the step. Samples must be sorted by date; outside
+// them the end intervals are extrapolated.
+class HermiteEphemeris : public Ephemeris
+{
+public:
+    HermiteEphemeris(const double *jd, const double *r, const double *v, int count, double mu);
+
+    void states(const double *jd, int count, double *r, double *v) const override;
+
+private:
+    std::vector<double> jd;
+    std::vector<double> r, v, a;    // 3 per sample
+};
+
+struct DateRange
+{
+    double start_jd;
+    double step_days;
+    int count;
+};
+
+// Number of steps from start to end inclusive, as Horizons counts them.
+DateRange dateRange(double start_jd, double end_jd, double step_days);
+
+// Fills jd (count), r and v (3 * count) for every date of the range.
+void sampleEphemeris(const Ephemeris &ephemeris, const DateRange &range, double *jd, double *r, double *v);
+
+// computePorkchopPlot_SIMD over date ranges, with the ephemerides evaluated in place of pre-sampled tables.
+void computePorkchopPlotRange(double mu, const Ephemeris &departure, const DateRange &departure_dates,
+                              const Ephemeris &arrival, const DateRange &arrival_dates,
+                              double departure_planet_mu, double arrival_planet_mu,
+                              double departure_orbit_radius, double arrival_orbit_radius,
+                              double *result_c3, double *result_dv1, double *result_total_dv);
+
+#endif //LAMBERT_EPHEMERIS_H
@@ -0,0 +1,251 @@
+#include "gooding1990.h"
+#include <cmath>
+
+// |1 - x^2| below which T(x) comes from the series about the parabola (Gooding's SW)
+constexpr double SERIES_SWITCH = 0.4;
+
+// starter constants of XLAMB
+constexpr double STARTER_C0 = 1.7;
+constexpr double STARTER_C1 = 0.5;
+constexpr double STARTER_C2 = 0.03;
+
+// q z - x, q z + x and z + q x with z = sqrt(qsqfm1 + q^2 x^2), each formed without cancellation; the
+// velocity components are proportional to them.
+static void goodingVelocityTerms(double q, double qsqfm1, double x, double &qzminx, double &qzplx, double &zplqx)
+{
+    double qsq = q * q;
+    double xsq = x * x;
+    double u = (1. - x) * (1. + x);
+    double z = std::sqrt(qsqfm1 + qsq * xsq);
+    double qx = q * x;
+
+    if (qx < 0)
+    {
+        qzminx = q * z - x;
+        zplqx = qsqfm1 / (z - qx);
+        qzplx = qsqfm1 * (qsq * u - xsq) / qzminx;
+    }
+    else
+    {
+        zplqx = z + qx;
+        qzplx = q * z + x;
+        qzminx = qx > 0 ? qsqfm1 * (qsq * u - xsq) / qzplx : q * z - x;
+    }
+}
+
+double goodingTimeOfFlight(double q, double qsqfm1, double x, int order, double &dt, double &d2t, double &d3t)
+{
+    bool l1 = order >= 1, l2 = order >= 2, l3 = order >= 3;
+
+    double qsq = q * q;
+    double xsq = x * x;
+    double u = (1. - x) * (1. + x);
+    double t;
+
+    dt = d2t = d3t = 0;
+
+    if (x < 0 || std::abs(u) > SERIES_SWITCH)
+    {
+        double y = std::sqrt(std::abs(u));
+        double z = std::sqrt(qsqfm1 + qsq * xsq);
+        double qx = q * x;
+
+        double a, b;
+        if (qx <= 0)
+        {
+            a = z - qx;
+            b = q * z - x;
+        }
+        else
+        {
+            a = qsqfm1 / (z + qx);
+            b = qsqfm1 * (qsq * u - xsq) / (q * z + x);
+        }
+
+        double g = qx * u >= 0 ? x * z + q * u : (xsq - qsq * u) / (x * z - q * u);
+        double f = a * y;
+
+        if (x <= 1)
+            t = std::atan2(f, g);
+        else if (f > SERIES_SWITCH)
+            t = std::log(f + g);
+        else
+        {
+            // 2 atanh(f / (g + 1)), summed directly where log(f + g) would lose digits
+            double fg1 = f / (g + 1.);
+            double fg1sq = fg1 * fg1;
+            double term = 2. * fg1;
+            double told;
+            t = term;
+            for (double twoi1 = 3.;; twoi1 += 2.)
+            {
+                term *= fg1sq;
+                told = t;
+                t += term / twoi1;
+                if (t == told)
+                    break;
+            }
+        }
+
+        t = 2. * (t / y + b) / u;
+
+        if (l1 && z != 0)
+        {
+            double qz = q / z;
+            double qz2 = qz * qz;
+            qz *= qz2;
+
+            dt = (3. * x * t - 4. * (a + qx * qsqfm1) / z) / u;
+            if (l2)
+                d2t = (3. * t + 5. * x * dt + 4. * qz * qsqfm1) / u;
+            if (l3)
+                d3t = (8. * dt + 7. * x * d2t - 12. * qz * qz2 * x * qsqfm1) / u;
+        }
+
+        return t;
+    }
+
+    // series in u about the parabola, summed until T stops changing
+    double u0i = 1., u1i = 1., u2i = 1., u3i = 1.;
+    double term = 4.;
+    double tq = q * qsqfm1;
+    double tqsum = q < 0.5 ? 1. - q * qsq : (1. / (1. + q) + q) * qsqfm1;
+    double ttmold = term / 3.;
+    double told;
+    t = ttmold * tqsum;
+
+    int i = 0;
+    do
+    {
+        ++i;
+        double p = i;
+
+        u0i *= u;
+        if (l1 && i > 1)
+            u1i *= u;
+        if (l2 && i > 2)
+            u2i *= u;
+        if (l3 && i > 3)
+            u3i *= u;
+
+        term *= (p - 0.5) / p;
+        tq *= qsq;
+        tqsum += tq;
+        told = t;
+
+        double tterm = term / (2. * p + 3.);
+        double tqterm = tterm * tqsum;
+        t -= u0i * ((1.5 * p + 0.25) * tqterm / (p * p - 0.25) - ttmold * tq);
+        ttmold = tterm;
+        tqterm *= p;
+
+        if (l1)
+            dt += tqterm * u1i;
+        if (l2)
+            d2t += tqterm * u2i * (p - 1.);
+        if (l3)
+            d3t += tqterm * u3i * (p - 1.) * (p - 2.);
+    } while (i < order || t != told);
+
+    if (l3)
+        d3t = 8. * x * (1.5 * d2t - xsq * d3t);
+    if (l2)
+        d2t = 2. * (2. * xsq * d2t - dt);
+    if (l1)
+        dt = -2. * x * dt;
+
+    return t / xsq;
+}
+
+// Gooding's starter for zero revolutions: T(0) splits the elliptic and hyperbolic sides, each with a bilinear
+// approximation of x(T).
+static double goodingStarter(double q, double qsqfm1, double T)
+{
+    double dt, d2t, d3t;
+    double t0 = goodingTimeOfFlight(q, qsqfm1, 0., 0, dt, d2t, d3t);
+    double tdiff = T - t0;
+
+    // dT/dx = -4 at x = 0
+    if (tdiff <= 0)
+        return t0 * tdiff / (-4. * T);
+
+    double thr2 = std::atan2(qsqfm1, 2. * q) / M_PI;
+    double x = -tdiff / (tdiff + 4.);
+    double w = x + STARTER_C0 * std::sqrt(2. * (1. - thr2));
+    if (w < 0)
+        x -= std::sqrt(std::sqrt(std::sqrt(std::sqrt(-w)))) * (x + std::sqrt(tdiff / (tdiff + 1.5 * t0)));
+
+    w = 4. / (4. + tdiff);
+    return x * (1. + x * (STARTER_C1 * w - STARTER_C2 * x * std::sqrt(w)));
+}
+
+bool gooding1990(double mu, const TransferGeometry &g, vec3d &r1, vec3d &r2, double tof, bool shortPath,
+                 vec3d &v1, vec3d &v2, int maxIter, double atol)
+{
+    if (g.degenerate)
+        return false;
+
+    double s = g.semiperimeter;
+    double gms = std::sqrt(mu * s / 2.);
+    double q = std::sqrt(g.r1_norm * g.r2_norm) * std::cos(0.5 * g.theta0) / s;
+    if (!shortPath)
+        q = -q;
+    double qsqfm1 = g.c_norm / s;
+    double T = 4. * gms * tof / (s * s);
+
+    double x = goodingStarter(q, qsqfm1, T);
+
+    int i = 0;
+    bool converged = false;
+    while (i < maxIter)
+    {
+        double dt, d2t, d3t;
+        double delta = T - goodingTimeOfFlight(q, qsqfm1, x, 2, dt, d2t, d3t);
+        ++i;
+        if (dt == 0)
+            break;
+
+        // Halley
+        double step = delta * dt / (dt * dt + delta * d2t / 2.);
+        x += step;
+
+        if (std::abs(step) <= atol)
+        {
+            converged = true;
+            break;
+        }
+    }
+
+#ifdef LAMBERT_INSTRUMENT
+    SolveTrace &trace = solveTrace();
+    ++trace.solves;
+    trace.iterations += i;
+    trace.not_converged += !converged;
+#endif
+
+    if (!converged || !std::isfinite(x))
+        return false;
+
+    double qzminx, qzplx, zplqx;
+    goodingVelocityTerms(q, qsqfm1, x, qzminx, qzplx, zplqx);
+
+    // sigma = sqrt(1 - rho^2), from the angle so it keeps its digits when r1 and r2 are nearly equal
+    double rho = (g.r1_norm - g.r2_norm) / g.c_norm;
+    double sigma = 2. * std::sqrt(g.r1_norm * g.r2_norm) * std::sin(0.5 * g.theta0) / g.c_norm;
+
+    double vr1 = gms * (qzminx - qzplx * rho) / g.r1_norm;
+    double vr2 = -gms * (qzminx + qzplx * rho) / g.r2_norm;
+    double vt = gms * zplqx * sigma;
+
+    // the long path runs against r1 x r2
+    vec3d ir1 = r1 / g.r1_norm;
+    vec3d ir2 = r2 / g.r2_norm;
+    vec3d ih = ir1.cross(ir2).normalized();
+    if (!shortPath)
+        ih = -ih;
+
+    v1 = vr1 * ir1 + vt / g.r1_norm * ih.cross(ir1);
+    v2 = vr2 * ir2 + vt / g.r2_norm * ih.cross(ir2);
+
+    return true;
+}
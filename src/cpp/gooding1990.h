@@ -0,0 +1,21 @@
+#ifndef LAMBERT_GOODING1990_H
+#define LAMBERT_GOODING1990_H
+
+#include "battin1984.h"
+
+// Zero-revolution Lambert solver after Gooding (1990), "A procedure for the solution of Lambert's orbital
+// boundary-value problem". Halley iterations on T(x) from Gooding's bilinear starter, which is accurate enough
+// that two or three steps reach machine precision in every regime; T(x) switches to a series near the parabola.
+//
+// Variables as in the paper: q = sqrt(r1 r2) cos(theta / 2) / s (negative on the long path), qsqfm1 = 1 - q^2 =
+// c / s and the nondimensional T = sqrt(8 mu / s^3) tof.
+
+// T(x) and its first `order` derivatives (0 to 3); the unrequested ones are left at 0.
+double goodingTimeOfFlight(double q, double qsqfm1, double x, int order, double &dt, double &d2t, double &d3t);
+
+// Single branch; returns false when r1 and r2 are collinear, where the transfer plane is undefined, or when the
+// Halley iteration does not converge within maxIter.
+bool gooding1990(double mu, const TransferGeometry &g, vec3d &r1, vec3d &r2, double tof, bool shortPath,
+                 vec3d &v1, vec3d &v2, int maxIter = 8, double atol = 1e-7);
+
+#endif //LAMBERT_GOODING1990_H
@@ -0,0 +1,101 @@
+#ifndef LAMBERT_INSTRUMENTATION_H
+#define LAMBERT_INSTRUMENTATION_H
+
+// Hot-path instrumentation, compiled in only with -DLAMBERT_INSTRUMENT (CMake option LAMBERT_INSTRUMENT).
+// Without it none of the recording code exists and PorkchopInstrumentation is left untouched.
+//
+// The solver writes into a thread-local SolveTrace; the porkchop loops reset it before each cell and copy it
+// into the caller's grids afterwards.
+
+struct InstrumentationCounters
+{
+    long long cells = 0;
+    long long solves = 0;
+    long long iterations = 0;
+    long long not_converged = 0;    // solves that hit maxIter
+    int max_iterations = 0;         // per cell
+    int max_xi_depth = 0;
+    int max_k_depth = 0;
+    long long tiles = 0;
+    double tile_seconds = 0;
+    double max_tile_seconds = 0;
+
+    InstrumentationCounters &operator+=(const InstrumentationCounters &other)
+    {
+        cells += other.cells;
+        solves += other.solves;
+        iterations += other.iterations;
+        not_converged += other.not_converged;
+        max_iterations = max_iterations > other.max_iterations ? max_iterations : other.max_iterations;
+        max_xi_depth = max_xi_depth > other.max_xi_depth ? max_xi_depth : other.max_xi_depth;
+        max_k_depth = max_k_depth > other.max_k_depth ? max_k_depth : other.max_k_depth;
+        tiles += other.tiles;
+        tile_seconds += other.tile_seconds;
+        max_tile_seconds = max_tile_seconds > other.max_tile_seconds ? max_tile_seconds : other.max_tile_seconds;
+        return *this;
+    }
+};
+
+// Auxiliary outputs of an instrumented porkchop run. Every grid is optional and has the layout of the result
+// grids (departure-major); tile_seconds has one entry per tile in row-major tile order.
+struct PorkchopInstrumentation
+{
+    int *iterations = nullptr;          // summed over the short- and long-path solve
+    unsigned char *converged = nullptr; // 1 when every solve of the cell converged
+    int *xi_depth = nullptr;            // deepest xi continued fraction evaluated in the cell
+    int *k_depth = nullptr;             // deepest K continued fraction evaluated in the cell
+    double *tile_seconds = nullptr;
+
+    InstrumentationCounters counters;
+};
+
+#ifdef LAMBERT_INSTRUMENT
+
+constexpr bool LAMBERT_INSTRUMENTED = true;
+
+struct SolveTrace
+{
+    int solves = 0;
+    int iterations = 0;
+    int not_converged = 0;
+    int xi_depth = 0;
+    int k_depth = 0;
+    int last_cf_depth = 0;  // set by evaluateContinuedFraction, folded into xi_depth / k_depth by the caller
+};
+
+inline SolveTrace &solveTrace()
+{
+    thread_local SolveTrace trace;
+    return trace;
+}
+
+// Copies the trace of the cell just solved into the grids and counters.
+inline void recordCell(PorkchopInstrumentation &instrumentation, InstrumentationCounters &counters, long long index)
+{
+    const SolveTrace &trace = solveTrace();
+
+    if (instrumentation.iterations)
+        instrumentation.iterations[index] = trace.iterations;
+    if (instrumentation.converged)
+        instrumentation.converged[index] = trace.not_converged == 0;
+    if (instrumentation.xi_depth)
+        instrumentation.xi_depth[index] = trace.xi_depth;
+    if (instrumentation.k_depth)
+        instrumentation.k_depth[index] = trace.k_depth;
+
+    ++counters.cells;
+    counters.solves += trace.solves;
+    counters.iterations += trace.iterations;
+    counters.not_converged += trace.not_converged;
+    counters.max_iterations = counters.max_iterations > trace.iterations ? counters.max_iterations : trace.iterations;
+    counters.max_xi_depth = counters.max_xi_depth > trace.xi_depth ? counters.max_xi_depth : trace.xi_depth;
+    counters.max_k_depth = counters.max_k_depth > trace.k_depth ? counters.max_k_depth : trace.k_depth;
+}
+
+#else
+
+constexpr bool LAMBERT_INSTRUMENTED = false;
+
+#endif
+
+#endif //LAMBERT_INSTRUMENTATION_H
@@ -0,0 +1,402 @@
+#include "izzo2015.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+Izzo2015Geometry getIzzoGeometry(double mu, const TransferGeometry &g, vec3d &r1, vec3d &r2, bool shortPath)
+{
+    Izzo2015Geometry geometry;
+    geometry.r1_norm = g.r1_norm;
+    geometry.r2_norm = g.r2_norm;
+    geometry.c_norm = g.c_norm;
+    geometry.semiperimeter = g.semiperimeter;
+    geometry.tof_scale = std::sqrt(2. * mu / std::pow(g.semiperimeter, 3));
+    geometry.degenerate = g.degenerate;
+
+    double lambda = std::sqrt(std::max(0., 1. - g.c_norm / g.semiperimeter));
+    geometry.lambda = shortPath ? lambda : -lambda;
+
+    geometry.ir1 = r1 / g.r1_norm;
+    geometry.ir2 = r2 / g.r2_norm;
+
+    if (g.degenerate)
+    {
+        geometry.it1 = vec3d::Zero();
+        geometry.it2 = vec3d::Zero();
+        return geometry;
+    }
+
+    // the long side goes around the other way
+    vec3d ih = geometry.ir1.cross(geometry.ir2).normalized();
+    if (!shortPath)
+        ih = -ih;
+
+    geometry.it1 = ih.cross(geometry.ir1).normalized();
+    geometry.it2 = ih.cross(geometry.ir2).normalized();
+
+    return geometry;
+}
+
+double hypergeometricF(double z, double tol)
+{
+    double sj = 1., cj = 1., err = 1.;
+    int j = 0;
+
+    while (err > tol)
+    {
+        cj = cj * (3. + j) * (1. + j) / (2.5 + j) * z / (j + 1);
+        sj = sj + cj;
+        err = std::abs(cj);
+        ++j;
+    }
+
+    return sj;
+}
+
+// Lagrange form, used away from x = 1.
+double izzoTimeOfFlightLagrange(double lambda, double x, int nRev)
+{
+    double a = 1. / (1. - x * x);
+
+    if (a > 0)
+    {
+        double alpha = 2. * std::acos(x);
+        double beta = 2. * std::asin(std::sqrt(lambda * lambda / a));
+        if (lambda < 0)
+            beta = -beta;
+        return a * std::sqrt(a) * ((alpha - std::sin(alpha)) - (beta - std::sin(beta)) + 2. * M_PI * nRev) / 2.;
+    }
+
+    double alpha = 2. * std::acosh(x);
+    double beta = 2. * std::asinh(std::sqrt(-lambda * lambda / a));
+    if (lambda < 0)
+        beta = -beta;
+    return -a * std::sqrt(-a) * ((beta - std::sinh(beta)) - (alpha - std::sinh(alpha))) / 2.;
+}
+
+double izzoTimeOfFlight(double lambda, double x, int nRev)
+{
+    const double BATTIN_DISTANCE = 0.01;
+    const double LAGRANGE_DISTANCE = 0.2;
+
+    double distance = std::abs(x - 1.);
+    if (distance < LAGRANGE_DISTANCE && distance > BATTIN_DISTANCE)
+        return izzoTimeOfFlightLagrange(lambda, x, nRev);
+
+    double k = lambda * lambda;
+    double e = x * x - 1.;
+    double rho = std::abs(e);
+    double z = std::sqrt(1. + k * e);
+
+    if (distance < BATTIN_DISTANCE)
+    {
+        // Battin's series near the parabola
+        double eta = z - lambda * x;
+        double s1 = 0.5 * (1. - lambda - x * eta);
+        double q = 4. / 3. * hypergeometricF(s1, 1e-11);
+        double t = (eta * eta * eta * q + 4. * lambda * eta) / 2.;
+        // rho vanishes on the parabola itself, which only N = 0 reaches
+        return nRev > 0 ? t + nRev * M_PI / std::pow(rho, 1.5) : t;
+    }
+
+    // Lancaster
+    double y = std::sqrt(rho);
+    double g = x * z - lambda * e;
+    double d;
+    if (e < 0)
+        d = nRev * M_PI + std::acos(g);
+    else
+        d = std::log(y * (z - lambda * x) + g);
+
+    return (x - lambda * z - d / y) / e;
+}
+
+void izzoDerivatives(double lambda, double x, double T, double &dt, double &ddt, double &dddt)
+{
+    double l2 = lambda * lambda;
+    double l3 = l2 * lambda;
+    double umx2 = 1. - x * x;
+    double y = std::sqrt(1. - l2 * umx2);
+    double y2 = y * y;
+    double y3 = y2 * y;
+
+    dt = 1. / umx2 * (3. * T * x - 2. + 2. * l3 * x / y);
+    ddt = 1. / umx2 * (3. * T + 5. * x * dt + 2. * (1. - l2) * l3 / y3);
+    dddt = 1. / umx2 * (7. * x * ddt + 8. * dt - 6. * (1. - l2) * l2 * l3 * x / y3 / y2);
+}
+
+// Householder iterations on T(x) = T; returns the number of iterations performed.
+int izzoHouseholder(double lambda, double T, int nRev, int maxIter, double atol, double &x)
+{
+    int i = 0;
+    double err = 1.;
+
+    while (err > atol && i < maxIter)
+    {
+        double tof = izzoTimeOfFlight(lambda, x, nRev);
+        double dt, ddt, dddt;
+        izzoDerivatives(lambda, x, tof, dt, ddt, dddt);
+
+        double delta = tof - T;
+        double dt2 = dt * dt;
+        double x_new = x - delta * (dt2 - delta * ddt / 2.) / (dt * (dt2 - delta * ddt) + dddt * delta * delta / 6.);
+
+        err = std::abs(x - x_new);
+        x = x_new;
+        ++i;
+    }
+
+#ifdef LAMBERT_INSTRUMENT
+    SolveTrace &trace = solveTrace();
+    ++trace.solves;
+    trace.iterations += i;
+    trace.not_converged += !(err <= atol);
+#endif
+
+    return i;
+}
+
+double izzoMinimumTof(Izzo2015Geometry &geometry, int nRev)
+{
+    // allocated on first use, so zero-revolution solves never pay for it
+    if (geometry.t_min.empty())
+        geometry.t_min.assign(MAX_REVS_LIMIT + 1, std::numeric_limits<double>::quiet_NaN());
+    else if (std::isfinite(geometry.t_min[nRev]))
+        return geometry.t_min[nRev];
+
+    double lambda = geometry.lambda;
+
+    // Halley iterations on dT/dx = 0, starting from x = 0
+    double x = 0.;
+    double t_min = izzoTimeOfFlight(lambda, x, nRev);
+
+    for (int i = 0; i < 12; ++i)
+    {
+        double dt, ddt, dddt;
+        izzoDerivatives(lambda, x, t_min, dt, ddt, dddt);
+        if (dt == 0.)
+            break;
+
+        double x_new = x - dt * ddt / (ddt * ddt - dt * dddt / 2.);
+        double err = std::abs(x - x_new);
+
+        x = x_new;
+        t_min = izzoTimeOfFlight(lambda, x, nRev);
+
+        if (err < 1e-13)
+            break;
+    }
+
+    geometry.t_min[nRev] = t_min;
+    return t_min;
+}
+
+bool izzoFeasible(Izzo2015Geometry &geometry, double T, int nRev)
+{
+    // T(x) falls monotonically from infinity to 0 without revolutions
+    if (nRev == 0)
+        return T > 0;
+
+    if (T < nRev * M_PI)
+        return false;
+
+    // T(0) bounds the minimum from above, so the iteration is only needed below it
+    double lambda = geometry.lambda;
+    double t00 = std::acos(lambda) + lambda * std::sqrt(1. - lambda * lambda);
+    if (T >= t00 + nRev * M_PI)
+        return true;
+
+    return T >= izzoMinimumTof(geometry, nRev);
+}
+
+int izzoMaxRevolutions(Izzo2015Geometry &geometry, double tof, int maxRevs)
+{
+    if (geometry.degenerate)
+        return 0;
+
+    double T = geometry.tof_scale * tof;
+    int nMax = std::min({maxRevs, MAX_REVS_LIMIT, static_cast<int>(T / M_PI)});
+
+    while (nMax > 0 && !izzoFeasible(geometry, T, nMax))
+        --nMax;
+
+    return nMax;
+}
+
+// Izzo's initial guess for N = 0: power laws in T through T(0) and the parabolic T(1), and a Taylor
+// expansion about the parabola below it.
+static double izzoZeroRevStarter(double lambda, double T)
+{
+    double t00 = std::acos(lambda) + lambda * std::sqrt(1. - lambda * lambda);
+    double t1 = 2. / 3. * (1. - lambda * lambda * lambda);
+
+    if (T >= t00)
+        return std::pow(t00 / T, 2. / 3.) - 1.;
+    if (T < t1)
+        return 5. / 2. * t1 / T * (t1 - T) / (1. - std::pow(lambda, 5)) + 1.;
+    // runs from x = 0 at T(0) to x = 1 at the parabola
+    return std::exp2(std::log(T / t00) / std::log(t1 / t00)) - 1.;
+}
+
+bool izzo2015(Izzo2015Geometry &geometry, double mu, double tof, int nRev, bool rightBranch,
+              vec3d &v1, vec3d &v2, int maxIter, double atol)
+{
+    if (geometry.degenerate || nRev < 0 || nRev > MAX_REVS_LIMIT)
+        return false;
+
+    double T = geometry.tof_scale * tof;
+    if (!izzoFeasible(geometry, T, nRev))
+        return false;
+
+    double x;
+    if (nRev == 0)
+        x = izzoZeroRevStarter(geometry.lambda, T);
+    else if (rightBranch)
+    {
+        double tmp = std::pow(8. * T / (nRev * M_PI), 2. / 3.);
+        x = (tmp - 1.) / (tmp + 1.);
+    }
+    else
+    {
+        double tmp = std::pow((nRev * M_PI + M_PI) / (8. * T), 2. / 3.);
+        x = (tmp - 1.) / (tmp + 1.);
+    }
+
+    izzoHouseholder(geometry.lambda, T, nRev, maxIter, atol, x);
+    if (!std::isfinite(x))
+        return false;
+
+    double lambda = geometry.lambda;
+    double gamma = std::sqrt(mu * geometry.semiperimeter / 2.);
+    double rho = (geometry.r1_norm - geometry.r2_norm) / geometry.c_norm;
+    double sigma = std::sqrt(1. - rho * rho);
+    double y = std::sqrt(1. - lambda * lambda + lambda * lambda * x * x);
+
+    double vr1 = gamma * ((lambda * y - x) - rho * (lambda * y + x)) / geometry.r1_norm;
+    double vr2 = -gamma * ((lambda * y - x) + rho * (lambda * y + x)) / geometry.r2_norm;
+    double vt = gamma * sigma * (y + lambda * x);
+
+    v1 = vr1 * geometry.ir1 + vt / geometry.r1_norm * geometry.it1;
+    v2 = vr2 * geometry.ir2 + vt / geometry.r2_norm * geometry.it2;
+
+    return true;
+}
+
+std::vector<LambertSolution> lambertMultiRev(double mu, vec3d &r1, vec3d &r2, double tof, int maxRevs)
+{
+    std::vector<LambertSolution> solutions;
+
+    TransferGeometry g = getTransferGeometry(r1, r2, r1.norm());
+    LambertBranches branches = battin1984Branches(mu, g, r1, r2, tof);
+
+    solutions.push_back({branches.v1_short, branches.v2_short, 0, true, false});
+    solutions.push_back({branches.v1_long, branches.v2_long, 0, false, false});
+
+    for (bool shortPath: {true, false})
+    {
+        Izzo2015Geometry geometry = getIzzoGeometry(mu, g, r1, r2, shortPath);
+        int nMax = izzoMaxRevolutions(geometry, tof, maxRevs);
+
+        for (int n = 1; n <= nMax; ++n)
+        {
+            for (bool rightBranch: {false, true})
+            {
+                LambertSolution solution{vec3d::Zero(), vec3d::Zero(), n, shortPath, rightBranch};
+                if (izzo2015(geometry, mu, tof, n, rightBranch, solution.v1, solution.v2))
+                    solutions.push_back(solution);
+            }
+        }
+    }
+
+    return solutions;
+}
+
+void computePorkchopCellMultiRev(double mu, vec3d &r1_departure, double r1_norm, const vec3d &v1_departure,
+                                 vec3d &r2_arrival, const vec3d &v2_arrival,
+                                 double departure_time, double arrival_time,
+                                 double v_orbit_dep, double v_orbit_arr, int maxRevs,
+                                 double &c3, double &dv1, double &total_dv, int &n_rev,
+                                 WarmStart *warm, IterationStats *stats, LambertBackend backend)
+{
+    computePorkchopCell(mu, r1_departure, r1_norm, v1_departure, r2_arrival, v2_arrival,
+                        departure_time, arrival_time, v_orbit_dep, v_orbit_arr, c3, dv1, total_dv, warm, stats,
+                        backend);
+    n_rev = 0;
+
+    if (maxRevs < 1 || total_dv == INVALID_MARKER)
+        return;
+
+    double tof = arrival_time - departure_time;
+    if (arrival_time <= departure_time || tof < MIN_TOF)
+        return;
+
+    TransferGeometry g = getTransferGeometry(r1_departure, r2_arrival, r1_norm);
+
+    for (bool shortPath: {true, false})
+    {
+        Izzo2015Geometry geometry = getIzzoGeometry(mu, g, r1_departure, r2_arrival, shortPath);
+        int nMax = izzoMaxRevolutions(geometry, tof, maxRevs);
+
+        for (int n = 1; n <= nMax; ++n)
+        {
+            for (bool rightBranch: {false, true})
+            {
+                vec3d v1_transfer, v2_transfer;
+                if (!izzo2015(geometry, mu, tof, n, rightBranch, v1_transfer, v2_transfer))
+                    continue;
+
+                double c3_departure = (v1_transfer - v1_departure).squaredNorm();
+                double c3_clamped = std::min(c3_departure, MAX_C3_CUTOFF);
+                double dv1_candidate = std::sqrt(2 * v_orbit_dep * v_orbit_dep + c3_clamped) - v_orbit_dep;
+
+                double c3_arrival = (v2_arrival - v2_transfer).squaredNorm();
+                double dv2 = std::sqrt(2 * v_orbit_arr * v_orbit_arr + c3_arrival) - v_orbit_arr;
+
+                double total_dv_candidate = dv1_candidate + dv2;
+
+                if (total_dv_candidate < total_dv)
+                {
+                    c3 = c3_clamped;
+                    dv1 = std::min(dv1_candidate, MAX_DV_CUTOFF);
+                    total_dv = std::min(total_dv_candidate, MAX_DV_CUTOFF);
+                    n_rev = n;
+                }
+            }
+        }
+    }
+}
+
+void computePorkchopPlotMultiRev(double mu, const double *r1, const double *v1, const double *r2, const double *v2,
+                                 const double *d1, const double *d2, int num_departure_dates, int num_arrival_dates,
+                                 double departure_planet_mu, double arrival_planet_mu,
+                                 double departure_orbit_radius, double arrival_orbit_radius, int max_revs,
+                                 double *result_c3, double *result_dv1, double *result_total_dv, int *result_nrev)
+{
+    double v_orbit_dep = std::sqrt(departure_planet_mu / departure_orbit_radius);
+    double v_orbit_arr = std::sqrt(arrival_planet_mu / arrival_orbit_radius);
+
+    for (int i = 0; i < num_departure_dates; ++i)
+    {
+        double departure_time = julianDateToSeconds(d1[i]);
+        vec3d r1_departure = {r1[i * 3], r1[i * 3 + 1], r1[i * 3 + 2]};
+        vec3d v1_departure = {v1[i * 3], v1[i * 3 + 1], v1[i * 3 + 2]};
+        double r1_norm = r1_departure.norm();
+
+        for (int j = 0; j < num_arrival_dates; ++j)
+        {
+            vec3d r2_arrival = {r2[j * 3], r2[j * 3 + 1], r2[j * 3 + 2]};
+            vec3d v2_arrival = {v2[j * 3], v2[j * 3 + 1], v2[j * 3 + 2]};
+
+            int index = i * num_arrival_dates + j;
+            int n_rev;
+
+            computePorkchopCellMultiRev(mu, r1_departure, r1_norm, v1_departure, r2_arrival, v2_arrival,
+                                        departure_time, julianDateToSeconds(d2[j]), v_orbit_dep, v_orbit_arr,
+                                        max_revs, result_c3[index], result_dv1[index], result_total_dv[index],
+                                        n_rev);
+
+            if (result_nrev)
+                result_nrev[index] = n_rev;
+        }
+    }
+}
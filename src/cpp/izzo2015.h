@@ -0,0 +1,77 @@
+#ifndef LAMBERT_IZZO2015_H
+#define LAMBERT_IZZO2015_H
+
+#include "battin1984.h"
+#include <vector>
+
+// Lambert solver after Izzo (2015), "Revisiting Lambert's problem": Householder iterations on T(x). For N >= 1
+// every feasible revolution count has a left (x below the minimum-time point) and a right branch; N = 0 has a
+// single solution per side and is one of the zero-revolution backends of lambert_solver.h.
+
+constexpr int MAX_REVS_LIMIT = 64;
+
+// Geometry of one side of the transfer (short: angle below pi, long: above pi) in Izzo's frame, with the
+// per-N minimum time of flight cached so that the branches of every TOF reuse it.
+struct Izzo2015Geometry
+{
+    double lambda;          // negative for the long side
+    double r1_norm;
+    double r2_norm;
+    double c_norm;
+    double semiperimeter;
+    double tof_scale;       // nondimensional T = tof_scale * tof
+    vec3d ir1;
+    vec3d ir2;
+    vec3d it1;
+    vec3d it2;
+    bool degenerate;
+    std::vector<double> t_min;  // nondimensional minimum TOF per N, NaN until computed; empty until first needed
+};
+
+Izzo2015Geometry getIzzoGeometry(double mu, const TransferGeometry &g, vec3d &r1, vec3d &r2, bool shortPath);
+
+// Nondimensional time of flight T(x) on revolution N.
+double izzoTimeOfFlight(double lambda, double x, int nRev);
+
+// Minimum nondimensional TOF of revolution nRev >= 1, computed on first use.
+double izzoMinimumTof(Izzo2015Geometry &geometry, int nRev);
+
+// Largest revolution count that is feasible for `tof`, at most maxRevs; infeasible N are rejected from
+// T < N * pi or the cached minimum without any Householder iteration.
+int izzoMaxRevolutions(Izzo2015Geometry &geometry, double tof, int maxRevs);
+
+// Single branch; returns false when revolution nRev is infeasible for `tof`. rightBranch is ignored for nRev = 0.
+bool izzo2015(Izzo2015Geometry &geometry, double mu, double tof, int nRev, bool rightBranch,
+              vec3d &v1, vec3d &v2, int maxIter = 15, double atol = 1e-8);
+
+struct LambertSolution
+{
+    vec3d v1;
+    vec3d v2;
+    int nRev;
+    bool shortPath;
+    bool rightBranch;   // N >= 1 only
+};
+
+// Every feasible solution with up to maxRevs revolutions: both zero-revolution paths, then the left and
+// right branch of each feasible N on both sides.
+std::vector<LambertSolution> lambertMultiRev(double mu, vec3d &r1, vec3d &r2, double tof, int maxRevs);
+
+// computePorkchopCell over all solutions up to maxRevs, keeping the lowest total dv; n_rev reports where it
+// came from. backend solves the zero-revolution pair.
+void computePorkchopCellMultiRev(double mu, vec3d &r1_departure, double r1_norm, const vec3d &v1_departure,
+                                 vec3d &r2_arrival, const vec3d &v2_arrival,
+                                 double departure_time, double arrival_time,
+                                 double v_orbit_dep, double v_orbit_arr, int maxRevs,
+                                 double &c3, double &dv1, double &total_dv, int &n_rev,
+                                 WarmStart *warm = nullptr, IterationStats *stats = nullptr,
+                                 LambertBackend backend = LAMBERT_BATTIN);
+
+void computePorkchopPlotMultiRev(double mu, const double *r1, const double *v1, const double *r2, const double *v2,
+                                 const double *d1, const double *d2, int num_departure_dates, int num_arrival_dates,
+                                 double departure_planet_mu, double arrival_planet_mu,
+                                 double departure_orbit_radius, double arrival_orbit_radius, int max_revs,
+                                 double *result_c3, double *result_dv1, double *result_total_dv,
+                                 int *result_nrev = nullptr);
+
+#endif //LAMBERT_IZZO2015_H
@@ -0,0 +1,112 @@
+#ifndef LAMBERT_KEPLER_PROPAGATOR_H
+#define LAMBERT_KEPLER_PROPAGATOR_H
+
+#include <Eigen/Dense>
+#include <cmath>
+
+// Two-body propagation in universal variables (Vallado, Algorithm 8). Elliptic arcs are reduced modulo the
+// period first and the Newton iteration is bracketed by [0, 2 pi / sqrt(alpha)], which keeps it convergent
+// on the near-radial orbits that multi-revolution transfers produce.
+
+struct KeplerState
+{
+    Eigen::Vector3d r;
+    Eigen::Vector3d v;
+};
+
+inline void stumpff(double z, double &c2, double &c3)
+{
+    if (z > 1e-6)
+    {
+        double sz = std::sqrt(z);
+        c2 = (1. - std::cos(sz)) / z;
+        c3 = (sz - std::sin(sz)) / (sz * z);
+    }
+    else if (z < -1e-6)
+    {
+        double sz = std::sqrt(-z);
+        c2 = (1. - std::cosh(sz)) / z;
+        c3 = (std::sinh(sz) - sz) / (sz * -z);
+    }
+    else
+    {
+        c2 = 1. / 2. - z / 24. + z * z / 720.;
+        c3 = 1. / 6. - z / 120. + z * z / 5040.;
+    }
+}
+
+inline KeplerState propagateKepler(double mu, const Eigen::Vector3d &r0, const Eigen::Vector3d &v0, double dt,
+                                   int maxIter = 100, double atol = 1e-13)
+{
+    double r0_norm = r0.norm();
+    double sqrt_mu = std::sqrt(mu);
+    double rv = r0.dot(v0);
+    double alpha = 2. / r0_norm - v0.squaredNorm() / mu;
+
+    bool elliptic = alpha > 1e-12;
+    double chi_low = 0., chi_high = 0.;
+
+    if (elliptic)
+    {
+        double period = 2. * M_PI / (sqrt_mu * std::pow(alpha, 1.5));
+        dt = std::fmod(dt, period);
+        if (dt < 0)
+            dt += period;
+        chi_high = 2. * M_PI / std::sqrt(alpha);
+    }
+
+    double chi;
+    if (elliptic)
+        chi = sqrt_mu * dt * alpha;
+    else if (alpha < -1e-12)
+    {
+        double a = 1. / alpha;
+        double sign = dt >= 0 ? 1. : -1.;
+        chi = sign * std::sqrt(-a) * std::log(-2. * mu * alpha * dt /
+                                              (rv + sign * std::sqrt(-mu * a) * (1. - r0_norm * alpha)));
+    }
+    else
+        chi = sqrt_mu * dt / r0_norm;
+
+    double c2 = 0., c3 = 0., r_norm = r0_norm, z = 0.;
+    for (int i = 0; i < maxIter; ++i)
+    {
+        z = chi * chi * alpha;
+        stumpff(z, c2, c3);
+
+        r_norm = chi * chi * c2 + rv / sqrt_mu * chi * (1. - z * c3) + r0_norm * (1. - z * c2);
+        double f = sqrt_mu * dt - chi * chi * chi * c3 - rv / sqrt_mu * chi * chi * c2 - r0_norm * chi * (1. - z * c3);
+        double step = f / r_norm;
+        double chi_next = chi + step;
+
+        if (elliptic)
+        {
+            // f decreases monotonically in chi
+            if (f > 0)
+                chi_low = chi;
+            else
+                chi_high = chi;
+
+            if (!(chi_next > chi_low && chi_next < chi_high))
+                chi_next = 0.5 * (chi_low + chi_high);
+        }
+
+        step = chi_next - chi;
+        chi = chi_next;
+        if (std::abs(step) <= atol * std::max(1., std::abs(chi)))
+            break;
+    }
+
+    z = chi * chi * alpha;
+    stumpff(z, c2, c3);
+    r_norm = chi * chi * c2 + rv / sqrt_mu * chi * (1. - z * c3) + r0_norm * (1. - z * c2);
+
+    double f = 1. - chi * chi / r0_norm * c2;
+    double g = dt - chi * chi * chi / sqrt_mu * c3;
+    double g_dot = 1. - chi * chi / r_norm * c2;
+    double f_dot = sqrt_mu / (r_norm * r0_norm) * chi * (z * c3 - 1.);
+
+    return {f * r0 + g * v0, f_dot * r0 + g_dot * v0};
+}
+
+#endif //LAMBERT_KEPLER_PROPAGATOR_H
@@ -0,0 +1,281 @@
+#include "lambert_sensitivity.h"
+#include "lambert_solver.h"
+#include <cmath>
+#include <algorithm>
+
+constexpr double SECONDS_PER_DAY = 86400.0;
+
+// |z| below which the Stumpff functions are summed as series; above it the closed forms lose at most a digit
+constexpr double STUMPFF_SERIES_LIMIT = 4.0;
+
+// d r2 / d v1 counts as singular below this reciprocal condition estimate
+constexpr double MIN_RCOND = 1e-12;
+
+typedef Eigen::Matrix<double, 1, 6> grad6d;
+
+// Stumpff functions c0 ... c5 of z = alpha chi^2, c_k(z) = sum_n (-z)^n / (2n + k)!.
+static void stumpff6(double z, double c[6])
+{
+    if (std::abs(z) < STUMPFF_SERIES_LIMIT)
+    {
+        for (int k = 0; k < 6; ++k)
+        {
+            double term = 1.;
+            for (int i = 2; i <= k; ++i)
+                term /= i;
+
+            double sum = term;
+            for (int n = 1; n < 30; ++n)
+            {
+                term *= -z / ((2 * n + k - 1) * (2 * n + k));
+                double next = sum + term;
+                if (next == sum)
+                    break;
+                sum = next;
+            }
+            c[k] = sum;
+        }
+        return;
+    }
+
+    if (z > 0)
+    {
+        double sz = std::sqrt(z);
+        c[0] = std::cos(sz);
+        c[1] = std::sin(sz) / sz;
+    }
+    else
+    {
+        double sz = std::sqrt(-z);
+        c[0] = std::cosh(sz);
+        c[1] = std::sinh(sz) / sz;
+    }
+
+    c[2] = (1. - c[0]) / z;
+    c[3] = (1. - c[1]) / z;
+    c[4] = (1. / 2. - c[2]) / z;
+    c[5] = (1. / 6. - c[3]) / z;
+}
+
+mat6d keplerTransitionMatrix(double mu, const vec3d &r1, const vec3d &v1, const vec3d &r2, const vec3d &v2,
+                             double tof)
+{
+    double sqrt_mu = std::sqrt(mu);
+    double r0 = r1.norm();
+    double sigma0 = r1.dot(v1) / sqrt_mu;
+    double alpha = 2. / r0 - v1.squaredNorm() / mu;
+
+    // Kepler's equation and sigma = r v / sqrt(mu) at both ends give chi without iterating
+    double chi = alpha * sqrt_mu * tof + r2.dot(v2) / sqrt_mu - sigma0;
+
+    // universal functions U_k = chi^k c_k(alpha chi^2) and their alpha-derivatives at fixed chi
+    double c[6];
+    stumpff6(alpha * chi * chi, c);
+
+    double U[6];
+    double chi_k = 1.;
+    for (int k = 0; k < 6; ++k)
+    {
+        U[k] = chi_k * c[k];
+        chi_k *= chi;
+    }
+
+    double U_alpha[4];
+    for (int k = 0; k < 4; ++k)
+        U_alpha[k] = -0.5 * (chi * U[k + 1] - k * U[k + 2]);
+
+    double r = r0 * U[0] + sigma0 * U[1] + U[2];
+
+    // gradients with respect to the initial state (r1, v1)
+    grad6d d_r0, d_sigma0, d_alpha;
+    d_r0 << r1.transpose() / r0, 0., 0., 0.;
+    d_sigma0 << v1.transpose() / sqrt_mu, r1.transpose() / sqrt_mu;
+    d_alpha << -2. / (r0 * r0 * r0) * r1.transpose(), -2. / mu * v1.transpose();
+
+    // Kepler's equation r0 U1 + sigma0 U2 + U3 = sqrt(mu) tof at fixed tof; its chi-derivative is r
+    double kepler_alpha = r0 * U_alpha[1] + sigma0 * U_alpha[2] + U_alpha[3];
+    grad6d d_chi = -(U[1] * d_r0 + U[2] * d_sigma0 + kepler_alpha * d_alpha) / r;
+
+    grad6d d_U0 = -alpha * U[1] * d_chi + U_alpha[0] * d_alpha;
+    grad6d d_U1 = U[0] * d_chi + U_alpha[1] * d_alpha;
+    grad6d d_U2 = U[1] * d_chi + U_alpha[2] * d_alpha;
+
+    grad6d d_r = U[0] * d_r0 + r0 * d_U0 + U[1] * d_sigma0 + sigma0 * d_U1 + d_U2;
+
+    // Lagrange coefficients
+    double f = 1. - U[2] / r0;
+    double g = (r0 * U[1] + sigma0 * U[2]) / sqrt_mu;
+    double f_dot = -sqrt_mu * U[1] / (r * r0);
+    double g_dot = 1. - U[2] / r;
+
+    grad6d d_f = -d_U2 / r0 + U[2] / (r0 * r0) * d_r0;
+    grad6d d_g = (U[1] * d_r0 + r0 * d_U1 + U[2] * d_sigma0 + sigma0 * d_U2) / sqrt_mu;
+    grad6d d_f_dot = -sqrt_mu * (d_U1 / (r * r0) - U[1] / (r * r0) * (d_r / r + d_r0 / r0));
+    grad6d d_g_dot = -d_U2 / r + U[2] / (r * r) * d_r;
+
+    mat6d phi;
+    phi.topLeftCorner<3, 3>() = f * Eigen::Matrix3d::Identity();
+    phi.topRightCorner<3, 3>() = g * Eigen::Matrix3d::Identity();
+    phi.bottomLeftCorner<3, 3>() = f_dot * Eigen::Matrix3d::Identity();
+    phi.bottomRightCorner<3, 3>() = g_dot * Eigen::Matrix3d::Identity();
+
+    phi.topRows<3>() += r1 * d_f + v1 * d_g;
+    phi.bottomRows<3>() += r1 * d_f_dot + v1 * d_g_dot;
+    return phi;
+}
+
+bool lambertSensitivity(double mu, const vec3d &r1, const vec3d &r2, const vec3d &v1, const vec3d &v2, double tof,
+                        LambertSensitivity &s)
+{
+    mat6d phi = keplerTransitionMatrix(mu, r1, v1, r2, v2, tof);
+
+    Eigen::Matrix3d A = phi.topLeftCorner<3, 3>();
+    Eigen::Matrix3d B = phi.topRightCorner<3, 3>();
+    Eigen::Matrix3d C = phi.bottomLeftCorner<3, 3>();
+    Eigen::Matrix3d D = phi.bottomRightCorner<3, 3>();
+
+    Eigen::PartialPivLU<Eigen::Matrix3d> lu(B);
+    if (!(lu.rcond() > MIN_RCOND))
+        return false;
+
+    // r2 = r2(r1, v1, tof) held fixed: B dv1 = dr2 - A dr1 - v2 dtof
+    Eigen::Matrix3d B_inv = lu.inverse();
+    vec3d a2 = -mu / std::pow(r2.norm(), 3) * r2;
+
+    s.dv1_dr2 = B_inv;
+    s.dv1_dr1 = -B_inv * A;
+    s.dv1_dtof = -B_inv * v2;
+    s.dv2_dr2 = D * B_inv;
+    s.dv2_dr1 = C + D * s.dv1_dr1;
+    s.dv2_dtof = a2 + D * s.dv1_dtof;
+
+    return s.dv1_dr1.allFinite() && s.dv2_dr1.allFinite();
+}
+
+bool lambertSolveSensitivity(LambertBackend backend, double mu, vec3d &r1, vec3d &r2, double tof, bool shortPath,
+                             vec3d &v1, vec3d &v2, LambertSensitivity &s)
+{
+    std::tie(v1, v2) = lambertSolve(backend, mu, r1, r2, tof, shortPath);
+    return lambertSensitivity(mu, r1, r2, v1, v2, tof, s);
+}
+
+bool porkchopCellGradient(double mu, vec3d &r1, const vec3d &v1_body, vec3d &r2, const vec3d &v2_body,
+                          double tof, double v_orbit_dep, double v_orbit_arr, PorkchopMetric metric,
+                          double &d_departure, double &d_arrival, LambertBackend backend)
+{
+    d_departure = NAN;
+    d_arrival = NAN;
+
+    if (metric == METRIC_TOF)
+    {
+        d_departure = -1.;
+        d_arrival = 1.;
+        return true;
+    }
+
+    if (tof < MIN_TOF || metric == METRIC_DLA)
+        return false;
+
+    TransferGeometry geometry = getTransferGeometry(r1, r2, r1.norm());
+    if (geometry.degenerate)
+        return false;
+
+    LambertBranches branches = lambertBranches(backend, mu, geometry, r1, r2, tof);
+
+    // the branch computePorkchopMetrics keeps: the lower total, short path on ties, never a NaN one
+    double v_orbit_dep_sq = v_orbit_dep * v_orbit_dep;
+    double v_orbit_arr_sq = v_orbit_arr * v_orbit_arr;
+    auto total = [&](const vec3d &v1_transfer, const vec3d &v2_transfer)
+    {
+        double c3 = std::min((v1_transfer - v1_body).squaredNorm(), MAX_C3_CUTOFF);
+        return std::sqrt(2.0 * v_orbit_dep_sq + c3) - v_orbit_dep
+               + std::sqrt(2.0 * v_orbit_arr_sq + (v2_body - v2_transfer).squaredNorm()) - v_orbit_arr;
+    };
+    double total_short = total(branches.v1_short, branches.v2_short);
+    double total_long = total(branches.v1_long, branches.v2_long);
+    bool shortPath = total_short <= total_long || std::isnan(total_long);
+
+    const vec3d &v1_transfer = shortPath ? branches.v1_short : branches.v1_long;
+    const vec3d &v2_transfer = shortPath ? branches.v2_short : branches.v2_long;
+
+    vec3d v_inf_departure = v1_transfer - v1_body;
+    vec3d v_inf_arrival = v2_body - v2_transfer;
+    double c3 = v_inf_departure.squaredNorm();
+    double c3_arrival = v_inf_arrival.squaredNorm();
+    double dv1 = std::sqrt(2.0 * v_orbit_dep_sq + c3) - v_orbit_dep;
+    double dv2 = std::sqrt(2.0 * v_orbit_arr_sq + c3_arrival) - v_orbit_arr;
+
+    if (!(c3 < MAX_C3_CUTOFF && dv1 + dv2 < MAX_DV_CUTOFF))
+        return false;
+
+    LambertSensitivity s;
+    if (!lambertSensitivity(mu, r1, r2, v1_transfer, v2_transfer, tof, s))
+        return false;
+
+    // r1 moves with the departure body and tof shrinks as departure advances; r2 and tof follow arrival
+    vec3d a1_body = -mu / std::pow(geometry.r1_norm, 3) * r1;
+    vec3d a2_body = -mu / std::pow(geometry.r2_norm, 3) * r2;
+
+    vec3d dv_inf_departure[2] = {s.dv1_dr1 * v1_body - s.dv1_dtof - a1_body, s.dv1_dr2 * v2_body + s.dv1_dtof};
+    vec3d dv_inf_arrival[2] = {s.dv2_dtof - s.dv2_dr1 * v1_body, a2_body - s.dv2_dr2 * v2_body - s.dv2_dtof};
+
+    double *out[2] = {&d_departure, &d_arrival};
+    for (int end = 0; end < 2; ++end)
+    {
+        double dc3 = 2. * v_inf_departure.dot(dv_inf_departure[end]);
+        double dc3_arrival = 2. * v_inf_arrival.dot(dv_inf_arrival[end]);
+        double ddv1 = dc3 / (2. * (dv1 + v_orbit_dep));
+        double ddv2 = dc3_arrival / (2. * (dv2 + v_orbit_arr));
+
+        double value;
+        switch (metric)
+        {
+            case METRIC_C3:
+                value = dc3;
+                break;
+            case METRIC_DV1:
+                value = ddv1;
+                break;
+            case METRIC_DV2:
+                value = ddv2;
+                break;
+            case METRIC_VINF_ARRIVAL:
+                value = dc3_arrival / (2. * std::sqrt(c3_arrival));
+                break;
+            default:
+                value = ddv1 + ddv2;
+                break;
+        }
+        *out[end] = value * SECONDS_PER_DAY;
+    }
+
+    return true;
+}
+
+void computePorkchopGradients(double mu, const double *r1, const double *v1, const double *r2, const double *v2,
+                              const double *d1, const double *d2, int num_departure_dates, int num_arrival_dates,
+                              double departure_planet_mu, double arrival_planet_mu,
+                              double departure_orbit_radius, double arrival_orbit_radius, PorkchopMetric metric,
+                              double *d_departure, double *d_arrival, LambertBackend backend)
+{
+    const double v_orbit_dep = std::sqrt(departure_planet_mu / departure_orbit_radius);
+    const double v_orbit_arr = std::sqrt(arrival_planet_mu / arrival_orbit_radius);
+
+    for (int i = 0; i < num_departure_dates; ++i)
+    {
+        double departure_time = julianDateToSeconds(d1[i]);
+        vec3d r1_departure = {r1[i * 3], r1[i * 3 + 1], r1[i * 3 + 2]};
+        vec3d v1_departure = {v1[i * 3], v1[i * 3 + 1], v1[i * 3 + 2]};
+
+        for (int j = 0; j < num_arrival_dates; ++j)
+        {
+            size_t cell = static_cast<size_t>(i) * num_arrival_dates + j;
+            vec3d r2_arrival = {r2[j * 3], r2[j * 3 + 1], r2[j * 3 + 2]};
+            vec3d v2_arrival = {v2[j * 3], v2[j * 3 + 1], v2[j * 3 + 2]};
+
+            porkchopCellGradient(mu, r1_departure, v1_departure, r2_arrival, v2_arrival,
+                                 julianDateToSeconds(d2[j]) - departure_time, v_orbit_dep, v_orbit_arr, metric,
+                                 d_departure[cell], d_arrival[cell], backend);
+        }
+    }
+}
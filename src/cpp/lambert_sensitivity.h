@@ -0,0 +1,54 @@
+#ifndef LAMBERT_LAMBERT_SENSITIVITY_H
+#define LAMBERT_LAMBERT_SENSITIVITY_H
+
+#include "battin1984.h"
+#include "porkchop_metrics.h"
+
+// Partials of a Lambert solution's velocities with respect to its boundary conditions, from the state transition
+// matrix of the converged arc. The universal anomaly of the arc follows in closed form from its two end states,
+// so the partials cost one evaluation of the Stumpff functions and a 3x3 inverse on top of the solve, against
+// 7-13 further solves for finite differences. Any solver, and any revolution count, can supply the solution.
+
+typedef Eigen::Matrix<double, 6, 6> mat6d;
+
+struct LambertSensitivity
+{
+    Eigen::Matrix3d dv1_dr1;
+    Eigen::Matrix3d dv1_dr2;
+    Eigen::Matrix3d dv2_dr1;
+    Eigen::Matrix3d dv2_dr2;
+    vec3d dv1_dtof;
+    vec3d dv2_dtof;
+};
+
+// d(r2, v2) / d(r1, v1) of the two-body arc from (r1, v1) to (r2, v2) in tof.
+mat6d keplerTransitionMatrix(double mu, const vec3d &r1, const vec3d &v1, const vec3d &r2, const vec3d &v2,
+                             double tof);
+
+// Partials of the solution v1, v2 between r1 and r2. Returns false where they are unbounded: transfers through
+// 0 or 180 deg, where d r2 / d v1 is singular and the transfer plane is undefined.
+bool lambertSensitivity(double mu, const vec3d &r1, const vec3d &r2, const vec3d &v1, const vec3d &v2, double tof,
+                        LambertSensitivity &s);
+
+// Zero-revolution solve and its partials in one call.
+bool lambertSolveSensitivity(LambertBackend backend, double mu, vec3d &r1, vec3d &r2, double tof, bool shortPath,
+                             vec3d &v1, vec3d &v2, LambertSensitivity &s);
+
+// Derivatives of a porkchop metric with respect to the departure and arrival dates, per day, for one cell at
+// arbitrary body states (see computePorkchopGradients). Returns false, with both derivatives NaN, where they are
+// undefined.
+bool porkchopCellGradient(double mu, vec3d &r1, const vec3d &v1_body, vec3d &r2, const vec3d &v2_body,
+                          double tof, double v_orbit_dep, double v_orbit_arr, PorkchopMetric metric,
+                          double &d_departure, double &d_arrival, LambertBackend backend = LAMBERT_BATTIN);
+
+// Derivatives of a porkchop metric with respect to the departure and arrival dates, per day, for every cell of
+// the grid computePorkchopMetrics would return: the kept branch's partials, chained through the bodies' motion
+// (velocities from the ephemeris, accelerations from the central body alone). Cells without a transfer, cells at
+// a cutoff and transfers through 0 or 180 deg hold NaN; METRIC_TOF is exact, METRIC_DLA is not supported.
+void computePorkchopGradients(double mu, const double *r1, const double *v1, const double *r2, const double *v2,
+                              const double *d1, const double *d2, int num_departure_dates, int num_arrival_dates,
+                              double departure_planet_mu, double arrival_planet_mu,
+                              double departure_orbit_radius, double arrival_orbit_radius, PorkchopMetric metric,
+                              double *d_departure, double *d_arrival, LambertBackend backend = LAMBERT_BATTIN);
+
+#endif //LAMBERT_LAMBERT_SENSITIVITY_H
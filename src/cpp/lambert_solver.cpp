@@ -0,0 +1,102 @@
+#include "lambert_solver.h"
+#include "gooding1990.h"
+#include "izzo2015.h"
+#include <algorithm>
+#include <cmath>
+
+// LAMBERT_AUTO sends long-path transfers with lambda below this to Gooding when T lies between the parabolic
+// time and AUTO_GOODING_TOF_RATIO times it (x from about 0.97 to 1)
+constexpr double AUTO_GOODING_LAMBDA = -0.4;
+constexpr double AUTO_GOODING_TOF_RATIO = 1.02;
+
+// Zero-revolution Izzo solves. The Householder steps converge cubically, so a last step of 1e-5 in x leaves an
+// error of ~1e-13.
+constexpr int IZZO_MAX_ITER = 15;
+constexpr double IZZO_ATOL = 1e-5;
+
+const char *lambertBackendName(LambertBackend backend)
+{
+    switch (backend)
+    {
+        case LAMBERT_BATTIN:
+            return "battin";
+        case LAMBERT_IZZO:
+            return "izzo";
+        case LAMBERT_GOODING:
+            return "gooding";
+        case LAMBERT_AUTO:
+            return "auto";
+    }
+    return "unknown";
+}
+
+LambertBackend resolveLambertBackend(LambertBackend backend, double mu, const TransferGeometry &g, double tof,
+                                     bool shortPath)
+{
+    if (backend != LAMBERT_AUTO)
+        return backend;
+
+    if (g.degenerate)
+        return LAMBERT_BATTIN;
+
+    if (shortPath)
+        return LAMBERT_IZZO;
+
+    // Izzo's nondimensional time against the parabolic one, 2 / 3 (1 - lambda^3)
+    double lambda = -std::sqrt(std::max(0., 1. - g.c_norm / g.semiperimeter));
+    double T = std::sqrt(2. * mu / std::pow(g.semiperimeter, 3)) * tof;
+    double t_parabolic = 2. / 3. * (1. - lambda * lambda * lambda);
+
+    bool near_parabolic = T >= t_parabolic && T <= AUTO_GOODING_TOF_RATIO * t_parabolic;
+    return lambda < AUTO_GOODING_LAMBDA && near_parabolic ? LAMBERT_GOODING : LAMBERT_IZZO;
+}
+
+void lambertBranch(LambertBackend backend, double mu, const TransferGeometry &g, vec3d &r1, vec3d &r2, double tof,
+                   bool shortPath, vec3d &v1, vec3d &v2)
+{
+    backend = resolveLambertBackend(backend, mu, g, tof, shortPath);
+
+    if (!g.degenerate)
+    {
+        if (backend == LAMBERT_GOODING && gooding1990(mu, g, r1, r2, tof, shortPath, v1, v2))
+            return;
+
+        if (backend == LAMBERT_IZZO)
+        {
+            Izzo2015Geometry geometry = getIzzoGeometry(mu, g, r1, r2, shortPath);
+            if (izzo2015(geometry, mu, tof, 0, false, v1, v2, IZZO_MAX_ITER, IZZO_ATOL))
+                return;
+        }
+    }
+
+    BattinParameters p = getBattinParameters(mu, g, tof, true, shortPath);
+
+    double x, y;
+    battinIterate(p.l1, p.m, p.x0, 100, tol, continuedFractionDepth(CF_ADAPTIVE, tol), x, y);
+    std::tie(v1, v2) = battinVelocities(p, g, r1, r2, tof, x, y);
+}
+
+LambertBranches lambertBranches(LambertBackend backend, double mu, const TransferGeometry &g, vec3d &r1,
+                                vec3d &r2, double tof, bool prograde, WarmStart *warm, IterationStats *stats)
+{
+    if (backend == LAMBERT_BATTIN || g.degenerate)
+        return battin1984Branches(mu, g, r1, r2, tof, prograde, 100, tol, CF_ADAPTIVE, warm, stats);
+
+    if (warm)
+        *warm = WarmStart();
+
+    LambertBranches branches;
+    lambertBranch(backend, mu, g, r1, r2, tof, true, branches.v1_short, branches.v2_short);
+    lambertBranch(backend, mu, g, r1, r2, tof, false, branches.v1_long, branches.v2_long);
+    return branches;
+}
+
+std::tuple<vec3d, vec3d> lambertSolve(LambertBackend backend, double mu, vec3d &r1, vec3d &r2, double tof,
+                                      bool shortPath)
+{
+    TransferGeometry g = getTransferGeometry(r1, r2, r1.norm());
+
+    vec3d v1, v2;
+    lambertBranch(backend, mu, g, r1, r2, tof, shortPath, v1, v2);
+    return {v1, v2};
+}
@@ -0,0 +1,33 @@
+#ifndef LAMBERT_LAMBERT_SOLVER_H
+#define LAMBERT_LAMBERT_SOLVER_H
+
+#include "battin1984.h"
+#include <tuple>
+
+// One entry point over the zero-revolution backends. All of them solve the same short- and long-path problem
+// and agree to within their tolerances; they differ in cost per regime. Collinear r1, r2 always go to Battin,
+// the only backend that defines a transfer plane there.
+
+const char *lambertBackendName(LambertBackend backend);
+
+// The backend LAMBERT_AUTO runs for one branch of this transfer; any other backend maps to itself. Measured
+// per regime (BM_LambertBranches), Izzo is 4-8x faster than the scalar Battin iteration everywhere, and Gooding
+// beats Izzo only on long-path transfers well past 180 deg that are just short of parabolic.
+LambertBackend resolveLambertBackend(LambertBackend backend, double mu, const TransferGeometry &g, double tof,
+                                     bool shortPath);
+
+// One branch with the resolved backend; Battin takes over wherever Izzo or Gooding have no solution.
+void lambertBranch(LambertBackend backend, double mu, const TransferGeometry &g, vec3d &r1, vec3d &r2, double tof,
+                   bool shortPath, vec3d &v1, vec3d &v2);
+
+// Both branches from one geometry evaluation. warm and stats are used, and warm kept up to date, only while
+// Battin solves; a solve by another backend resets the seeds so a later Battin solve does not start from a stale
+// continuation.
+LambertBranches lambertBranches(LambertBackend backend, double mu, const TransferGeometry &g, vec3d &r1,
+                                vec3d &r2, double tof, bool prograde = true, WarmStart *warm = nullptr,
+                                IterationStats *stats = nullptr);
+
+std::tuple<vec3d, vec3d> lambertSolve(LambertBackend backend, double mu, vec3d &r1, vec3d &r2, double tof,
+                                      bool shortPath = true);
+
+#endif //LAMBERT_LAMBERT_SOLVER_H
@@ -0,0 +1,191 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include "mga_search.h"
+
+// mga: multi-gravity-assist search over a planet sequence, with the planets on their mean elements. Writes one
+// line per trajectory, best first: total Δv, C3, departure, flyby and capture burns, and the date at every body.
+
+struct PlanetConstants
+{
+    int id;
+    double mu;      // km^3/s^2
+    double radius;  // km
+};
+
+// as in public/porkchop/celestialData.json
+static const PlanetConstants PLANETS[] = {
+        {199, 22031.86855, 2439.7},
+        {299, 324858.592, 6051.8},
+        {399, 398600.4418, 6378.1366},
+        {499, 42828.375214, 3396.19},
+        {599, 126686534, 71492.0},
+        {699, 37931207.8, 60268.0},
+        {799, 5793966, 25559.0},
+        {899, 6835107, 24764.0},
+};
+
+static void printUsage()
+{
+    std::cerr << "usage: mga --sequence ID,ID,... --launch START:END:STEP --tof MIN:MAX:STEP [--tof ...]\n"
+                 "           [--beam N] [--beam-per-epoch N] [--results N] [--max-dv KMS] [--max-c3 KM2S2]\n"
+                 "           [--altitude KM] [--departure-radius KM] [--arrival-radius KM]\n"
+                 "           [--solver battin|izzo|gooding|auto]\n"
+                 "  IDs are Horizons planet ids (199 ... 899); dates are JD, durations days; one --tof per leg\n";
+}
+
+static bool parseTriple(const std::string &text, double &a, double &b, double &c)
+{
+    char colon1, colon2;
+    std::istringstream in(text);
+    return in >> a >> colon1 >> b >> colon2 >> c && colon1 == ':' && colon2 == ':' && in.eof();
+}
+
+int main(int argc, char **argv)
+{
+    double mu = 132712440018.0;
+    double altitude = 300.0;
+    std::vector<int> ids;
+    MgaSearch search;
+    bool has_launch = false;
+
+    for (int k = 1; k < argc; ++k)
+    {
+        std::string arg = argv[k];
+
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            return 0;
+        }
+        else if (k + 1 >= argc)
+        {
+            printUsage();
+            return 2;
+        }
+
+        std::string value = argv[++k];
+        if (arg == "--sequence")
+        {
+            std::istringstream in(value);
+            std::string id;
+            while (std::getline(in, id, ','))
+                ids.push_back(std::atoi(id.c_str()));
+        }
+        else if (arg == "--launch")
+        {
+            double start, end, step;
+            if (!parseTriple(value, start, end, step) || step <= 0)
+            {
+                std::cerr << "mga: bad launch window " << value << "\n";
+                return 2;
+            }
+            search.departure = dateRange(start, end, step);
+            has_launch = true;
+        }
+        else if (arg == "--tof")
+        {
+            MgaLegWindow window;
+            if (!parseTriple(value, window.min_tof, window.max_tof, window.step) || window.step <= 0)
+            {
+                std::cerr << "mga: bad time of flight window " << value << "\n";
+                return 2;
+            }
+            search.legs.push_back(window);
+        }
+        else if (arg == "--beam")
+            search.beam_width = std::atoi(value.c_str());
+        else if (arg == "--beam-per-epoch")
+            search.beam_per_epoch = std::atoi(value.c_str());
+        else if (arg == "--results")
+            search.max_results = std::atoi(value.c_str());
+        else if (arg == "--max-dv")
+            search.max_total_dv = std::atof(value.c_str());
+        else if (arg == "--max-c3")
+            search.max_c3 = std::atof(value.c_str());
+        else if (arg == "--altitude")
+            altitude = std::atof(value.c_str());
+        else if (arg == "--departure-radius")
+            search.departure_orbit_radius = std::atof(value.c_str());
+        else if (arg == "--arrival-radius")
+            search.arrival_orbit_radius = std::atof(value.c_str());
+        else if (arg == "--solver")
+        {
+            if (value == "battin")
+                search.backend = LAMBERT_BATTIN;
+            else if (value == "izzo")
+                search.backend = LAMBERT_IZZO;
+            else if (value == "gooding")
+                search.backend = LAMBERT_GOODING;
+            else if (value == "auto")
+                search.backend = LAMBERT_AUTO;
+            else
+            {
+                std::cerr << "mga: unknown solver " << value << "\n";
+                printUsage();
+                return 2;
+            }
+        }
+        else
+        {
+            std::cerr << "mga: unknown option " << arg << "\n";
+            printUsage();
+            return 2;
+        }
+    }
+
+    if (ids.size() < 2 || !has_launch || search.legs.size() != ids.size() - 1)
+    {
+        std::cerr << "mga: need a sequence of two or more bodies, a launch window and one --tof per leg\n";
+        printUsage();
+        return 2;
+    }
+
+    std::vector<std::unique_ptr<MeanElementsEphemeris>> ephemerides;
+    std::vector<MgaBody> sequence;
+    for (int id: ids)
+    {
+        const PlanetConstants *planet = nullptr;
+        for (const PlanetConstants &p: PLANETS)
+            planet = p.id == id ? &p : planet;
+
+        if (!planet || !planetMeanElements(id))
+        {
+            std::cerr << "mga: no mean elements for body " << id << "\n";
+            return 2;
+        }
+
+        ephemerides.push_back(std::make_unique<MeanElementsEphemeris>(*planetMeanElements(id), mu));
+        sequence.push_back({id, ephemerides.back().get(), planet->mu, planet->radius + altitude});
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    MgaStats stats;
+    std::vector<MgaTrajectory> trajectories = searchMga(mu, sequence, search, nullptr, &stats);
+
+    std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+    std::cerr << "mga: " << stats.lambert_solves << " Lambert solves, " << stats.cache_hits << " cache hits, "
+              << stats.expanded << " partial trajectories expanded in " << duration.count() << " ms\n";
+    std::cerr << "mga: pruned " << stats.pruned_dv << " on dv, " << stats.pruned_flyby << " on flyby periapsis, "
+              << stats.pruned_beam << " by the beam\n";
+
+    std::cout << std::fixed;
+    for (const MgaTrajectory &t: trajectories)
+    {
+        std::cout << std::setprecision(4) << "dv " << t.total_dv << " c3 " << t.c3 << " departure "
+                  << t.departure_dv;
+        for (size_t k = 0; k < t.flyby_dv.size(); ++k)
+            std::cout << " flyby " << t.flyby_dv[k] << " rp " << std::setprecision(0) << t.flyby_periapsis[k]
+                      << std::setprecision(4);
+        std::cout << " arrival " << t.arrival_dv << " vinf " << t.arrival_v_inf << " jd";
+        for (double jd: t.epochs)
+            std::cout << " " << std::setprecision(2) << jd;
+        std::cout << "\n";
+    }
+
+    return 0;
+}
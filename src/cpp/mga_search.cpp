@@ -0,0 +1,322 @@
+#include "mga_search.h"
+#include "lambert_solver.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+// epochs are matched to this resolution in the cache keys
+constexpr double EPOCH_KEY_DAYS = 1e-6;
+
+constexpr double FLYBY_RTOL = 1e-10;
+
+MgaStats &MgaStats::operator+=(const MgaStats &other)
+{
+    lambert_solves += other.lambert_solves;
+    cache_hits += other.cache_hits;
+    expanded += other.expanded;
+    pruned_dv += other.pruned_dv;
+    pruned_flyby += other.pruned_flyby;
+    pruned_beam += other.pruned_beam;
+    return *this;
+}
+
+static int64_t epochKey(double jd)
+{
+    return std::llround(jd / EPOCH_KEY_DAYS);
+}
+
+static uint64_t muKey(double mu)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &mu, sizeof bits);
+    return bits;
+}
+
+size_t LambertLegCache::KeyHash::operator()(const Key &key) const
+{
+    uint64_t h = static_cast<uint64_t>(key.departure) * 0x9E3779B97F4A7C15ull;
+    h ^= static_cast<uint64_t>(key.arrival) + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+    h ^= (static_cast<uint64_t>(static_cast<uint32_t>(key.from)) << 32 | static_cast<uint32_t>(key.to))
+         + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+    h ^= (key.mu ^ static_cast<uint64_t>(key.backend)) + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+    return static_cast<size_t>(h);
+}
+
+const LambertLegCache::BodyState &LambertLegCache::state(const MgaBody &body, double jd)
+{
+    Key key = {body.id, body.id, epochKey(jd), 0, LAMBERT_BATTIN, 0};
+    auto found = states.find(key);
+    if (found != states.end())
+        return found->second;
+
+    BodyState s;
+    body.ephemeris->states(&jd, 1, s.r.data(), s.v.data());
+    return states.emplace(key, s).first->second;
+}
+
+const LambertBranches &LambertLegCache::leg(double mu, const MgaBody &from, double departure_jd, const MgaBody &to,
+                                            double arrival_jd, LambertBackend backend, MgaStats &stats)
+{
+    Key key = {from.id, to.id, epochKey(departure_jd), epochKey(arrival_jd), backend, muKey(mu)};
+    auto found = legs.find(key);
+    if (found != legs.end())
+    {
+        ++stats.cache_hits;
+        return found->second;
+    }
+
+    if (legs.size() >= max_entries)
+        clear();
+
+    vec3d r1 = state(from, departure_jd).r;
+    vec3d r2 = state(to, arrival_jd).r;
+    double tof = julianDateToSeconds(arrival_jd) - julianDateToSeconds(departure_jd);
+
+    TransferGeometry g = getTransferGeometry(r1, r2, r1.norm());
+    ++stats.lambert_solves;
+    return legs.emplace(key, lambertBranches(backend, mu, g, r1, r2, tof)).first->second;
+}
+
+void LambertLegCache::clear()
+{
+    states.clear();
+    legs.clear();
+}
+
+double poweredFlybyDv(double mu, const vec3d &v_inf_in, const vec3d &v_inf_out, double &periapsis)
+{
+    double v_in = v_inf_in.norm();
+    double v_out = v_inf_out.norm();
+    double turn = std::acos(std::clamp(v_inf_in.dot(v_inf_out) / (v_in * v_out), -1., 1.));
+
+    periapsis = std::numeric_limits<double>::infinity();
+    if (!(turn > 0))
+        return std::abs(v_out - v_in);
+
+    // half the turn of each hyperbola is asin(a / (a + rp)) with a = mu / v∞^2; their sum falls monotonically
+    // from pi at rp = 0 to 0 at infinity
+    double a_in = mu / (v_in * v_in);
+    double a_out = mu / (v_out * v_out);
+    auto excess = [&](double rp)
+    {
+        return std::asin(a_in / (a_in + rp)) + std::asin(a_out / (a_out + rp)) - turn;
+    };
+
+    double low = 0, high = a_in + a_out;
+    for (int k = 0; k < 1000 && excess(high) > 0; ++k)
+    {
+        low = high;
+        high *= 2;
+    }
+
+    // Newton, kept inside the bracket by bisection
+    double rp = 0.5 * (low + high);
+    for (int k = 0; k < 100; ++k)
+    {
+        double f = excess(rp);
+        if (f > 0)
+            low = rp;
+        else
+            high = rp;
+
+        double df = -a_in / ((a_in + rp) * std::sqrt(rp * (rp + 2 * a_in)))
+                    - a_out / ((a_out + rp) * std::sqrt(rp * (rp + 2 * a_out)));
+        double next = rp - f / df;
+        if (!(next > low && next < high))
+            next = 0.5 * (low + high);
+
+        bool done = std::abs(next - rp) <= FLYBY_RTOL * rp;
+        rp = next;
+        if (done)
+            break;
+    }
+
+    periapsis = rp;
+    return std::abs(std::sqrt(v_out * v_out + 2 * mu / rp) - std::sqrt(v_in * v_in + 2 * mu / rp));
+}
+
+namespace
+{
+
+// A partial trajectory ending at one body of the sequence.
+struct MgaNode
+{
+    double jd = 0;
+    double cost = 0;        // Δv so far, km/s
+    vec3d v_inf_in = vec3d::Zero();  // arrival v∞ at this body
+    int parent = -1;        // index in the previous level
+    bool short_path = true; // branch of the leg into this body
+    double flyby_dv = 0;    // at the previous body; the departure burn on the first leg
+    double flyby_periapsis = 0;
+    double c3 = 0;          // first leg only
+};
+
+}
+
+std::vector<MgaTrajectory> searchMga(double mu, const std::vector<MgaBody> &sequence, const MgaSearch &search,
+                                     LambertLegCache *cache, MgaStats *stats)
+{
+    std::vector<MgaTrajectory> results;
+    int num_legs = static_cast<int>(sequence.size()) - 1;
+    if (num_legs < 1 || static_cast<int>(search.legs.size()) != num_legs || search.max_results <= 0)
+        return results;
+
+    LambertLegCache local_cache;
+    LambertLegCache &legs = cache ? *cache : local_cache;
+    MgaStats counts;
+
+    const MgaBody &origin = sequence.front();
+    const MgaBody &target = sequence.back();
+    double v_park = std::sqrt(origin.mu / search.departure_orbit_radius);
+    double v_capture = search.arrival_orbit_radius > 0 ? std::sqrt(target.mu / search.arrival_orbit_radius) : 0;
+
+    std::vector<std::vector<MgaNode>> levels(num_legs + 1);
+    for (int k = 0; k < search.departure.count; ++k)
+    {
+        MgaNode start{};
+        start.jd = search.departure.start_jd + k * search.departure.step_days;
+        start.parent = -1;
+        levels[0].push_back(start);
+    }
+
+    for (int leg = 0; leg < num_legs; ++leg)
+    {
+        const MgaBody &from = sequence[leg];
+        const MgaBody &to = sequence[leg + 1];
+        const MgaLegWindow &window = search.legs[leg];
+        bool last = leg == num_legs - 1;
+        int num_tofs = window.step > 0 ? static_cast<int>(std::floor((window.max_tof - window.min_tof)
+                                                                     / window.step + 1e-9)) + 1 : 1;
+
+        std::vector<MgaNode> &children = levels[leg + 1];
+        for (int p = 0; p < static_cast<int>(levels[leg].size()); ++p)
+        {
+            const MgaNode &node = levels[leg][p];
+            vec3d v_from = legs.state(from, node.jd).v;
+            ++counts.expanded;
+
+            for (int t = 0; t < num_tofs; ++t)
+            {
+                double arrival_jd = node.jd + window.min_tof + t * window.step;
+                if ((arrival_jd - node.jd) * 86400.0 < MIN_TOF)
+                    continue;
+
+                const LambertBranches &branches = legs.leg(mu, from, node.jd, to, arrival_jd, search.backend,
+                                                           counts);
+                vec3d v_to = legs.state(to, arrival_jd).v;
+
+                for (bool short_path: {true, false})
+                {
+                    vec3d v_inf_out = (short_path ? branches.v1_short : branches.v1_long) - v_from;
+
+                    MgaNode child{};
+                    child.jd = arrival_jd;
+                    child.parent = p;
+                    child.short_path = short_path;
+                    child.v_inf_in = v_to - (short_path ? branches.v2_short : branches.v2_long);
+
+                    if (leg == 0)
+                    {
+                        double c3 = v_inf_out.squaredNorm();
+                        if (!(c3 <= search.max_c3))
+                        {
+                            ++counts.pruned_dv;
+                            continue;
+                        }
+                        child.c3 = c3;
+                        child.flyby_dv = std::sqrt(2 * v_park * v_park + c3) - v_park;
+                        child.flyby_periapsis = 0;
+                    }
+                    else
+                    {
+                        child.c3 = 0;
+                        child.flyby_dv = poweredFlybyDv(from.mu, node.v_inf_in, v_inf_out, child.flyby_periapsis);
+                        if (!(child.flyby_periapsis >= from.min_periapsis))
+                        {
+                            ++counts.pruned_flyby;
+                            continue;
+                        }
+                    }
+
+                    child.cost = node.cost + child.flyby_dv;
+                    if (last && v_capture > 0)
+                        child.cost += std::sqrt(2 * v_capture * v_capture + child.v_inf_in.squaredNorm()) - v_capture;
+
+                    if (!(child.cost <= search.max_total_dv))
+                    {
+                        ++counts.pruned_dv;
+                        continue;
+                    }
+
+                    children.push_back(child);
+                }
+            }
+        }
+
+        auto cheaper = [](const MgaNode &a, const MgaNode &b) { return a.cost < b.cost; };
+        std::sort(children.begin(), children.end(), cheaper);
+
+        if (last)
+        {
+            if (static_cast<int>(children.size()) > search.max_results)
+                children.resize(search.max_results);
+            continue;
+        }
+
+        // the cheapest first, but at most beam_per_epoch per date at the body
+        std::unordered_map<int64_t, int> per_epoch;
+        size_t kept = 0;
+        for (size_t k = 0; k < children.size() && static_cast<int>(kept) < search.beam_width; ++k)
+        {
+            int &count = per_epoch[epochKey(children[k].jd)];
+            if (search.beam_per_epoch > 0 && count >= search.beam_per_epoch)
+                continue;
+            ++count;
+            children[kept++] = children[k];
+        }
+        counts.pruned_beam += static_cast<long long>(children.size() - kept);
+        children.resize(kept);
+    }
+
+    for (int k = 0; k < static_cast<int>(levels[num_legs].size()); ++k)
+    {
+        MgaTrajectory trajectory;
+        trajectory.epochs.resize(num_legs + 1);
+        trajectory.short_path.resize(num_legs);
+        trajectory.flyby_dv.resize(num_legs - 1);
+        trajectory.flyby_periapsis.resize(num_legs - 1);
+
+        const MgaNode &end = levels[num_legs][k];
+        trajectory.total_dv = end.cost;
+        trajectory.arrival_v_inf = end.v_inf_in.norm();
+        trajectory.arrival_dv = v_capture > 0
+                                ? std::sqrt(2 * v_capture * v_capture + end.v_inf_in.squaredNorm()) - v_capture : 0;
+
+        int index = k;
+        for (int level = num_legs; level > 0; --level)
+        {
+            const MgaNode &node = levels[level][index];
+            trajectory.epochs[level] = node.jd;
+            trajectory.short_path[level - 1] = node.short_path;
+            if (level > 1)
+            {
+                trajectory.flyby_dv[level - 2] = node.flyby_dv;
+                trajectory.flyby_periapsis[level - 2] = node.flyby_periapsis;
+            }
+            else
+            {
+                trajectory.departure_dv = node.flyby_dv;
+                trajectory.c3 = node.c3;
+            }
+            index = node.parent;
+        }
+        trajectory.epochs[0] = levels[0][index].jd;
+
+        results.push_back(trajectory);
+    }
+
+    if (stats)
+        *stats += counts;
+    return results;
+}
@@ -0,0 +1,135 @@
+#ifndef LAMBERT_MGA_SEARCH_H
+#define LAMBERT_MGA_SEARCH_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "battin1984.h"
+#include "ephemeris.h"
+
+// Multi-gravity-assist search over a fixed body sequence (e.g. Earth-Venus-Earth-Jupiter): every leg is a
+// zero-revolution Lambert arc between the bodies at grid epochs, and consecutive legs are patched at each flyby
+// by matching v∞ with a powered swing-by. The epochs are explored leg by leg with a beam search, after the
+// pruning of Myatt et al., "Advanced global optimisation for mission analysis and design" (GASP): partial
+// trajectories whose Δv so far, or whose flyby periapsis, already rules them out are dropped before the next
+// leg is expanded.
+
+struct MgaBody
+{
+    int id;                 // any id unique to the body; keys the leg cache (e.g. the Horizons id)
+    const Ephemeris *ephemeris;
+    double mu;              // km^3/s^2
+    double min_periapsis;   // km, lowest flyby periapsis (radius plus safety altitude)
+};
+
+// Time-of-flight grid of one leg, days.
+struct MgaLegWindow
+{
+    double min_tof;
+    double max_tof;
+    double step;
+};
+
+struct MgaSearch
+{
+    DateRange departure;                // launch epochs
+    std::vector<MgaLegWindow> legs;     // one per leg, sequence.size() - 1 of them
+    int beam_width = 500;               // partial trajectories kept after each leg
+    int beam_per_epoch = 2;             // at most this many of them per date at the body; 0 for no limit
+    int max_results = 10;
+    double max_total_dv = 20.0;         // km/s; partial trajectories above it are pruned
+    double max_c3 = MAX_C3_CUTOFF;      // km^2/s^2
+    double departure_orbit_radius = 6778.0;  // km, circular parking orbit
+    double arrival_orbit_radius = 0;    // km, circular capture orbit; 0 leaves the arrival v∞ uncounted
+    LambertBackend backend = LAMBERT_BATTIN;
+};
+
+struct MgaTrajectory
+{
+    std::vector<double> epochs;         // jd at every body of the sequence
+    std::vector<double> flyby_dv;       // km/s, per intermediate body
+    std::vector<double> flyby_periapsis;// km
+    std::vector<bool> short_path;       // per leg
+    double c3;
+    double departure_dv;
+    double arrival_v_inf;
+    double arrival_dv;
+    double total_dv;
+};
+
+struct MgaStats
+{
+    long long lambert_solves = 0;
+    long long cache_hits = 0;
+    long long expanded = 0;             // partial trajectories extended by one leg
+    long long pruned_dv = 0;            // dropped on Δv so far
+    long long pruned_flyby = 0;         // dropped on a flyby below the minimum periapsis
+    long long pruned_beam = 0;          // dropped by the beam width
+
+    MgaStats &operator+=(const MgaStats &other);
+};
+
+// Solved legs and body states, keyed by body ids and grid epochs; legs also by the backend and central mu they
+// were solved with. A leg depends only on its two bodies and epochs, not on the legs before it, so partial
+// trajectories that meet at the same body and date, and sequences sharing a leg (Earth-Venus in EVEJ and EVVEJ),
+// reuse one solve. Epochs are matched to 1e-6 days. When the cache holds max_entries legs it is cleared. Not
+// thread-safe.
+class LambertLegCache
+{
+public:
+    struct BodyState
+    {
+        vec3d r;
+        vec3d v;
+    };
+
+    explicit LambertLegCache(size_t max_entries = 1 << 22) : max_entries(max_entries) {}
+
+    const BodyState &state(const MgaBody &body, double jd);
+
+    // Both branches of the leg from `from` at departure_jd to `to` at arrival_jd; the solve counts into stats.
+    const LambertBranches &leg(double mu, const MgaBody &from, double departure_jd, const MgaBody &to,
+                               double arrival_jd, LambertBackend backend, MgaStats &stats);
+
+    size_t size() const { return legs.size(); }
+    void clear();
+
+private:
+    struct Key
+    {
+        int from;
+        int to;
+        int64_t departure;
+        int64_t arrival;
+        LambertBackend backend;
+        uint64_t mu;            // bits of the central body's mu
+
+        bool operator==(const Key &other) const
+        {
+            return from == other.from && to == other.to && departure == other.departure
+                   && arrival == other.arrival && backend == other.backend && mu == other.mu;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const;
+    };
+
+    size_t max_entries;
+    std::unordered_map<Key, BodyState, KeyHash> states;
+    std::unordered_map<Key, LambertBranches, KeyHash> legs;
+};
+
+// Δv of a powered swing-by turning v∞ from v_inf_in to v_inf_out, applied at the periapsis where the hyperbolas
+// of both speeds together turn by the angle between them (Izzo's PowSwingByInv). periapsis receives that radius.
+double poweredFlybyDv(double mu, const vec3d &v_inf_in, const vec3d &v_inf_out, double &periapsis);
+
+// Best trajectories over the search grid, lowest total Δv first and at most max_results of them. The total counts
+// the departure burn from the parking orbit (as METRIC_DV1), every flyby burn and the capture burn. Returns
+// nothing for a sequence of fewer than two bodies or a leg count that does not match it. With `cache` the legs
+// are shared with other searches over the same bodies and ephemerides.
+std::vector<MgaTrajectory> searchMga(double mu, const std::vector<MgaBody> &sequence, const MgaSearch &search,
+                                     LambertLegCache *cache = nullptr, MgaStats *stats = nullptr);
+
+#endif //LAMBERT_MGA_SEARCH_H
@@ -0,0 +1,228 @@
+#include "porkchop_adaptive.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace
+{
+
+struct AdaptiveContext
+{
+    double mu = 0;
+    const double *r1 = nullptr;
+    const double *v1 = nullptr;
+    const double *r2 = nullptr;
+    const double *v2 = nullptr;
+    const double *d1 = nullptr;
+    const double *d2 = nullptr;
+    int num_arrival_dates = 0;
+    double v_orbit_dep = 0;
+    double v_orbit_arr = 0;
+    AdaptiveOptions options;
+
+    std::unordered_map<long long, PorkchopSample> samples;
+    std::vector<PorkchopLeaf> leaves;
+
+    const PorkchopSample &solve(int i, int j)
+    {
+        long long key = static_cast<long long>(i) * num_arrival_dates + j;
+
+        auto found = samples.find(key);
+        if (found != samples.end())
+            return found->second;
+
+        vec3d r1_departure = {r1[i * 3], r1[i * 3 + 1], r1[i * 3 + 2]};
+        vec3d v1_departure = {v1[i * 3], v1[i * 3 + 1], v1[i * 3 + 2]};
+        vec3d r2_arrival = {r2[j * 3], r2[j * 3 + 1], r2[j * 3 + 2]};
+        vec3d v2_arrival = {v2[j * 3], v2[j * 3 + 1], v2[j * 3 + 2]};
+
+        PorkchopSample sample;
+        sample.i = i;
+        sample.j = j;
+
+        computePorkchopCell(mu, r1_departure, r1_departure.norm(), v1_departure, r2_arrival, v2_arrival,
+                            julianDateToSeconds(d1[i]), julianDateToSeconds(d2[j]), v_orbit_dep, v_orbit_arr,
+                            sample.c3, sample.dv1, sample.total_dv);
+
+        return samples.emplace(key, sample).first->second;
+    }
+
+    // node where a tile is split; the far end when the tile is a single step wide
+    static int midpoint(int a, int b)
+    {
+        return b - a > 1 ? (a + b) / 2 : b;
+    }
+
+    // Tests the corners, edge midpoints and centre, so a dip or an invalid pocket inside the tile is seen even
+    // when all four corners agree. The extra nodes are the corners of the children, solved anyway on a split.
+    bool needsRefinement(int i0, int j0, int i1, int j1)
+    {
+        const int is[3] = {i0, midpoint(i0, i1), i1};
+        const int js[3] = {j0, midpoint(j0, j1), j1};
+
+        int invalid = 0;
+        double lowest = INFINITY, highest = -INFINITY;
+        for (int i: is)
+        {
+            for (int j: js)
+            {
+                double dv = solve(i, j).total_dv;
+                invalid += dv == INVALID_MARKER;
+                lowest = std::min(lowest, dv);
+                highest = std::max(highest, dv);
+            }
+        }
+
+        if (invalid == 9)
+            return false;
+        if (invalid > 0)
+            return true;
+
+        int extent = std::max(i1 - i0, j1 - j0);
+        return lowest < options.dv_threshold || (highest - lowest) / extent > options.gradient_threshold;
+    }
+
+    void refine(int i0, int j0, int i1, int j1, int depth)
+    {
+        // corners are solved first, leaves included
+        if (!needsRefinement(i0, j0, i1, j1) || (i1 - i0 <= 1 && j1 - j0 <= 1))
+        {
+            leaves.push_back({i0, j0, i1, j1, depth});
+            return;
+        }
+
+        int im = midpoint(i0, i1);
+        int jm = midpoint(j0, j1);
+
+        refine(i0, j0, im, jm, depth + 1);
+        if (jm < j1)
+            refine(i0, jm, im, j1, depth + 1);
+        if (im < i1)
+            refine(im, j0, i1, jm, depth + 1);
+        if (im < i1 && jm < j1)
+            refine(im, jm, i1, j1, depth + 1);
+    }
+};
+
+}
+
+AdaptivePorkchop computePorkchopPlotAdaptive(double mu, const double *r1, const double *v1, const double *r2,
+                                             const double *v2, const double *d1, const double *d2,
+                                             int num_departure_dates, int num_arrival_dates,
+                                             double departure_planet_mu, double arrival_planet_mu,
+                                             double departure_orbit_radius, double arrival_orbit_radius,
+                                             const AdaptiveOptions &options)
+{
+    AdaptivePorkchop plot;
+    plot.num_departure_dates = num_departure_dates;
+    plot.num_arrival_dates = num_arrival_dates;
+
+    if (num_departure_dates <= 0 || num_arrival_dates <= 0)
+        return plot;
+
+    AdaptiveContext context;
+    context.mu = mu;
+    context.r1 = r1;
+    context.v1 = v1;
+    context.r2 = r2;
+    context.v2 = v2;
+    context.d1 = d1;
+    context.d2 = d2;
+    context.num_arrival_dates = num_arrival_dates;
+    context.v_orbit_dep = std::sqrt(departure_planet_mu / departure_orbit_radius);
+    context.v_orbit_arr = std::sqrt(arrival_planet_mu / arrival_orbit_radius);
+    context.options = options;
+
+    int step = std::max(1, options.coarse_step);
+
+    for (int i0 = 0; i0 < std::max(1, num_departure_dates - 1); i0 += step)
+    {
+        int i1 = std::min(i0 + step, num_departure_dates - 1);
+        for (int j0 = 0; j0 < std::max(1, num_arrival_dates - 1); j0 += step)
+        {
+            int j1 = std::min(j0 + step, num_arrival_dates - 1);
+            context.refine(i0, j0, i1, j1, 0);
+        }
+    }
+
+    plot.samples.reserve(context.samples.size());
+    for (const auto &entry: context.samples)
+        plot.samples.push_back(entry.second);
+
+    std::sort(plot.samples.begin(), plot.samples.end(), [](const PorkchopSample &a, const PorkchopSample &b)
+    {
+        return a.i != b.i ? a.i < b.i : a.j < b.j;
+    });
+
+    plot.leaves = std::move(context.leaves);
+    return plot;
+}
+
+void resamplePorkchop(const AdaptivePorkchop &plot, double *result_c3, double *result_dv1, double *result_total_dv)
+{
+    int num_arrival_dates = plot.num_arrival_dates;
+
+    std::unordered_map<long long, const PorkchopSample *> solved;
+    solved.reserve(plot.samples.size());
+    for (const PorkchopSample &sample: plot.samples)
+        solved[static_cast<long long>(sample.i) * num_arrival_dates + sample.j] = &sample;
+
+    auto corner = [&](int i, int j)
+    {
+        return solved.at(static_cast<long long>(i) * num_arrival_dates + j);
+    };
+
+    for (const PorkchopLeaf &leaf: plot.leaves)
+    {
+        const PorkchopSample *s00 = corner(leaf.i0, leaf.j0);
+        const PorkchopSample *s01 = corner(leaf.i0, leaf.j1);
+        const PorkchopSample *s10 = corner(leaf.i1, leaf.j0);
+        const PorkchopSample *s11 = corner(leaf.i1, leaf.j1);
+
+        for (int i = leaf.i0; i <= leaf.i1; ++i)
+        {
+            double a = leaf.i1 > leaf.i0 ? double(i - leaf.i0) / (leaf.i1 - leaf.i0) : 0.;
+            for (int j = leaf.j0; j <= leaf.j1; ++j)
+            {
+                double b = leaf.j1 > leaf.j0 ? double(j - leaf.j0) / (leaf.j1 - leaf.j0) : 0.;
+                double w00 = (1 - a) * (1 - b), w01 = (1 - a) * b, w10 = a * (1 - b), w11 = a * b;
+
+                int index = i * num_arrival_dates + j;
+                result_c3[index] = w00 * s00->c3 + w01 * s01->c3 + w10 * s10->c3 + w11 * s11->c3;
+                result_dv1[index] = w00 * s00->dv1 + w01 * s01->dv1 + w10 * s10->dv1 + w11 * s11->dv1;
+                result_total_dv[index] = w00 * s00->total_dv + w01 * s01->total_dv
+                                         + w10 * s10->total_dv + w11 * s11->total_dv;
+            }
+        }
+    }
+
+    for (const PorkchopSample &sample: plot.samples)
+    {
+        int index = sample.i * num_arrival_dates + sample.j;
+        result_c3[index] = sample.c3;
+        result_dv1[index] = sample.dv1;
+        result_total_dv[index] = sample.total_dv;
+    }
+}
+
+int computePorkchopPlotAdaptive_wrapper(double mu, const double *r1, const double *v1, const double *r2,
+                                        const double *v2, const double *d1, const double *d2,
+                                        int num_departure_dates, int num_arrival_dates,
+                                        double departure_planet_mu, double arrival_planet_mu,
+                                        double departure_orbit_radius, double arrival_orbit_radius,
+                                        int coarse_step, double dv_threshold, double gradient_threshold,
+                                        double *result_c3, double *result_dv1, double *result_total_dv)
+{
+    AdaptiveOptions options;
+    options.coarse_step = coarse_step;
+    options.dv_threshold = dv_threshold;
+    options.gradient_threshold = gradient_threshold;
+
+    AdaptivePorkchop plot = computePorkchopPlotAdaptive(mu, r1, v1, r2, v2, d1, d2,
+                                                        num_departure_dates, num_arrival_dates,
+                                                        departure_planet_mu, arrival_planet_mu,
+                                                        departure_orbit_radius, arrival_orbit_radius, options);
+
+    resamplePorkchop(plot, result_c3, result_dv1, result_total_dv);
+    return static_cast<int>(plot.samples.size());
+}
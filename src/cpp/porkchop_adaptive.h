@@ -0,0 +1,72 @@
+#ifndef LAMBERT_PORKCHOP_ADAPTIVE_H
+#define LAMBERT_PORKCHOP_ADAPTIVE_H
+
+#include "battin1984.h"
+#include <vector>
+
+// Coarse-to-fine porkchop. The input ephemeris grid is the finest resolution; only every coarse_step-th
+// node is solved up front, and quadtree tiles are split down to single grid steps where they may hold a
+// launch window (some sampled node below dv_threshold), where total dv changes quickly (more than
+// gradient_threshold km/s per grid step across the tile) or where they cross the edge of the valid region. A tile
+// is sampled at its corners, edge midpoints and centre.
+struct AdaptiveOptions
+{
+    int coarse_step = 16;
+    double dv_threshold = 15.0;
+    double gradient_threshold = 0.5;
+};
+
+struct PorkchopSample
+{
+    int i;
+    int j;
+    double c3;
+    double dv1;
+    double total_dv;
+};
+
+// Quadtree leaf: the closed node range [i0, i1] x [j0, j1], with solved corners.
+struct PorkchopLeaf
+{
+    int i0;
+    int j0;
+    int i1;
+    int j1;
+    int depth;
+};
+
+struct AdaptivePorkchop
+{
+    int num_departure_dates = 0;
+    int num_arrival_dates = 0;
+    std::vector<PorkchopSample> samples;    // every solved node, in row-major order
+    std::vector<PorkchopLeaf> leaves;
+};
+
+AdaptivePorkchop computePorkchopPlotAdaptive(double mu, const double *r1, const double *v1, const double *r2,
+                                             const double *v2, const double *d1, const double *d2,
+                                             int num_departure_dates, int num_arrival_dates,
+                                             double departure_planet_mu, double arrival_planet_mu,
+                                             double departure_orbit_radius, double arrival_orbit_radius,
+                                             const AdaptiveOptions &options = AdaptiveOptions());
+
+// Dense grid from the sparse result: solved nodes exactly, the rest bilinearly from their leaf corners.
+void resamplePorkchop(const AdaptivePorkchop &plot, double *result_c3, double *result_dv1, double *result_total_dv);
+
+extern "C"
+{
+
+// Adaptive solve straight into dense result arrays; returns the number of cells actually solved.
+#ifdef EMSCRIPTEN
+EMSCRIPTEN_KEEPALIVE
+#endif
+int computePorkchopPlotAdaptive_wrapper(double mu, const double *r1, const double *v1, const double *r2,
+                                        const double *v2, const double *d1, const double *d2,
+                                        int num_departure_dates, int num_arrival_dates,
+                                        double departure_planet_mu, double arrival_planet_mu,
+                                        double departure_orbit_radius, double arrival_orbit_radius,
+                                        int coarse_step, double dv_threshold, double gradient_threshold,
+                                        double *result_c3, double *result_dv1, double *result_total_dv);
+}
+
+#endif //LAMBERT_PORKCHOP_ADAPTIVE_H
@@ -0,0 +1,202 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "porkchop_engine.h"
+#include "porkchop_io.h"
+#include "porkchop_optimum.h"
+
+// porkchop: solves a porkchop grid from two ephemeris tables on all cores and writes the grid in the binary
+// format of porkchop_io.h. With no --departure/--arrival files both tables are read from stdin, departure first;
+// the grid goes to stdout unless --output is given.
+
+static void printUsage()
+{
+    std::cerr << "usage: porkchop [--departure FILE] [--arrival FILE] [--output FILE]\n"
+                 "                 [--mu KM3S2] [--departure-mu KM3S2] [--arrival-mu KM3S2]\n"
+                 "                 [--departure-radius KM] [--arrival-radius KM] [--threads N] [--float32]\n"
+                 "                 [--prune-above KMS] [--precision double|mixed|float] [--optima N]\n"
+                 "                 [--solver battin|izzo|gooding|auto]\n";
+}
+
+static bool readTable(const std::string &path, EphemerisTable &table)
+{
+    if (path.empty() || path == "-")
+        return readEphemerisTable(std::cin, table);
+
+    std::ifstream in(path, std::ios::binary);
+    return in && readEphemerisTable(in, table);
+}
+
+int main(int argc, char **argv)
+{
+    std::string departure_path, arrival_path, output_path;
+    double mu = 132712440018.0;
+    double departure_planet_mu = 398600.4418, arrival_planet_mu = 42828.375214;
+    double departure_orbit_radius = 6778.0, arrival_orbit_radius = 3396.0;
+    bool float32 = false;
+    int num_optima = 0;
+    PorkchopOptions options;
+    PorkchopPruning pruning;
+    PruningStats pruning_stats;
+    pruning.stats = &pruning_stats;
+
+    for (int k = 1; k < argc; ++k)
+    {
+        std::string arg = argv[k];
+        bool has_value = k + 1 < argc;
+
+        if (arg == "--float32")
+            float32 = true;
+        else if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            return 0;
+        }
+        else if (!has_value)
+        {
+            printUsage();
+            return 2;
+        }
+        else if (arg == "--departure")
+            departure_path = argv[++k];
+        else if (arg == "--arrival")
+            arrival_path = argv[++k];
+        else if (arg == "--output")
+            output_path = argv[++k];
+        else if (arg == "--mu")
+            mu = std::atof(argv[++k]);
+        else if (arg == "--departure-mu")
+            departure_planet_mu = std::atof(argv[++k]);
+        else if (arg == "--arrival-mu")
+            arrival_planet_mu = std::atof(argv[++k]);
+        else if (arg == "--departure-radius")
+            departure_orbit_radius = std::atof(argv[++k]);
+        else if (arg == "--arrival-radius")
+            arrival_orbit_radius = std::atof(argv[++k]);
+        else if (arg == "--threads")
+            options.num_threads = std::atoi(argv[++k]);
+        else if (arg == "--precision")
+        {
+            std::string precision = argv[++k];
+            if (precision == "double")
+                options.precision = PRECISION_DOUBLE;
+            else if (precision == "mixed")
+                options.precision = PRECISION_MIXED;
+            else if (precision == "float")
+                options.precision = PRECISION_FLOAT;
+            else
+            {
+                std::cerr << "porkchop: unknown precision " << precision << "\n";
+                printUsage();
+                return 2;
+            }
+        }
+        else if (arg == "--solver")
+        {
+            std::string solver = argv[++k];
+            if (solver == "battin")
+                options.backend = LAMBERT_BATTIN;
+            else if (solver == "izzo")
+                options.backend = LAMBERT_IZZO;
+            else if (solver == "gooding")
+                options.backend = LAMBERT_GOODING;
+            else if (solver == "auto")
+                options.backend = LAMBERT_AUTO;
+            else
+            {
+                std::cerr << "porkchop: unknown solver " << solver << "\n";
+                printUsage();
+                return 2;
+            }
+        }
+        else if (arg == "--optima")
+            num_optima = std::atoi(argv[++k]);
+        else if (arg == "--prune-above")
+        {
+            pruning.max_total_dv = std::atof(argv[++k]);
+            options.pruning = &pruning;
+        }
+        else
+        {
+            std::cerr << "porkchop: unknown option " << arg << "\n";
+            printUsage();
+            return 2;
+        }
+    }
+
+    std::ios::sync_with_stdio(false);
+
+    EphemerisTable departure, arrival;
+    if (!readTable(departure_path, departure) || !readTable(arrival_path, arrival))
+    {
+        std::cerr << "porkchop: malformed ephemeris table\n";
+        return 1;
+    }
+
+    int n = departure.count();
+    int m = arrival.count();
+    size_t cells = static_cast<size_t>(n) * m;
+    std::vector<double> c3(cells), dv1(cells), total_dv(cells);
+
+    auto start = std::chrono::steady_clock::now();
+
+    // the batch-kernel path solves every cell as the WASM module does, so both produce the same grid for the
+    // result caches; cells rejected above the pruning limit hold PRUNED_MARKER
+    const MetricOutput outputs[] = {
+            {METRIC_C3, METRIC_FLOAT64, c3.data()},
+            {METRIC_DV1, METRIC_FLOAT64, dv1.data()},
+            {METRIC_TOTAL_DV, METRIC_FLOAT64, total_dv.data()}
+    };
+    computePorkchopMetricsParallel(mu, departure.r.data(), departure.v.data(), arrival.r.data(), arrival.v.data(),
+                                   departure.jd.data(), arrival.jd.data(), n, m, departure_planet_mu,
+                                   arrival_planet_mu, departure_orbit_radius, arrival_orbit_radius, outputs, 3,
+                                   options);
+
+    std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+    std::cerr << "porkchop: " << n << " x " << m << " cells in " << duration.count() << " ms\n";
+
+    if (options.pruning)
+        std::cerr << "porkchop: pruned " << pruning_stats.bounded + pruning_stats.rejected << " cells ("
+                  << pruning_stats.bounded << " by bound), skipped " << pruning_stats.branches_skipped
+                  << " branches\n";
+
+    if (num_optima > 0)
+    {
+        HermiteEphemeris departure_ephemeris(departure.jd.data(), departure.r.data(), departure.v.data(), n, mu);
+        HermiteEphemeris arrival_ephemeris(arrival.jd.data(), arrival.r.data(), arrival.v.data(), m, mu);
+        OptimumSearch search;
+        search.max_count = num_optima;
+        search.backend = options.backend;
+
+        std::vector<PorkchopOptimum> optima = findPorkchopOptima(
+                mu, departure_ephemeris, arrival_ephemeris, departure.jd.data(), arrival.jd.data(), n, m,
+                departure_planet_mu, arrival_planet_mu, departure_orbit_radius, arrival_orbit_radius,
+                {METRIC_TOTAL_DV, METRIC_FLOAT64, total_dv.data()}, search);
+
+        for (const PorkchopOptimum &o: optima)
+            std::cerr << "porkchop: minimum " << std::fixed << std::setprecision(4) << o.total_dv
+                      << " km/s, C3 " << o.c3 << " km^2/s^2, departure JD " << o.departure_jd
+                      << ", arrival JD " << o.arrival_jd << "\n" << std::defaultfloat;
+    }
+
+    bool written;
+    if (output_path.empty() || output_path == "-")
+        written = writePorkchopGrid(std::cout, departure, arrival, c3.data(), dv1.data(), total_dv.data(), float32)
+                  && std::cout.flush();
+    else
+    {
+        std::ofstream out(output_path, std::ios::binary);
+        written = out && writePorkchopGrid(out, departure, arrival, c3.data(), dv1.data(), total_dv.data(), float32);
+    }
+
+    if (!written)
+    {
+        std::cerr << "porkchop: failed to write the grid\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,232 @@
+#include "porkchop_contour.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <unordered_map>
+
+void ContourSet::clear()
+{
+    levels.clear();
+    offsets.assign(1, 0);
+    points.clear();
+}
+
+namespace
+{
+
+// Where a level crosses a grid edge. Horizontal edges (i, j)-(i + 1, j) have id 2 * (i * num_arrival_dates + j),
+// vertical edges (i, j)-(i, j + 1) the next odd id; both squares sharing an edge compute the same crossing.
+struct Crossing
+{
+    int64_t edge;
+    float x;
+    float y;
+};
+
+struct Segment
+{
+    Crossing ends[2];
+};
+
+// Corners of a square in order (i, j), (i + 1, j), (i + 1, j + 1), (i, j + 1), bit k set when corner k is at or
+// above the level; edges 0 bottom, 1 right, 2 top, 3 left. Pairs of edges joined per case, -1 past the last pair.
+// The saddles 5 and 10 are listed with their centre below the level; 15 - case gives the centre above.
+constexpr int8_t SQUARE_SEGMENTS[16][4] = {
+        {-1, -1, -1, -1},
+        {3, 0, -1, -1},
+        {0, 1, -1, -1},
+        {3, 1, -1, -1},
+        {1, 2, -1, -1},
+        {3, 0, 1, 2},
+        {0, 2, -1, -1},
+        {3, 2, -1, -1},
+        {2, 3, -1, -1},
+        {0, 2, -1, -1},
+        {0, 1, 2, 3},
+        {1, 2, -1, -1},
+        {3, 1, -1, -1},
+        {0, 1, -1, -1},
+        {3, 0, -1, -1},
+        {-1, -1, -1, -1},
+};
+
+Crossing squareCrossing(int i, int j, int num_arrival_dates, const double c[4], double level, int edge)
+{
+    int64_t cell = static_cast<int64_t>(i) * num_arrival_dates + j;
+
+    switch (edge)
+    {
+        case 0:
+            return {2 * cell, static_cast<float>(i + (level - c[0]) / (c[1] - c[0])), static_cast<float>(j)};
+        case 1:
+            return {2 * (cell + num_arrival_dates) + 1, static_cast<float>(i + 1),
+                    static_cast<float>(j + (level - c[1]) / (c[2] - c[1]))};
+        case 2:
+            return {2 * (cell + 1), static_cast<float>(i + (level - c[3]) / (c[2] - c[3])), static_cast<float>(j + 1)};
+        default:
+            return {2 * cell + 1, static_cast<float>(i), static_cast<float>(j + (level - c[0]) / (c[3] - c[0]))};
+    }
+}
+
+// Chains the segments of one level into polylines: open chains first, each traced from an end no other segment
+// shares, then the closed loops.
+void joinSegments(const std::vector<Segment> &segments, double level, ContourSet &contours)
+{
+    // an edge borders two squares, so at most two segments meet there
+    std::unordered_map<int64_t, std::array<int, 2>> at_edge;
+    at_edge.reserve(2 * segments.size());
+    for (int s = 0; s < static_cast<int>(segments.size()); ++s)
+    {
+        for (const Crossing &end: segments[s].ends)
+        {
+            std::array<int, 2> &slots = at_edge.try_emplace(end.edge, std::array<int, 2>{-1, -1}).first->second;
+            slots[slots[0] < 0 ? 0 : 1] = s;
+        }
+    }
+
+    std::vector<bool> used(segments.size(), false);
+    auto push = [&](const Crossing &c)
+    {
+        contours.points.push_back(c.x);
+        contours.points.push_back(c.y);
+    };
+
+    auto trace = [&](int s, int entry)
+    {
+        push(segments[s].ends[entry]);
+        while (true)
+        {
+            used[s] = true;
+            const Crossing &exit = segments[s].ends[1 - entry];
+            push(exit);
+
+            const std::array<int, 2> &slots = at_edge[exit.edge];
+            int next = slots[0] == s ? slots[1] : slots[0];
+            if (next < 0 || used[next])
+                break;
+
+            entry = segments[next].ends[0].edge == exit.edge ? 0 : 1;
+            s = next;
+        }
+
+        contours.levels.push_back(level);
+        contours.offsets.push_back(static_cast<uint32_t>(contours.points.size() / 2));
+    };
+
+    for (int s = 0; s < static_cast<int>(segments.size()); ++s)
+    {
+        for (int end = 0; end < 2 && !used[s]; ++end)
+        {
+            if (at_edge[segments[s].ends[end].edge][1] < 0)
+                trace(s, end);
+        }
+    }
+
+    for (int s = 0; s < static_cast<int>(segments.size()); ++s)
+    {
+        if (!used[s])
+            trace(s, 0);
+    }
+}
+
+// value(i, j) is NaN where a cell has no value. Reads every cell once, two departure rows at a time, for all levels.
+template<typename Value>
+void contourGrid(const Value &value, int num_departure_dates, int num_arrival_dates, const double *levels,
+                 int num_levels, ContourSet &contours)
+{
+    contours.clear();
+    if (num_departure_dates < 2 || num_arrival_dates < 2 || num_levels <= 0)
+        return;
+
+    std::vector<std::vector<Segment>> segments(num_levels);
+    std::vector<double> row(num_arrival_dates), next(num_arrival_dates);
+    for (int j = 0; j < num_arrival_dates; ++j)
+        next[j] = value(0, j);
+
+    for (int i = 0; i + 1 < num_departure_dates; ++i)
+    {
+        row.swap(next);
+        for (int j = 0; j < num_arrival_dates; ++j)
+            next[j] = value(i + 1, j);
+
+        for (int j = 0; j + 1 < num_arrival_dates; ++j)
+        {
+            const double c[4] = {row[j], next[j], next[j + 1], row[j + 1]};
+            if (std::isnan(c[0]) || std::isnan(c[1]) || std::isnan(c[2]) || std::isnan(c[3]))
+                continue;
+
+            double low = std::min(std::min(c[0], c[1]), std::min(c[2], c[3]));
+            double high = std::max(std::max(c[0], c[1]), std::max(c[2], c[3]));
+
+            for (int l = 0; l < num_levels; ++l)
+            {
+                double level = levels[l];
+                if (!(level > low && level <= high))
+                    continue;
+
+                int square = (c[0] >= level) | (c[1] >= level) << 1 | (c[2] >= level) << 2 | (c[3] >= level) << 3;
+                if ((square == 5 || square == 10) && 0.25 * (c[0] + c[1] + c[2] + c[3]) >= level)
+                    square = 15 - square;
+
+                const int8_t *edges = SQUARE_SEGMENTS[square];
+                for (int k = 0; k < 4 && edges[k] >= 0; k += 2)
+                {
+                    segments[l].push_back({{squareCrossing(i, j, num_arrival_dates, c, level, edges[k]),
+                                            squareCrossing(i, j, num_arrival_dates, c, level, edges[k + 1])}});
+                }
+            }
+        }
+    }
+
+    for (int l = 0; l < num_levels; ++l)
+        joinSegments(segments[l], levels[l], contours);
+}
+
+}
+
+void contourPorkchopMetric(const MetricOutput &grid, int num_departure_dates, int num_arrival_dates,
+                           const double *levels, int num_levels, ContourSet &contours)
+{
+    // every metric but the declination uses negative values as markers
+    bool signed_values = grid.metric == METRIC_DLA;
+    auto value = [&](int i, int j)
+    {
+        double v = readMetric(grid, static_cast<size_t>(i) * num_arrival_dates + j);
+        return signed_values || v >= 0 ? v : NAN;
+    };
+
+    contourGrid(value, num_departure_dates, num_arrival_dates, levels, num_levels, contours);
+}
+
+void contourTimeOfFlight(const double *d1, const double *d2, int num_departure_dates, int num_arrival_dates,
+                         const double *levels, int num_levels, ContourSet &contours)
+{
+    auto value = [&](int i, int j) { return d2[j] - d1[i]; };
+    contourGrid(value, num_departure_dates, num_arrival_dates, levels, num_levels, contours);
+}
+
+void contourArrivalDate(const double *d2, int num_departure_dates, int num_arrival_dates, const double *levels,
+                        int num_levels, ContourSet &contours)
+{
+    contours.clear();
+    if (num_departure_dates < 1 || num_arrival_dates < 1)
+        return;
+
+    for (int l = 0; l < num_levels; ++l)
+    {
+        double level = levels[l];
+        if (!(level >= d2[0] && level <= d2[num_arrival_dates - 1]))
+            continue;
+
+        int k = static_cast<int>(std::upper_bound(d2, d2 + num_arrival_dates, level) - d2) - 1;
+        double y = k;
+        if (k + 1 < num_arrival_dates && d2[k + 1] > d2[k])
+            y += (level - d2[k]) / (d2[k + 1] - d2[k]);
+
+        contours.points.insert(contours.points.end(), {0.f, static_cast<float>(y),
+                                                       static_cast<float>(num_departure_dates - 1),
+                                                       static_cast<float>(y)});
+        contours.levels.push_back(level);
+        contours.offsets.push_back(static_cast<uint32_t>(contours.points.size() / 2));
+    }
+}
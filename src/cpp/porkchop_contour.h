@@ -0,0 +1,38 @@
+#ifndef LAMBERT_PORKCHOP_CONTOUR_H
+#define LAMBERT_PORKCHOP_CONTOUR_H
+
+#include <cstdint>
+#include <vector>
+#include "porkchop_metrics.h"
+
+// Isolines of porkchop grids as polylines, so a plot can draw contours without receiving the grid itself: a few
+// kilobytes of points against megabytes of cells. Coordinates are fractional grid indices, x along the departure
+// dates and y along the arrival dates, in the index space the plot already uses for its axes.
+struct ContourSet
+{
+    std::vector<double> levels;     // per polyline
+    std::vector<uint32_t> offsets = {0};  // polyline k is points offsets[k] to offsets[k + 1]; one more than polylines
+    std::vector<float> points;      // x, y pairs; a closed polyline repeats its first point at the end
+
+    size_t polylineCount() const { return levels.size(); }
+    void clear();
+};
+
+// Marching squares over a metric grid (any format, departure-major) at each of the given levels, replacing the
+// contents of contours. Squares with a cell that holds no value (NaN, or a negative marker outside METRIC_DLA)
+// are skipped, so lines end at unsolved and pruned regions; cells at a cutoff are contoured as their clamped
+// value. Saddle squares are split by the mean of their corners. Segments are joined into polylines, open ones
+// running from boundary to boundary.
+void contourPorkchopMetric(const MetricOutput &grid, int num_departure_dates, int num_arrival_dates,
+                           const double *levels, int num_levels, ContourSet &contours);
+
+// Lines of constant time of flight, levels in days (isochrones), from the date axes alone; no solve is needed.
+void contourTimeOfFlight(const double *d1, const double *d2, int num_departure_dates, int num_arrival_dates,
+                         const double *levels, int num_levels, ContourSet &contours);
+
+// Lines of constant arrival date, levels in JD: one line across the departure axis per level inside the arrival
+// dates (horizontal in departure/arrival axes). d2 must be increasing.
+void contourArrivalDate(const double *d2, int num_departure_dates, int num_arrival_dates, const double *levels,
+                        int num_levels, ContourSet &contours);
+
+#endif //LAMBERT_PORKCHOP_CONTOUR_H
@@ -0,0 +1,259 @@
+#include "porkchop_engine.h"
+#include "tile_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+int resolveThreadCount(int num_threads)
+{
+    if (num_threads > 0)
+        return num_threads;
+
+    unsigned int hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? static_cast<int>(hardware) : 1;
+}
+
+int porkchopTileCount(int num_departure_dates, int num_arrival_dates, const PorkchopOptions &options)
+{
+    int tile_rows = std::max(1, options.tile_rows);
+    int tile_cols = std::max(1, options.tile_cols);
+    return ((num_departure_dates + tile_rows - 1) / tile_rows) * ((num_arrival_dates + tile_cols - 1) / tile_cols);
+}
+
+void computePorkchopPlotParallel(double mu, const double *r1, const double *v1, const double *r2, const double *v2,
+                                 const double *d1, const double *d2, int num_departure_dates, int num_arrival_dates,
+                                 double departure_planet_mu, double arrival_planet_mu,
+                                 double departure_orbit_radius, double arrival_orbit_radius,
+                                 double *result_c3, double *result_dv1, double *result_total_dv,
+                                 const PorkchopOptions &options)
+{
+    if (num_departure_dates <= 0 || num_arrival_dates <= 0)
+        return;
+
+    double v_orbit_dep = std::sqrt(departure_planet_mu / departure_orbit_radius);
+    double v_orbit_arr = std::sqrt(arrival_planet_mu / arrival_orbit_radius);
+
+    std::vector<double> departure_times(num_departure_dates);
+    std::vector<double> arrival_times(num_arrival_dates);
+    for (int i = 0; i < num_departure_dates; ++i)
+        departure_times[i] = julianDateToSeconds(d1[i]);
+    for (int j = 0; j < num_arrival_dates; ++j)
+        arrival_times[j] = julianDateToSeconds(d2[j]);
+
+    int tile_rows = std::max(1, options.tile_rows);
+    int tile_cols = std::max(1, options.tile_cols);
+    int tiles_i = (num_departure_dates + tile_rows - 1) / tile_rows;
+    int tiles_j = (num_arrival_dates + tile_cols - 1) / tile_cols;
+    int num_tiles = tiles_i * tiles_j;
+
+    int num_workers = std::min(resolveThreadCount(options.num_threads), num_tiles);
+    TileScheduler scheduler(num_tiles, num_workers);
+
+    std::vector<IterationStats> worker_stats(num_workers);
+#ifdef LAMBERT_INSTRUMENT
+    std::vector<InstrumentationCounters> worker_counters(num_workers);
+#endif
+
+    auto worker = [&](int worker_id)
+    {
+        IterationStats *stats = options.stats ? &worker_stats[worker_id] : nullptr;
+
+        int tile;
+        while (scheduler.next(worker_id, tile))
+        {
+            int i_begin = (tile / tiles_j) * tile_rows;
+            int j_begin = (tile % tiles_j) * tile_cols;
+            int i_end = std::min(i_begin + tile_rows, num_departure_dates);
+            int j_end = std::min(j_begin + tile_cols, num_arrival_dates);
+
+#ifdef LAMBERT_INSTRUMENT
+            auto tile_start = std::chrono::steady_clock::now();
+#endif
+
+            for (int i = i_begin; i < i_end; ++i)
+            {
+                vec3d r1_departure = {r1[i * 3], r1[i * 3 + 1], r1[i * 3 + 2]};
+                vec3d v1_departure = {v1[i * 3], v1[i * 3 + 1], v1[i * 3 + 2]};
+                double r1_norm = r1_departure.norm();
+
+                // continuation restarts at every tile edge so the result does not depend on the schedule
+                WarmStart warm;
+
+                for (int j = j_begin; j < j_end; ++j)
+                {
+                    vec3d r2_arrival = {r2[j * 3], r2[j * 3 + 1], r2[j * 3 + 2]};
+                    vec3d v2_arrival = {v2[j * 3], v2[j * 3 + 1], v2[j * 3 + 2]};
+
+                    int index = i * num_arrival_dates + j;
+
+#ifdef LAMBERT_INSTRUMENT
+                    solveTrace() = SolveTrace();
+#endif
+
+                    if (options.max_revs > 0)
+                    {
+                        int n_rev;
+                        computePorkchopCellMultiRev(mu, r1_departure, r1_norm, v1_departure, r2_arrival, v2_arrival,
+                                                    departure_times[i], arrival_times[j], v_orbit_dep, v_orbit_arr,
+                                                    options.max_revs, result_c3[index], result_dv1[index],
+                                                    result_total_dv[index], n_rev,
+                                                    options.warm_start ? &warm : nullptr, stats, options.backend);
+                        if (options.result_nrev)
+                            options.result_nrev[index] = n_rev;
+                    }
+                    else
+                    {
+                        computePorkchopCell(mu, r1_departure, r1_norm, v1_departure, r2_arrival, v2_arrival,
+                                            departure_times[i], arrival_times[j], v_orbit_dep, v_orbit_arr,
+                                            result_c3[index], result_dv1[index], result_total_dv[index],
+                                            options.warm_start ? &warm : nullptr, stats, options.backend);
+                    }
+
+#ifdef LAMBERT_INSTRUMENT
+                    if (options.instrumentation)
+                        recordCell(*options.instrumentation, worker_counters[worker_id], index);
+#endif
+                }
+            }
+
+#ifdef LAMBERT_INSTRUMENT
+            if (options.instrumentation)
+            {
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - tile_start;
+                InstrumentationCounters &counters = worker_counters[worker_id];
+
+                ++counters.tiles;
+                counters.tile_seconds += elapsed.count();
+                counters.max_tile_seconds = std::max(counters.max_tile_seconds, elapsed.count());
+
+                if (options.instrumentation->tile_seconds)
+                    options.instrumentation->tile_seconds[tile] = elapsed.count();
+            }
+#endif
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_workers - 1);
+    for (int t = 1; t < num_workers; ++t)
+        threads.emplace_back(worker, t);
+
+    worker(0);
+
+    for (auto &thread: threads)
+        thread.join();
+
+    if (options.stats)
+    {
+        for (const IterationStats &stats: worker_stats)
+            *options.stats += stats;
+    }
+
+#ifdef LAMBERT_INSTRUMENT
+    if (options.instrumentation)
+    {
+        for (const InstrumentationCounters &counters: worker_counters)
+            options.instrumentation->counters += counters;
+    }
+#endif
+}
+
+void computePorkchopPlotParallel(double mu, const Ephemeris &departure, const DateRange &departure_dates,
+                                 const Ephemeris &arrival, const DateRange &arrival_dates,
+                                 double departure_planet_mu, double arrival_planet_mu,
+                                 double departure_orbit_radius, double arrival_orbit_radius,
+                                 double *result_c3, double *result_dv1, double *result_total_dv,
+                                 const PorkchopOptions &options)
+{
+    int n = departure_dates.count;
+    int m = arrival_dates.count;
+
+    std::vector<double> d1(n), r1(3 * n), v1(3 * n);
+    std::vector<double> d2(m), r2(3 * m), v2(3 * m);
+    sampleEphemeris(departure, departure_dates, d1.data(), r1.data(), v1.data());
+    sampleEphemeris(arrival, arrival_dates, d2.data(), r2.data(), v2.data());
+
+    computePorkchopPlotParallel(mu, r1.data(), v1.data(), r2.data(), v2.data(), d1.data(), d2.data(), n, m,
+                                departure_planet_mu, arrival_planet_mu, departure_orbit_radius, arrival_orbit_radius,
+                                result_c3, result_dv1, result_total_dv, options);
+}
+
+void computePorkchopMetricsParallel(double mu, const double *r1, const double *v1, const double *r2, const double *v2,
+                                    const double *d1, const double *d2, int num_departure_dates,
+                                    int num_arrival_dates, double departure_planet_mu, double arrival_planet_mu,
+                                    double departure_orbit_radius, double arrival_orbit_radius,
+                                    const MetricOutput *outputs, int num_outputs, const PorkchopOptions &options)
+{
+    if (num_departure_dates <= 0 || num_arrival_dates <= 0 || num_outputs <= 0)
+        return;
+
+    int tile_rows = std::max(1, options.tile_rows);
+    int num_tiles = (num_departure_dates + tile_rows - 1) / tile_rows;
+
+    int num_workers = std::min(resolveThreadCount(options.num_threads), num_tiles);
+    TileScheduler scheduler(num_tiles, num_workers);
+
+    // each worker accumulates its own pruning counts
+    std::vector<PruningStats> worker_stats(num_workers);
+    std::vector<PorkchopPruning> worker_pruning(num_workers);
+
+    auto worker = [&](int worker_id)
+    {
+        std::vector<MetricOutput> shifted(num_outputs);
+
+        const PorkchopPruning *pruning = nullptr;
+        if (options.pruning)
+        {
+            worker_pruning[worker_id] = *options.pruning;
+            worker_pruning[worker_id].stats = &worker_stats[worker_id];
+            pruning = &worker_pruning[worker_id];
+        }
+
+        int tile;
+        while (scheduler.next(worker_id, tile))
+        {
+            int i_begin = tile * tile_rows;
+            int rows = std::min(tile_rows, num_departure_dates - i_begin);
+
+            offsetMetricOutputs(outputs, num_outputs, i_begin, num_arrival_dates, shifted.data());
+            computePorkchopMetrics(mu, r1 + 3 * i_begin, v1 + 3 * i_begin, r2, v2, d1 + i_begin, d2, rows,
+                                   num_arrival_dates, departure_planet_mu, arrival_planet_mu,
+                                   departure_orbit_radius, arrival_orbit_radius, shifted.data(), num_outputs,
+                                   pruning, options.precision, options.backend);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_workers - 1);
+    for (int t = 1; t < num_workers; ++t)
+        threads.emplace_back(worker, t);
+
+    worker(0);
+
+    for (auto &thread: threads)
+        thread.join();
+
+    if (options.pruning && options.pruning->stats)
+    {
+        for (const PruningStats &stats: worker_stats)
+            *options.pruning->stats += stats;
+    }
+}
+
+void computePorkchopPlotParallel_wrapper(double mu, const double *r1, const double *v1, const double *r2,
+                                         const double *v2, const double *d1, const double *d2,
+                                         int num_departure_dates, int num_arrival_dates,
+                                         double departure_planet_mu, double arrival_planet_mu,
+                                         double departure_orbit_radius, double arrival_orbit_radius,
+                                         double *result_c3, double *result_dv1, double *result_total_dv,
+                                         int num_threads)
+{
+    PorkchopOptions options;
+    options.num_threads = num_threads;
+
+    computePorkchopPlotParallel(mu, r1, v1, r2, v2, d1, d2, num_departure_dates, num_arrival_dates,
+                                departure_planet_mu, arrival_planet_mu, departure_orbit_radius, arrival_orbit_radius,
+                                result_c3, result_dv1, result_total_dv, options);
+}
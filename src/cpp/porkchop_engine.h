@@ -0,0 +1,67 @@
+#ifndef LAMBERT_PORKCHOP_ENGINE_H
+#define LAMBERT_PORKCHOP_ENGINE_H
+
+#include "battin1984.h"
+#include "izzo2015.h"
+#include "instrumentation.h"
+#include "ephemeris.h"
+#include "porkchop_metrics.h"
+
+struct PorkchopOptions
+{
+    int num_threads = 0;    // 0 = std::thread::hardware_concurrency()
+    int tile_rows = 8;
+    int tile_cols = 256;
+    bool warm_start = false;            // seed each cell with the converged x of its left neighbour in the tile row
+    IterationStats *stats = nullptr;    // optional; filling it re-runs warm-started solves cold for the comparison
+    int max_revs = 0;                   // > 0 keeps the best of all multi-revolution solutions up to this count
+    int *result_nrev = nullptr;         // optional, revolution count of the kept solution per cell
+    PorkchopInstrumentation *instrumentation = nullptr;  // filled only in LAMBERT_INSTRUMENT builds
+    const PorkchopPruning *pruning = nullptr;           // computePorkchopMetricsParallel only
+    SolverPrecision precision = PRECISION_DOUBLE;       // computePorkchopMetricsParallel only
+    LambertBackend backend = LAMBERT_BATTIN;            // zero-revolution solver, see lambert_solver.h
+};
+
+// Number of tiles the engine splits the grid into, i.e. the length of PorkchopInstrumentation::tile_seconds.
+int porkchopTileCount(int num_departure_dates, int num_arrival_dates, const PorkchopOptions &options);
+
+// Tiled, work-stealing version of computePorkchopPlot. With warm_start off (the default) and the Battin backend,
+// results are bit-identical to the serial path; warm-started grids agree with it only to within the solver
+// tolerance, so callers that cache or compare grids leave it off.
+void computePorkchopPlotParallel(double mu, const double *r1, const double *v1, const double *r2, const double *v2,
+                                 const double *d1, const double *d2, int num_departure_dates, int num_arrival_dates,
+                                 double departure_planet_mu, double arrival_planet_mu,
+                                 double departure_orbit_radius, double arrival_orbit_radius,
+                                 double *result_c3, double *result_dv1, double *result_total_dv,
+                                 const PorkchopOptions &options = PorkchopOptions());
+
+// Parallel grid over date ranges, with both ephemerides evaluated up front.
+void computePorkchopPlotParallel(double mu, const Ephemeris &departure, const DateRange &departure_dates,
+                                 const Ephemeris &arrival, const DateRange &arrival_dates,
+                                 double departure_planet_mu, double arrival_planet_mu,
+                                 double departure_orbit_radius, double arrival_orbit_radius,
+                                 double *result_c3, double *result_dv1, double *result_total_dv,
+                                 const PorkchopOptions &options = PorkchopOptions());
+
+// computePorkchopMetrics with blocks of tile_rows departure rows spread over the threads; results are identical
+// to the serial call. warm_start, max_revs and stats do not apply to this path; pruning, precision and backend do.
+void computePorkchopMetricsParallel(double mu, const double *r1, const double *v1, const double *r2, const double *v2,
+                                    const double *d1, const double *d2, int num_departure_dates,
+                                    int num_arrival_dates, double departure_planet_mu, double arrival_planet_mu,
+                                    double departure_orbit_radius, double arrival_orbit_radius,
+                                    const MetricOutput *outputs, int num_outputs,
+                                    const PorkchopOptions &options = PorkchopOptions());
+
+extern "C"
+{
+
+void computePorkchopPlotParallel_wrapper(double mu, const double *r1, const double *v1, const double *r2,
+                                         const double *v2, const double *d1, const double *d2,
+                                         int num_departure_dates, int num_arrival_dates,
+                                         double departure_planet_mu, double arrival_planet_mu,
+                                         double departure_orbit_radius, double arrival_orbit_radius,
+                                         double *result_c3, double *result_dv1, double *result_total_dv,
+                                         int num_threads);
+}
+
+#endif //LAMBERT_PORKCHOP_ENGINE_H
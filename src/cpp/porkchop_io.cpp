@@ -0,0 +1,113 @@
+#include "porkchop_io.h"
+#include <algorithm>
+#include <cstring>
+
+static const char EPHEMERIS_TABLE_MAGIC[4] = {'E', 'P', 'H', 'C'};
+static const char PORKCHOP_GRID_MAGIC[4] = {'P', 'K', 'C', 'H'};
+
+// The formats are little-endian, as are every target this builds for (x86-64, AArch64, wasm32).
+template<typename T>
+static bool readArray(std::istream &in, T *data, size_t count)
+{
+    in.read(reinterpret_cast<char *>(data), static_cast<std::streamsize>(count * sizeof(T)));
+    return static_cast<size_t>(in.gcount()) == count * sizeof(T);
+}
+
+// Reads count values into data, growing it a chunk at a time, so a count from a corrupt or truncated header fails
+// on the short read instead of allocating all of it up front.
+template<typename T>
+static bool readVector(std::istream &in, std::vector<T> &data, size_t count)
+{
+    constexpr size_t CHUNK = size_t(1) << 16;
+
+    data.clear();
+    while (data.size() < count)
+    {
+        size_t offset = data.size();
+        size_t n = std::min(CHUNK, count - offset);
+        data.resize(offset + n);
+        if (!readArray(in, data.data() + offset, n))
+            return false;
+    }
+    return true;
+}
+
+template<typename T>
+static void writeArray(std::ostream &out, const T *data, size_t count)
+{
+    out.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+static void writePadding(std::ostream &out, size_t bytes)
+{
+    static const char zeros[8] = {0};
+    out.write(zeros, static_cast<std::streamsize>((8 - bytes % 8) % 8));
+}
+
+bool readEphemerisTable(std::istream &in, EphemerisTable &table)
+{
+    char header[EPHEMERIS_TABLE_HEADER_BYTES];
+    if (!readArray(in, header, sizeof(header)) || std::memcmp(header, EPHEMERIS_TABLE_MAGIC, 4) != 0)
+        return false;
+
+    uint32_t version, count;
+    std::memcpy(&version, header + 4, 4);
+    std::memcpy(&count, header + 8, 4);
+    if (version != EPHEMERIS_TABLE_VERSION)
+        return false;
+
+    return readVector(in, table.jd, count) &&
+           readVector(in, table.r, 3 * static_cast<size_t>(count)) &&
+           readVector(in, table.v, 3 * static_cast<size_t>(count));
+}
+
+bool writeEphemerisTable(std::ostream &out, const EphemerisTable &table)
+{
+    char header[EPHEMERIS_TABLE_HEADER_BYTES] = {0};
+    uint32_t version = EPHEMERIS_TABLE_VERSION;
+    uint32_t count = static_cast<uint32_t>(table.count());
+    double start = count > 0 ? table.jd[0] : 0.;
+    double step = count > 1 ? table.jd[1] - table.jd[0] : 0.;
+
+    std::memcpy(header, EPHEMERIS_TABLE_MAGIC, 4);
+    std::memcpy(header + 4, &version, 4);
+    std::memcpy(header + 8, &count, 4);
+    std::memcpy(header + 16, &start, 8);
+    std::memcpy(header + 24, &step, 8);
+
+    out.write(header, sizeof(header));
+    writeArray(out, table.jd.data(), table.jd.size());
+    writeArray(out, table.r.data(), table.r.size());
+    writeArray(out, table.v.data(), table.v.size());
+    return static_cast<bool>(out);
+}
+
+bool writePorkchopGrid(std::ostream &out, const EphemerisTable &departure, const EphemerisTable &arrival,
+                       const double *c3, const double *dv1, const double *total_dv, bool float32)
+{
+    uint32_t header[4];
+    std::memcpy(&header[0], PORKCHOP_GRID_MAGIC, 4);
+    header[1] = static_cast<uint32_t>(departure.count());
+    header[2] = static_cast<uint32_t>(arrival.count());
+    header[3] = float32 ? 4 : 8;
+
+    size_t cells = static_cast<size_t>(departure.count()) * arrival.count();
+
+    writeArray(out, header, 4);
+    writeArray(out, departure.jd.data(), departure.jd.size());
+    writeArray(out, arrival.jd.data(), arrival.jd.size());
+
+    for (const double *grid: {c3, dv1, total_dv})
+    {
+        if (float32)
+        {
+            std::vector<float> narrowed(grid, grid + cells);
+            writeArray(out, narrowed.data(), cells);
+            writePadding(out, cells * sizeof(float));
+        }
+        else
+            writeArray(out, grid, cells);
+    }
+
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,43 @@
+#ifndef LAMBERT_PORKCHOP_IO_H
+#define LAMBERT_PORKCHOP_IO_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+// Binary formats shared with the Node backend (src/backend/utils/ephemerisCache.js) and the browser result cache
+// (public/porkchop/resultCache.js). All values are little-endian.
+//
+// Ephemeris table, 64-byte header then float64 arrays:
+//   "EPHC", uint32 version, uint32 count, uint32 0, float64 first JD, float64 step days, zero padding,
+//   jd[count], r[3 count], v[3 count]
+//
+// Porkchop grid, 16-byte header then arrays each padded to 8 bytes:
+//   "PKCH", uint32 departure count n, uint32 arrival count m, uint32 bytes per value (8 or 4),
+//   float64 departure jd[n], float64 arrival jd[m], c3[n m], dv1[n m], total_dv[n m]   (departure-major)
+
+constexpr uint32_t EPHEMERIS_TABLE_VERSION = 1;
+constexpr int EPHEMERIS_TABLE_HEADER_BYTES = 64;
+constexpr int PORKCHOP_GRID_HEADER_BYTES = 16;
+
+struct EphemerisTable
+{
+    std::vector<double> jd;
+    std::vector<double> r;
+    std::vector<double> v;
+
+    int count() const { return static_cast<int>(jd.size()); }
+};
+
+// Reads one table; false on a bad header or a short read. Several tables can follow each other in a stream.
+bool readEphemerisTable(std::istream &in, EphemerisTable &table);
+
+bool writeEphemerisTable(std::ostream &out, const EphemerisTable &table);
+
+// The grids are doubles whatever precision solved them (PorkchopOptions::precision); float32 narrows them on
+// output only.
+bool writePorkchopGrid(std::ostream &out, const EphemerisTable &departure, const EphemerisTable &arrival,
+                       const double *c3, const double *dv1, const double *total_dv, bool float32);
+
+#endif //LAMBERT_PORKCHOP_IO_H
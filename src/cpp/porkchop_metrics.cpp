@@ -0,0 +1,452 @@
+#include "porkchop_metrics.h"
+#include "battin1984.h"
+#include "lambert_solver.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+constexpr double SECONDS_PER_DAY = 86400.0;
+constexpr double J2000_OBLIQUITY = 84381.448 / 3600.0 * M_PI / 180.0;
+
+MetricRange metricRange(PorkchopMetric metric)
+{
+    switch (metric)
+    {
+        case METRIC_C3:
+            return {0.0, MAX_C3_CUTOFF};
+        case METRIC_TOF:
+            return {0.0, MAX_TOF / SECONDS_PER_DAY};
+        case METRIC_DLA:
+            return {-90.0, 90.0};
+        default:
+            return {0.0, MAX_DV_CUTOFF};
+    }
+}
+
+size_t metricFormatBytes(MetricFormat format)
+{
+    switch (format)
+    {
+        case METRIC_FLOAT32:
+            return sizeof(float);
+        case METRIC_UINT16:
+            return sizeof(uint16_t);
+        default:
+            return sizeof(double);
+    }
+}
+
+uint16_t quantizeMetric(PorkchopMetric metric, double value)
+{
+    if (std::isnan(value))
+        return QUANTIZED_INVALID;
+    if (value == PRUNED_MARKER && metric != METRIC_TOF && metric != METRIC_DLA)
+        return QUANTIZED_PRUNED;
+
+    MetricRange range = metricRange(metric);
+    double t = std::clamp((value - range.min) / (range.max - range.min), 0.0, 1.0);
+    return static_cast<uint16_t>(std::lround(t * QUANTIZED_MAX));
+}
+
+double dequantizeMetric(PorkchopMetric metric, uint16_t code)
+{
+    if (code == QUANTIZED_INVALID)
+        return NAN;
+    if (code == QUANTIZED_PRUNED)
+        return PRUNED_MARKER;
+
+    MetricRange range = metricRange(metric);
+    return range.min + (range.max - range.min) * code / QUANTIZED_MAX;
+}
+
+double readMetric(const MetricOutput &output, size_t index)
+{
+    switch (output.format)
+    {
+        case METRIC_FLOAT32:
+            return static_cast<const float *>(output.data)[index];
+        case METRIC_UINT16:
+            return dequantizeMetric(output.metric, static_cast<const uint16_t *>(output.data)[index]);
+        default:
+            return static_cast<const double *>(output.data)[index];
+    }
+}
+
+void offsetMetricOutputs(const MetricOutput *outputs, int num_outputs, size_t row, int num_arrival_dates,
+                         MetricOutput *shifted)
+{
+    for (int k = 0; k < num_outputs; ++k)
+    {
+        size_t offset = row * num_arrival_dates * metricFormatBytes(outputs[k].format);
+        shifted[k] = outputs[k];
+        shifted[k].data = static_cast<unsigned char *>(outputs[k].data) + offset;
+    }
+}
+
+static void storeMetricRow(const MetricOutput &output, size_t offset, const double *values, int count)
+{
+    switch (output.format)
+    {
+        case METRIC_FLOAT64:
+            std::copy(values, values + count, static_cast<double *>(output.data) + offset);
+            break;
+        case METRIC_FLOAT32:
+        {
+            float *out = static_cast<float *>(output.data) + offset;
+            for (int j = 0; j < count; ++j)
+                out[j] = static_cast<float>(values[j]);
+            break;
+        }
+        case METRIC_UINT16:
+        {
+            uint16_t *out = static_cast<uint16_t *>(output.data) + offset;
+            for (int j = 0; j < count; ++j)
+                out[j] = quantizeMetric(output.metric, values[j]);
+            break;
+        }
+    }
+}
+
+PruningStats &PruningStats::operator+=(const PruningStats &other)
+{
+    bounded += other.bounded;
+    rejected += other.rejected;
+    branches_skipped += other.branches_skipped;
+    return *this;
+}
+
+// No conic through both positions has a semi-major axis below s / 2, so the transfer speed at either end is at
+// least sqrt(mu (2 / r - 2 / s)) (hyperbolas are faster still), and v∞ at least its excess over the body's speed.
+static double totalDvLowerBound(double mu, const TransferGeometry &g, double v_body_departure,
+                                double v_body_arrival, double v_orbit_dep, double v_orbit_arr)
+{
+    double v_min_departure = std::sqrt(mu * (2. / g.r1_norm - 2. / g.semiperimeter));
+    double v_min_arrival = std::sqrt(mu * (2. / g.r2_norm - 2. / g.semiperimeter));
+
+    double v_inf_departure = std::max(0., v_min_departure - v_body_departure);
+    double v_inf_arrival = std::max(0., v_min_arrival - v_body_arrival);
+
+    double c3 = std::min(v_inf_departure * v_inf_departure, MAX_C3_CUTOFF);
+    double dv1 = std::sqrt(2. * v_orbit_dep * v_orbit_dep + c3) - v_orbit_dep;
+    double dv2 = std::sqrt(2. * v_orbit_arr * v_orbit_arr + v_inf_arrival * v_inf_arrival) - v_orbit_arr;
+    return dv1 + dv2;
+}
+
+struct BranchMetrics
+{
+    double total_dv;
+    double c3;
+    double dv1;
+    double dv2;
+    double v_inf_arrival;
+    vec3d v_inf_departure;
+};
+
+void computePorkchopMetrics(double mu, const double *r1, const double *v1, const double *r2, const double *v2,
+                            const double *d1, const double *d2, int num_departure_dates, int num_arrival_dates,
+                            double departure_planet_mu, double arrival_planet_mu,
+                            double departure_orbit_radius, double arrival_orbit_radius,
+                            const MetricOutput *outputs, int num_outputs, const PorkchopPruning *pruning,
+                            SolverPrecision precision, LambertBackend backend)
+{
+    if (num_departure_dates <= 0 || num_arrival_dates <= 0 || num_outputs <= 0)
+        return;
+
+    bool prograde = true;
+
+    const double v_orbit_dep_sq = departure_planet_mu / departure_orbit_radius;
+    const double v_orbit_arr_sq = arrival_planet_mu / arrival_orbit_radius;
+    const double v_orbit_dep = std::sqrt(v_orbit_dep_sq);
+    const double v_orbit_arr = std::sqrt(v_orbit_arr_sq);
+
+    const double sin_obliquity = std::sin(J2000_OBLIQUITY);
+    const double cos_obliquity = std::cos(J2000_OBLIQUITY);
+
+    bool prune = pruning && pruning->max_total_dv > 0;
+    bool batch = backend == LAMBERT_BATTIN
+                 || (backend == LAMBERT_AUTO && prune && battinBatchLanes() >= AUTO_BATCH_LANES);
+    double prune_above = prune ? pruning->max_total_dv * (1. + pruning->margin) : 0.;
+    SolverPrecision polish_precision = precision == PRECISION_FLOAT ? PRECISION_FLOAT : PRECISION_DOUBLE;
+    PruningStats stats;
+
+    // one row of every requested metric, converted to the output formats once the row is done
+    bool requested[NUM_PORKCHOP_METRICS] = {};
+    std::vector<double> row[NUM_PORKCHOP_METRICS];
+    for (int k = 0; k < num_outputs; ++k)
+    {
+        requested[outputs[k].metric] = true;
+        row[outputs[k].metric].resize(num_arrival_dates);
+    }
+
+    bool solve = false;
+    for (int metric = 0; metric < NUM_PORKCHOP_METRICS; ++metric)
+        solve = solve || (requested[metric] && metric != METRIC_TOF);
+
+    std::vector<double> arrival_times(num_arrival_dates);
+    for (int j = 0; j < num_arrival_dates; ++j)
+        arrival_times[j] = julianDateToSeconds(d2[j]);
+
+    // per-row work lists, structure-of-arrays for the batch kernel;
+    // short-path problems go to [0, count), long-path problems to [count, 2 * count)
+    std::vector<int> cells(num_arrival_dates);
+    std::vector<TransferGeometry> geometry(num_arrival_dates);
+    std::vector<BattinParameters> params(2 * num_arrival_dates);
+    std::vector<double> l1(2 * num_arrival_dates), m(2 * num_arrival_dates), x0(2 * num_arrival_dates);
+    std::vector<double> x(2 * num_arrival_dates), y(2 * num_arrival_dates);
+
+    // transfer velocities of the cell-by-cell backends, same slots
+    std::vector<vec3d> v1_solved, v2_solved;
+    if (!batch)
+    {
+        v1_solved.resize(2 * num_arrival_dates);
+        v2_solved.resize(2 * num_arrival_dates);
+    }
+
+    // pruning: branches still in play after the coarse pass, and the polish pass over them
+    std::vector<char> keep(2 * num_arrival_dates, 1);
+    std::vector<int> polish_slots;
+    std::vector<double> polish_l1, polish_m, polish_x0, polish_x, polish_y;
+    if (prune && batch)
+    {
+        polish_slots.resize(2 * num_arrival_dates);
+        polish_l1.resize(2 * num_arrival_dates);
+        polish_m.resize(2 * num_arrival_dates);
+        polish_x0.resize(2 * num_arrival_dates);
+        polish_x.resize(2 * num_arrival_dates);
+        polish_y.resize(2 * num_arrival_dates);
+    }
+
+    auto set = [&](PorkchopMetric metric, int j, double value)
+    {
+        if (requested[metric])
+            row[metric][j] = value;
+    };
+
+    auto markPruned = [&](int j)
+    {
+        set(METRIC_C3, j, PRUNED_MARKER);
+        set(METRIC_DV1, j, PRUNED_MARKER);
+        set(METRIC_DV2, j, PRUNED_MARKER);
+        set(METRIC_TOTAL_DV, j, PRUNED_MARKER);
+        set(METRIC_VINF_ARRIVAL, j, PRUNED_MARKER);
+        set(METRIC_DLA, j, NAN);
+    };
+
+    for (int i = 0; i < num_departure_dates; ++i)
+    {
+        double departure_time = julianDateToSeconds(d1[i]);
+        vec3d r1_departure = {r1[i * 3], r1[i * 3 + 1], r1[i * 3 + 2]};
+        vec3d v1_departure = {v1[i * 3], v1[i * 3 + 1], v1[i * 3 + 2]};
+        double r1_norm = r1_departure.norm();
+        double v1_departure_norm = v1_departure.norm();
+
+        int count = 0;
+        for (int j = 0; j < num_arrival_dates; ++j)
+        {
+            double tof = arrival_times[j] - departure_time;
+            set(METRIC_TOF, j, tof / SECONDS_PER_DAY);
+
+            if (arrival_times[j] <= departure_time || tof < MIN_TOF)
+            {
+                set(METRIC_C3, j, MAX_C3_CUTOFF);
+                set(METRIC_DV1, j, MAX_DV_CUTOFF);
+                set(METRIC_DV2, j, MAX_DV_CUTOFF);
+                set(METRIC_TOTAL_DV, j, MAX_DV_CUTOFF);
+                set(METRIC_VINF_ARRIVAL, j, MAX_DV_CUTOFF);
+                set(METRIC_DLA, j, NAN);
+                continue;
+            }
+
+            if (!solve)
+                continue;
+
+            vec3d r2_arrival = {r2[j * 3], r2[j * 3 + 1], r2[j * 3 + 2]};
+            geometry[count] = getTransferGeometry(r1_departure, r2_arrival, r1_norm);
+
+            if (prune)
+            {
+                double v2_arrival_norm = std::sqrt(v2[j * 3] * v2[j * 3] + v2[j * 3 + 1] * v2[j * 3 + 1]
+                                                   + v2[j * 3 + 2] * v2[j * 3 + 2]);
+                if (totalDvLowerBound(mu, geometry[count], v1_departure_norm, v2_arrival_norm,
+                                      v_orbit_dep, v_orbit_arr) > pruning->max_total_dv)
+                {
+                    markPruned(j);
+                    ++stats.bounded;
+                    continue;
+                }
+            }
+
+            cells[count++] = j;
+        }
+
+        for (int k = 0; k < count; ++k)
+        {
+            int j = cells[k];
+            double tof = arrival_times[j] - departure_time;
+
+            for (int branch = 0; branch < 2; ++branch)
+            {
+                int slot = branch * count + k;
+                if (!batch)
+                {
+                    vec3d r2_arrival = {r2[j * 3], r2[j * 3 + 1], r2[j * 3 + 2]};
+                    lambertBranch(backend, mu, geometry[k], r1_departure, r2_arrival, tof, branch == 0,
+                                  v1_solved[slot], v2_solved[slot]);
+                    continue;
+                }
+
+                params[slot] = getBattinParameters(mu, geometry[k], tof, prograde, branch == 0);
+                l1[slot] = params[slot].l1;
+                m[slot] = params[slot].m;
+                x0[slot] = params[slot].x0;
+            }
+        }
+
+        // with pruning this is the coarse pass; branches that survive it are polished to tol below
+        if (count > 0 && batch)
+        {
+            if (prune)
+                battinIterateBatch(l1.data(), m.data(), x0.data(), x.data(), y.data(), 2 * count, 100,
+                                   pruning->coarse_tolerance, CF_FIXED_DEPTH,
+                                   precision == PRECISION_DOUBLE ? PRECISION_DOUBLE : PRECISION_FLOAT);
+            else
+                battinIterateBatch(l1.data(), m.data(), x0.data(), x.data(), y.data(), 2 * count, 100, tol,
+                                   CF_FIXED_DEPTH, precision);
+        }
+
+        auto evaluate = [&](int k, int branch)
+        {
+            int j = cells[k];
+            int slot = branch * count + k;
+            double tof = arrival_times[j] - departure_time;
+            vec3d r2_arrival = {r2[j * 3], r2[j * 3 + 1], r2[j * 3 + 2]};
+            vec3d v2_arrival = {v2[j * 3], v2[j * 3 + 1], v2[j * 3 + 2]};
+
+            vec3d v1_transfer, v2_transfer;
+            if (batch)
+                std::tie(v1_transfer, v2_transfer) = battinVelocities(params[slot], geometry[k], r1_departure,
+                                                                      r2_arrival, tof, x[slot], y[slot]);
+            else
+            {
+                v1_transfer = v1_solved[slot];
+                v2_transfer = v2_solved[slot];
+            }
+
+            BranchMetrics b;
+            b.v_inf_departure = v1_transfer - v1_departure;
+            double c3_departure_sq = b.v_inf_departure.squaredNorm();
+            b.c3 = std::min(c3_departure_sq, MAX_C3_CUTOFF);
+            b.dv1 = std::sqrt(2.0 * v_orbit_dep_sq + b.c3) - v_orbit_dep;
+
+            double c3_arrival_sq = (v2_arrival - v2_transfer).squaredNorm();
+            b.dv2 = std::sqrt(2.0 * v_orbit_arr_sq + c3_arrival_sq) - v_orbit_arr;
+            b.v_inf_arrival = std::sqrt(c3_arrival_sq);
+
+            b.total_dv = b.dv1 + b.dv2;
+            return b;
+        };
+
+        if (prune && count > 0)
+        {
+            int polish = 0;
+            for (int k = 0; k < count; ++k)
+            {
+                double short_dv = evaluate(k, 0).total_dv;
+                double long_dv = evaluate(k, 1).total_dv;
+
+                // NaN compares false throughout, so unsolved branches are never the reason to drop a cell
+                if (short_dv > prune_above && long_dv > prune_above)
+                {
+                    keep[k] = keep[count + k] = 0;
+                    ++stats.rejected;
+                    continue;
+                }
+
+                // the cell-by-cell backends solved both branches fully already
+                if (!batch)
+                {
+                    keep[k] = keep[count + k] = 1;
+                    continue;
+                }
+
+                keep[k] = !(short_dv > long_dv * (1. + pruning->margin));
+                keep[count + k] = !(long_dv > short_dv * (1. + pruning->margin));
+                stats.branches_skipped += !keep[k] + !keep[count + k];
+
+                for (int branch = 0; branch < 2; ++branch)
+                {
+                    int slot = branch * count + k;
+                    if (!keep[slot])
+                        continue;
+
+                    polish_slots[polish] = slot;
+                    polish_l1[polish] = l1[slot];
+                    polish_m[polish] = m[slot];
+                    polish_x0[polish] = x[slot];
+                    ++polish;
+                }
+            }
+
+            if (polish > 0)
+                battinIterateBatch(polish_l1.data(), polish_m.data(), polish_x0.data(), polish_x.data(),
+                                   polish_y.data(), polish, 100, tol, CF_FIXED_DEPTH, polish_precision);
+
+            for (int p = 0; p < polish; ++p)
+            {
+                x[polish_slots[p]] = polish_x[p];
+                y[polish_slots[p]] = polish_y[p];
+            }
+        }
+
+        for (int k = 0; k < count; ++k)
+        {
+            int j = cells[k];
+
+            if (prune && !keep[k] && !keep[count + k])
+            {
+                markPruned(j);
+                continue;
+            }
+
+            BranchMetrics best;
+            best.total_dv = std::numeric_limits<double>::infinity();
+            best.c3 = MAX_C3_CUTOFF;
+            best.dv1 = best.dv2 = MAX_DV_CUTOFF;
+            best.v_inf_arrival = NAN;
+            best.v_inf_departure = vec3d::Constant(NAN);
+
+            for (int branch = 0; branch < 2; ++branch)
+            {
+                if (prune && !keep[branch * count + k])
+                    continue;
+
+                BranchMetrics candidate = evaluate(k, branch);
+                if (candidate.total_dv < best.total_dv)
+                    best = candidate;
+            }
+
+            // past the cutoff the Δv metrics saturate, as in computePorkchopPlot_SIMD
+            bool within_cutoff = best.total_dv < MAX_DV_CUTOFF;
+
+            set(METRIC_C3, j, within_cutoff ? std::min(best.c3, MAX_C3_CUTOFF) : MAX_C3_CUTOFF);
+            set(METRIC_DV1, j, within_cutoff ? std::min(best.dv1, MAX_DV_CUTOFF) : MAX_DV_CUTOFF);
+            set(METRIC_DV2, j, within_cutoff ? std::min(best.dv2, MAX_DV_CUTOFF) : MAX_DV_CUTOFF);
+            set(METRIC_TOTAL_DV, j, within_cutoff ? best.total_dv : MAX_DV_CUTOFF);
+            set(METRIC_VINF_ARRIVAL, j, within_cutoff ? std::min(best.v_inf_arrival, MAX_DV_CUTOFF) : MAX_DV_CUTOFF);
+
+            if (requested[METRIC_DLA])
+            {
+                double z_equatorial = best.v_inf_departure.y() * sin_obliquity
+                                      + best.v_inf_departure.z() * cos_obliquity;
+                row[METRIC_DLA][j] = std::asin(z_equatorial / best.v_inf_departure.norm()) * 180.0 / M_PI;
+            }
+        }
+
+        size_t offset = static_cast<size_t>(i) * num_arrival_dates;
+        for (int k = 0; k < num_outputs; ++k)
+            storeMetricRow(outputs[k], offset, row[outputs[k].metric].data(), num_arrival_dates);
+    }
+
+    if (prune && pruning->stats)
+        *pruning->stats += stats;
+}
@@ -0,0 +1,108 @@
+#ifndef LAMBERT_PORKCHOP_METRICS_H
+#define LAMBERT_PORKCHOP_METRICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "battin1984_batch.h"
+
+// Per-cell quantities a porkchop sweep can return. Every cell keeps the branch (short or long path) with the
+// lower total Δv; the metrics below describe that branch. Cells with no transfer (arrival before departure, or a
+// time of flight under MIN_TOF) hold the cutoffs, as computePorkchopPlot does, and NaN for the declination.
+enum PorkchopMetric
+{
+    METRIC_C3,              // launch energy, km^2/s^2, clamped to MAX_C3_CUTOFF
+    METRIC_DV1,             // departure burn from a circular parking orbit, km/s
+    METRIC_DV2,             // arrival burn into a circular orbit, km/s
+    METRIC_TOTAL_DV,        // km/s, clamped to MAX_DV_CUTOFF
+    METRIC_VINF_ARRIVAL,    // arrival hyperbolic excess speed, km/s, clamped to MAX_DV_CUTOFF
+    METRIC_TOF,             // time of flight, days
+    METRIC_DLA,             // declination of the launch asymptote on the Earth mean equator of J2000, deg
+    NUM_PORKCHOP_METRICS
+};
+
+enum MetricFormat
+{
+    METRIC_FLOAT64,
+    METRIC_FLOAT32,
+    METRIC_UINT16   // linear over metricRange(), QUANTIZED_PRUNED for PRUNED_MARKER, QUANTIZED_INVALID for NaN
+};
+
+constexpr uint16_t QUANTIZED_MAX = 65533;
+constexpr uint16_t QUANTIZED_PRUNED = 65534;
+constexpr uint16_t QUANTIZED_INVALID = 65535;
+
+struct MetricRange
+{
+    double min;
+    double max;
+};
+
+// Quantization range of a metric; values outside it saturate. The step is (max - min) / QUANTIZED_MAX, e.g.
+// 0.8 m/s for the Δv metrics.
+MetricRange metricRange(PorkchopMetric metric);
+
+size_t metricFormatBytes(MetricFormat format);
+
+uint16_t quantizeMetric(PorkchopMetric metric, double value);
+
+double dequantizeMetric(PorkchopMetric metric, uint16_t code);
+
+// One requested grid: data holds num_departure_dates * num_arrival_dates values of the given format,
+// departure-major like the other porkchop grids.
+struct MetricOutput
+{
+    PorkchopMetric metric;
+    MetricFormat format;
+    void *data;
+};
+
+// Value of one cell, dequantized for METRIC_UINT16.
+double readMetric(const MetricOutput &output, size_t index);
+
+// Copy of outputs shifted to start at grid row `row`, for solving a slice of rows into the full grids.
+void offsetMetricOutputs(const MetricOutput *outputs, int num_outputs, size_t row, int num_arrival_dates,
+                         MetricOutput *shifted);
+
+struct PruningStats
+{
+    long long bounded = 0;          // cells rejected by the geometric bound, before any iteration
+    long long rejected = 0;         // cells rejected after the coarse pass
+    long long branches_skipped = 0; // branches of kept cells not polished because the other branch wins
+
+    PruningStats &operator+=(const PruningStats &other);
+};
+
+// Early rejection of cells whose total Δv lies above max_total_dv. A cell is dropped before iterating when a
+// geometric lower bound on its Δv (minimum-energy transfer speed against the bodies' speeds) already exceeds the
+// limit, or when both branches solved to coarse_tolerance exceed it by more than margin. Of the surviving cells
+// only branches within margin of the better one are polished to full accuracy. Dropped cells hold
+// PRUNED_MARKER in the C3, Δv and v∞ metrics and NaN in DLA; all other cells match the unpruned sweep to within
+// the solver tolerance.
+struct PorkchopPruning
+{
+    double max_total_dv = 10.0;     // km/s
+    double coarse_tolerance = 1e-4;
+    double margin = 0.1;            // relative
+    PruningStats *stats = nullptr;  // optional, accumulated
+};
+
+// Solves the grid row by row through the lane-parallel batch kernel and writes only the requested metrics. No
+// full-grid double scratch is allocated, so each output costs its own format's size per cell and nothing more;
+// a sweep asking for TOF alone skips the Lambert solves entirely. precision selects the kernel's arithmetic (see
+// SolverPrecision); with pruning, the coarse pass runs in float32 under either reduced-precision mode.
+// The batch kernel is Battin's. Any other backend solves cell by cell instead, in float64 whatever precision
+// says and without the coarse pass. Izzo cell by cell outruns the batch kernel on full sweeps (~4x on scalar
+// builds, ~1.2x at 4-8 lanes), but a pruned sweep's coarse pass needs the lanes: LAMBERT_AUTO keeps the batch
+// kernel for pruned sweeps when it has AUTO_BATCH_LANES or more lanes and goes cell by cell otherwise.
+constexpr int AUTO_BATCH_LANES = 4;
+
+void computePorkchopMetrics(double mu, const double *r1, const double *v1, const double *r2, const double *v2,
+                            const double *d1, const double *d2, int num_departure_dates, int num_arrival_dates,
+                            double departure_planet_mu, double arrival_planet_mu,
+                            double departure_orbit_radius, double arrival_orbit_radius,
+                            const MetricOutput *outputs, int num_outputs,
+                            const PorkchopPruning *pruning = nullptr,
+                            SolverPrecision precision = PRECISION_DOUBLE,
+                            LambertBackend backend = LAMBERT_BATTIN);
+
+#endif //LAMBERT_PORKCHOP_METRICS_H
@@ -0,0 +1,319 @@
+#include "porkchop_optimum.h"
+#include "battin1984.h"
+#include "lambert_sensitivity.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Difference step of the Hessian: small against the grid step, large enough that the solver tolerance does not
+// swamp the gradient differences.
+constexpr double MAX_DIFFERENCE_DAYS = 0.1;
+constexpr int SEEDS_PER_OPTIMUM = 4;
+
+// Spacing of the dates next to dates[k]; 0 on a single-date axis.
+static double gridStep(const double *dates, int count, int k)
+{
+    return std::max(dates[std::min(k + 1, count - 1)] - dates[k], dates[k] - dates[std::max(k - 1, 0)]);
+}
+
+static bool validCell(double value, const MetricRange &range)
+{
+    return value >= 0 && value < range.max;
+}
+
+std::vector<GridMinimum> findPorkchopMinima(const MetricOutput &grid, int num_departure_dates, int num_arrival_dates,
+                                            int max_count)
+{
+    std::vector<GridMinimum> minima;
+    if (max_count <= 0)
+        return minima;
+
+    MetricRange range = metricRange(grid.metric);
+    auto value = [&](int i, int j)
+    {
+        return readMetric(grid, static_cast<size_t>(i) * num_arrival_dates + j);
+    };
+
+    for (int i = 0; i < num_departure_dates; ++i)
+    {
+        for (int j = 0; j < num_arrival_dates; ++j)
+        {
+            double center = value(i, j);
+            if (!validCell(center, range))
+                continue;
+
+            bool minimum = true;
+            for (int di = -1; di <= 1 && minimum; ++di)
+            {
+                for (int dj = -1; dj <= 1 && minimum; ++dj)
+                {
+                    int ni = i + di, nj = j + dj;
+                    if ((di == 0 && dj == 0) || ni < 0 || ni >= num_departure_dates || nj < 0
+                        || nj >= num_arrival_dates)
+                        continue;
+
+                    double neighbour = value(ni, nj);
+                    if (!validCell(neighbour, range))
+                        continue;
+
+                    // ties go to the neighbour that comes first, so a plateau keeps only its first cell
+                    bool before = di < 0 || (di == 0 && dj < 0);
+                    minimum = before ? center < neighbour : center <= neighbour;
+                }
+            }
+
+            if (minimum)
+                minima.push_back({i, j, center});
+        }
+    }
+
+    auto lower = [](const GridMinimum &a, const GridMinimum &b) { return a.value < b.value; };
+    if (static_cast<int>(minima.size()) > max_count)
+    {
+        std::partial_sort(minima.begin(), minima.begin() + max_count, minima.end(), lower);
+        minima.resize(max_count);
+    }
+    else
+        std::stable_sort(minima.begin(), minima.end(), lower);
+
+    return minima;
+}
+
+namespace
+{
+
+struct TransferCost
+{
+    double c3;
+    double dv1;
+    double total_dv;
+};
+
+// The porkchop cell at arbitrary dates: both ephemerides evaluated there and the kept branch's costs.
+class TransferObjective
+{
+public:
+    TransferObjective(double mu, const Ephemeris &departure, const Ephemeris &arrival,
+                      double departure_planet_mu, double arrival_planet_mu,
+                      double departure_orbit_radius, double arrival_orbit_radius, OptimumObjective objective,
+                      LambertBackend backend)
+            : mu(mu), departure(departure), arrival(arrival),
+              v_orbit_dep(std::sqrt(departure_planet_mu / departure_orbit_radius)),
+              v_orbit_arr(std::sqrt(arrival_planet_mu / arrival_orbit_radius)), objective(objective),
+              backend(backend) {}
+
+    TransferCost cost(double departure_jd, double arrival_jd) const
+    {
+        vec3d r1, v1, r2, v2;
+        departure.states(&departure_jd, 1, r1.data(), v1.data());
+        arrival.states(&arrival_jd, 1, r2.data(), v2.data());
+
+        TransferCost c;
+        computePorkchopCell(mu, r1, r1.norm(), v1, r2, v2, julianDateToSeconds(departure_jd),
+                            julianDateToSeconds(arrival_jd), v_orbit_dep, v_orbit_arr, c.c3, c.dv1, c.total_dv,
+                            nullptr, nullptr, backend);
+        return c;
+    }
+
+    // Objective value, +inf where the cell has no transfer or sits at a cutoff; past the C3 cutoff Δv1 saturates,
+    // which would otherwise leave false minima along the clamped region.
+    double operator()(double departure_jd, double arrival_jd) const
+    {
+        return value(cost(departure_jd, arrival_jd));
+    }
+
+    // Analytic gradient per day (lambert_sensitivity.h); non-finite where the objective is not differentiable.
+    Eigen::Vector2d gradient(double departure_jd, double arrival_jd) const
+    {
+        vec3d r1, v1, r2, v2;
+        departure.states(&departure_jd, 1, r1.data(), v1.data());
+        arrival.states(&arrival_jd, 1, r2.data(), v2.data());
+
+        Eigen::Vector2d g;
+        porkchopCellGradient(mu, r1, v1, r2, v2, julianDateToSeconds(arrival_jd) - julianDateToSeconds(departure_jd),
+                             v_orbit_dep, v_orbit_arr, objective == OPTIMUM_C3 ? METRIC_C3 : METRIC_TOTAL_DV,
+                             g[0], g[1], backend);
+        return g;
+    }
+
+    double value(const TransferCost &c) const
+    {
+        double v = objective == OPTIMUM_C3 ? c.c3 : c.total_dv;
+        bool valid = c.c3 >= 0 && c.c3 < MAX_C3_CUTOFF && c.total_dv >= 0 && c.total_dv < MAX_DV_CUTOFF;
+        return valid ? v : std::numeric_limits<double>::infinity();
+    }
+
+private:
+    double mu;
+    const Ephemeris &departure;
+    const Ephemeris &arrival;
+    double v_orbit_dep;
+    double v_orbit_arr;
+    OptimumObjective objective;
+    LambertBackend backend;
+};
+
+}
+
+PorkchopOptimum refinePorkchopOptimum(double mu, const Ephemeris &departure, const Ephemeris &arrival,
+                                      const double *d1, const double *d2, int num_departure_dates,
+                                      int num_arrival_dates, double departure_planet_mu, double arrival_planet_mu,
+                                      double departure_orbit_radius, double arrival_orbit_radius,
+                                      const GridMinimum &seed, const OptimumSearch &search)
+{
+    TransferObjective f(mu, departure, arrival, departure_planet_mu, arrival_planet_mu, departure_orbit_radius,
+                        arrival_orbit_radius, search.objective, search.backend);
+
+    int i = seed.departure_index, j = seed.arrival_index;
+
+    // grid step around the seed on each axis: it bounds every step and sets the difference interval; an axis
+    // with a single date stays fixed
+    Eigen::Vector2d reach(gridStep(d1, num_departure_dates, i), gridStep(d2, num_arrival_dates, j));
+
+    Eigen::Vector2d lower(d1[0], d2[0]);
+    Eigen::Vector2d upper(d1[num_departure_dates - 1], d2[num_arrival_dates - 1]);
+
+    Eigen::Vector2d h;
+    for (int axis = 0; axis < 2; ++axis)
+        h[axis] = std::min(MAX_DIFFERENCE_DAYS, 0.25 * reach[axis]);
+
+    Eigen::Vector2d x(d1[i], d2[j]);
+    double fx = f(x[0], x[1]);
+
+    PorkchopOptimum optimum{};
+    optimum.departure_index = i;
+    optimum.arrival_index = j;
+    optimum.refined = std::isfinite(fx);
+
+    auto project = [&](const Eigen::Vector2d &point)
+    {
+        return Eigen::Vector2d(point.cwiseMax(lower).cwiseMin(upper));
+    };
+
+    for (int iteration = 0; optimum.refined && iteration < search.max_iterations; ++iteration)
+    {
+        optimum.iterations = iteration + 1;
+
+        // analytic gradient, Hessian from forward differences of it: three solves where the difference stencil of
+        // the objective took nine; an axis without room (single date, or h vanishing) stays fixed
+        Eigen::Vector2d full_gradient = f.gradient(x[0], x[1]);
+        Eigen::Vector2d gradient = Eigen::Vector2d::Zero();
+        Eigen::Matrix2d hessian = Eigen::Matrix2d::Identity();
+        bool active[2] = {h[0] > 0, h[1] > 0};
+
+        for (int axis = 0; axis < 2; ++axis)
+        {
+            if (!active[axis])
+                continue;
+
+            gradient[axis] = full_gradient[axis];
+            Eigen::Vector2d forward = f.gradient(x[0] + (axis == 0 ? h[0] : 0.), x[1] + (axis == 1 ? h[1] : 0.));
+            for (int other = 0; other < 2; ++other)
+            {
+                if (active[other])
+                    hessian(other, axis) = (forward[other] - full_gradient[other]) / h[axis];
+            }
+        }
+        hessian = 0.5 * (hessian + hessian.transpose()).eval();
+
+        // a gradient or difference reaching past the transfer region ends the search at the current point
+        if (!gradient.allFinite() || !hessian.allFinite())
+            break;
+
+        Eigen::Vector2d step;
+        bool newton = hessian(0, 0) > 0 && hessian.determinant() > 0;
+        if (newton)
+            step = -hessian.ldlt().solve(gradient);
+        else
+            step = -gradient;
+
+        // no trial reaches further than one grid step on either axis
+        double scale = step.cwiseAbs().cwiseQuotient(reach.cwiseMax(1e-300)).maxCoeff();
+        if (!newton || scale > 1)
+            step /= scale > 0 ? scale : 1;
+
+        bool improved = false;
+        Eigen::Vector2d next = x;
+        double f_next = fx;
+        for (double alpha = 1.0; alpha > 1e-6; alpha *= 0.5)
+        {
+            next = project(x + alpha * step);
+            f_next = f(next[0], next[1]);
+            if (f_next < fx)
+            {
+                improved = true;
+                break;
+            }
+        }
+
+        if (!improved)
+            break;
+
+        double moved = (next - x).lpNorm<Eigen::Infinity>();
+        x = next;
+        fx = f_next;
+
+        if (moved < search.tolerance_days)
+            break;
+    }
+
+    TransferCost best = f.cost(x[0], x[1]);
+    optimum.departure_jd = x[0];
+    optimum.arrival_jd = x[1];
+    optimum.c3 = best.c3;
+    optimum.dv1 = best.dv1;
+    optimum.total_dv = best.total_dv;
+    return optimum;
+}
+
+std::vector<PorkchopOptimum> findPorkchopOptima(double mu, const Ephemeris &departure, const Ephemeris &arrival,
+                                                const double *d1, const double *d2, int num_departure_dates,
+                                                int num_arrival_dates, double departure_planet_mu,
+                                                double arrival_planet_mu, double departure_orbit_radius,
+                                                double arrival_orbit_radius, const MetricOutput &grid,
+                                                const OptimumSearch &search)
+{
+    // extra seeds, since several of them usually collapse into one optimum
+    std::vector<GridMinimum> minima = findPorkchopMinima(grid, num_departure_dates, num_arrival_dates,
+                                                         SEEDS_PER_OPTIMUM * search.max_count);
+
+    std::vector<PorkchopOptimum> optima;
+    optima.reserve(minima.size());
+    for (const GridMinimum &seed: minima)
+    {
+        PorkchopOptimum optimum = refinePorkchopOptimum(mu, departure, arrival, d1, d2, num_departure_dates,
+                                                        num_arrival_dates, departure_planet_mu, arrival_planet_mu,
+                                                        departure_orbit_radius, arrival_orbit_radius, seed, search);
+        if (optimum.refined)
+            optima.push_back(optimum);
+    }
+
+    // refinement can reorder neighbouring minima
+    auto objective = [&](const PorkchopOptimum &o)
+    {
+        return search.objective == OPTIMUM_C3 ? o.c3 : o.total_dv;
+    };
+    std::stable_sort(optima.begin(), optima.end(), [&](const PorkchopOptimum &a, const PorkchopOptimum &b)
+    {
+        return objective(a) < objective(b);
+    });
+
+    // seeds along one valley of the grid converge to the same optimum; keep the best of every such group
+    std::vector<PorkchopOptimum> distinct;
+    for (const PorkchopOptimum &candidate: optima)
+    {
+        double departure_step = gridStep(d1, num_departure_dates, candidate.departure_index);
+        double arrival_step = gridStep(d2, num_arrival_dates, candidate.arrival_index);
+
+        bool duplicate = std::any_of(distinct.begin(), distinct.end(), [&](const PorkchopOptimum &kept)
+        {
+            return std::abs(kept.departure_jd - candidate.departure_jd) < 0.5 * departure_step
+                   && std::abs(kept.arrival_jd - candidate.arrival_jd) < 0.5 * arrival_step;
+        });
+
+        if (!duplicate && static_cast<int>(distinct.size()) < search.max_count)
+            distinct.push_back(candidate);
+    }
+
+    return distinct;
+}
@@ -0,0 +1,70 @@
+#ifndef LAMBERT_PORKCHOP_OPTIMUM_H
+#define LAMBERT_PORKCHOP_OPTIMUM_H
+
+#include <vector>
+#include "ephemeris.h"
+#include "porkchop_metrics.h"
+
+enum OptimumObjective
+{
+    OPTIMUM_TOTAL_DV,
+    OPTIMUM_C3
+};
+
+struct GridMinimum
+{
+    int departure_index;
+    int arrival_index;
+    double value;
+};
+
+// Local minima of a metric grid over the 8-neighbourhood, lowest first, at most max_count of them. Cells holding
+// NaN, a negative marker or a value at the top of metricRange() (the cutoffs) are skipped and do not count as
+// neighbours. A plateau of equal values is reported once, at its first cell in departure-major order.
+std::vector<GridMinimum> findPorkchopMinima(const MetricOutput &grid, int num_departure_dates, int num_arrival_dates,
+                                            int max_count);
+
+struct PorkchopOptimum
+{
+    double departure_jd;
+    double arrival_jd;
+    double c3;
+    double dv1;
+    double total_dv;
+    int departure_index;    // grid cell the search started from
+    int arrival_index;
+    int iterations;
+    bool refined;           // false when the seed has no valid transfer (e.g. past the C3 cutoff); dates stay put
+};
+
+struct OptimumSearch
+{
+    OptimumObjective objective = OPTIMUM_TOTAL_DV;
+    int max_count = 5;
+    int max_iterations = 40;
+    double tolerance_days = 1e-5;
+    LambertBackend backend = LAMBERT_BATTIN;    // solver of every trial transfer
+};
+
+// Minimizes the objective over (departure, arrival) dates from a grid cell, solving each trial transfer with
+// search.backend against the continuous ephemerides. Damped Newton steps on the analytic gradient
+// (porkchopCellGradient) and a forward-difference Hessian of it, falling back to steepest descent where the
+// Hessian is not positive definite; every step is limited to one grid step per axis and backtracks until the
+// objective decreases. The search stays inside the grid's date range.
+PorkchopOptimum refinePorkchopOptimum(double mu, const Ephemeris &departure, const Ephemeris &arrival,
+                                      const double *d1, const double *d2, int num_departure_dates,
+                                      int num_arrival_dates, double departure_planet_mu, double arrival_planet_mu,
+                                      double departure_orbit_radius, double arrival_orbit_radius,
+                                      const GridMinimum &seed, const OptimumSearch &search = OptimumSearch());
+
+// Global and local optima of a solved grid, best first and at most max_count: the lowest minima of the
+// objective's metric grid (total Δv or C3, any format), each refined. Seeds that cannot be refined, and seeds that
+// converge within half a grid step of a better optimum, are dropped. The first entry is the global optimum.
+std::vector<PorkchopOptimum> findPorkchopOptima(double mu, const Ephemeris &departure, const Ephemeris &arrival,
+                                                const double *d1, const double *d2, int num_departure_dates,
+                                                int num_arrival_dates, double departure_planet_mu,
+                                                double arrival_planet_mu, double departure_orbit_radius,
+                                                double arrival_orbit_radius, const MetricOutput &grid,
+                                                const OptimumSearch &search = OptimumSearch());
+
+#endif //LAMBERT_PORKCHOP_OPTIMUM_H
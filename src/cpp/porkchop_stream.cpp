@@ -0,0 +1,109 @@
+#include "porkchop_stream.h"
+#include "battin1984.h"
+#include <algorithm>
+
+#ifdef LAMBERT_WASM_THREADS
+#include "porkchop_engine.h"
+#endif
+
+PorkchopJob::PorkchopJob(double mu, const double *r1, const double *v1, const double *r2, const double *v2,
+                         const double *d1, const double *d2, int num_departure_dates, int num_arrival_dates,
+                         double departure_planet_mu, double arrival_planet_mu,
+                         double departure_orbit_radius, double arrival_orbit_radius,
+                         double *result_c3, double *result_dv1, double *result_total_dv)
+        : mu(mu), r1(r1), v1(v1), r2(r2), v2(v2), d1(d1), d2(d2),
+          num_departure_dates(std::max(0, num_departure_dates)), num_arrival_dates(std::max(0, num_arrival_dates)),
+          departure_planet_mu(departure_planet_mu), arrival_planet_mu(arrival_planet_mu),
+          departure_orbit_radius(departure_orbit_radius), arrival_orbit_radius(arrival_orbit_radius),
+          result_c3(result_c3), result_dv1(result_dv1), result_total_dv(result_total_dv)
+{
+}
+
+void PorkchopJob::setMetricOutputs(const MetricOutput *outputs, int num_outputs)
+{
+    metric_outputs.assign(outputs, outputs + num_outputs);
+}
+
+int PorkchopJob::step(int max_rows)
+{
+    if (!metric_outputs.empty())
+        return stepMetrics(max_rows);
+
+    if (!result_c3 || !result_dv1 || !result_total_dv)
+        return 0;
+
+    size_t offset = static_cast<size_t>(rows_completed) * num_arrival_dates;
+    return stepInto(max_rows, result_c3 + offset, result_dv1 + offset, result_total_dv + offset);
+}
+
+int PorkchopJob::stepInto(int max_rows, double *c3, double *dv1, double *total_dv)
+{
+    if (isCancelled() || isDone() || max_rows <= 0)
+        return 0;
+
+    int row_begin = rows_completed;
+    int rows = std::min(max_rows, num_departure_dates - row_begin);
+
+#ifdef LAMBERT_WASM_THREADS
+    // the batch kernel spread over the pool, identical to computePorkchopPlot_SIMD cell for cell
+    const MetricOutput outputs[] = {
+            {METRIC_C3, METRIC_FLOAT64, c3},
+            {METRIC_DV1, METRIC_FLOAT64, dv1},
+            {METRIC_TOTAL_DV, METRIC_FLOAT64, total_dv}
+    };
+    PorkchopOptions options;
+    options.precision = PRECISION_DOUBLE;
+    options.backend = LAMBERT_BATTIN;
+    computePorkchopMetricsParallel(mu, r1 + 3 * row_begin, v1 + 3 * row_begin, r2, v2, d1 + row_begin, d2, rows,
+                                   num_arrival_dates, departure_planet_mu, arrival_planet_mu,
+                                   departure_orbit_radius, arrival_orbit_radius, outputs, 3, options);
+#else
+    computePorkchopPlot_SIMD(mu, r1 + 3 * row_begin, v1 + 3 * row_begin, r2, v2, d1 + row_begin, d2, rows,
+                             num_arrival_dates, departure_planet_mu, arrival_planet_mu,
+                             departure_orbit_radius, arrival_orbit_radius, c3, dv1, total_dv);
+#endif
+
+    rows_completed += rows;
+
+    if (on_rows)
+        on_rows(row_begin, rows_completed);
+
+    return rows;
+}
+
+int PorkchopJob::stepMetrics(int max_rows)
+{
+    if (isCancelled() || isDone() || max_rows <= 0)
+        return 0;
+
+    int row_begin = rows_completed;
+    int rows = std::min(max_rows, num_departure_dates - row_begin);
+
+    std::vector<MetricOutput> shifted(metric_outputs.size());
+    offsetMetricOutputs(metric_outputs.data(), static_cast<int>(metric_outputs.size()), row_begin,
+                        num_arrival_dates, shifted.data());
+
+#ifdef LAMBERT_WASM_THREADS
+    PorkchopOptions options;
+    options.pruning = prune ? &pruning : nullptr;
+    options.precision = precision;
+    options.backend = backend;
+    computePorkchopMetricsParallel(mu, r1 + 3 * row_begin, v1 + 3 * row_begin, r2, v2, d1 + row_begin, d2, rows,
+                                   num_arrival_dates, departure_planet_mu, arrival_planet_mu,
+                                   departure_orbit_radius, arrival_orbit_radius,
+                                   shifted.data(), static_cast<int>(shifted.size()), options);
+#else
+    computePorkchopMetrics(mu, r1 + 3 * row_begin, v1 + 3 * row_begin, r2, v2, d1 + row_begin, d2, rows,
+                           num_arrival_dates, departure_planet_mu, arrival_planet_mu,
+                           departure_orbit_radius, arrival_orbit_radius,
+                           shifted.data(), static_cast<int>(shifted.size()), prune ? &pruning : nullptr,
+                           precision, backend);
+#endif
+
+    rows_completed += rows;
+
+    if (on_rows)
+        on_rows(row_begin, rows_completed);
+
+    return rows;
+}
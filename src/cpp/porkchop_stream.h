@@ -0,0 +1,77 @@
+#ifndef LAMBERT_PORKCHOP_STREAM_H
+#define LAMBERT_PORKCHOP_STREAM_H
+
+#include <atomic>
+#include <functional>
+#include <vector>
+#include "porkchop_metrics.h"
+
+// Incremental porkchop sweep. Each step() solves the next batch of departure rows, so a caller can hand
+// finished rows to the UI between batches and stop early with cancel(). The ephemeris arrays are borrowed and
+// must outlive the job. Rows are solved exactly as computePorkchopPlot_SIMD solves them, in both builds: the
+// pthreads build spreads each batch over the pool through computePorkchopMetricsParallel, which runs the same
+// batch kernel.
+class PorkchopJob
+{
+public:
+    // Called after every batch with the half-open range of rows it finished.
+    using RowCallback = std::function<void(int row_begin, int row_end)>;
+
+    PorkchopJob(double mu, const double *r1, const double *v1, const double *r2, const double *v2,
+                const double *d1, const double *d2, int num_departure_dates, int num_arrival_dates,
+                double departure_planet_mu, double arrival_planet_mu,
+                double departure_orbit_radius, double arrival_orbit_radius,
+                double *result_c3 = nullptr, double *result_dv1 = nullptr, double *result_total_dv = nullptr);
+
+    // Solves up to max_rows more rows into the result grids given to the constructor. Returns the number of
+    // rows solved, 0 once the job is done or cancelled.
+    int step(int max_rows);
+
+    // Makes step() fill the given metric grids (full size, borrowed) instead of the three double grids.
+    void setMetricOutputs(const MetricOutput *outputs, int num_outputs);
+
+    // Prunes the metric sweep (see PorkchopPruning); the stats pointer is dropped.
+    void setPruning(const PorkchopPruning &options) { pruning = options; pruning.stats = nullptr; prune = true; }
+
+    // Kernel arithmetic of the metric sweep (see SolverPrecision).
+    void setPrecision(SolverPrecision value) { precision = value; }
+
+    // Zero-revolution solver of the metric sweep (see computePorkchopMetrics).
+    void setBackend(LambertBackend value) { backend = value; }
+
+    // Same, but writes the batch to the start of the given buffers (max_rows * num_arrival_dates each), for
+    // callers that keep the grid in another format.
+    int stepInto(int max_rows, double *c3, double *dv1, double *total_dv);
+
+    // Safe to call from another thread; takes effect before the next batch.
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+    bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+    bool isDone() const { return rows_completed >= num_departure_dates; }
+    int rowsCompleted() const { return rows_completed; }
+    int numRows() const { return num_departure_dates; }
+
+    void setRowCallback(RowCallback callback) { on_rows = std::move(callback); }
+
+private:
+    int stepMetrics(int max_rows);
+
+    double mu;
+    const double *r1, *v1, *r2, *v2, *d1, *d2;
+    int num_departure_dates;
+    int num_arrival_dates;
+    double departure_planet_mu, arrival_planet_mu;
+    double departure_orbit_radius, arrival_orbit_radius;
+    double *result_c3, *result_dv1, *result_total_dv;
+    std::vector<MetricOutput> metric_outputs;
+    PorkchopPruning pruning;
+    bool prune = false;
+    SolverPrecision precision = PRECISION_DOUBLE;
+    LambertBackend backend = LAMBERT_BATTIN;
+
+    int rows_completed = 0;
+    std::atomic<bool> cancelled{false};
+    RowCallback on_rows;
+};
+
+#endif //LAMBERT_PORKCHOP_STREAM_H
@@ -0,0 +1,320 @@
+#ifndef LAMBERT_SIMD_LANES_H
+#define LAMBERT_SIMD_LANES_H
+
+#include <cmath>
+
+// Minimal double-precision lane abstraction for the batched solver.
+// The instruction set is fixed at compile time: AVX-512 (8 lanes), AVX2 (4 lanes),
+// WASM SIMD128 (2 lanes) or plain scalar code (1 lane).
+// LaneF is the single-precision counterpart with twice the lanes (one lane on scalar builds). laneLoadF and
+// laneStoreF narrow from and widen to doubles, so float kernels share the double kernels' arrays.
+
+#if defined(__AVX512F__)
+
+#include <immintrin.h>
+
+#define LAMBERT_SIMD_NAME "avx512"
+
+constexpr int LANES = 8;
+
+struct LaneD
+{
+    __m512d v;
+};
+
+typedef __mmask8 LaneMask;
+
+inline LaneD laneSet(double a) { return {_mm512_set1_pd(a)}; }
+inline LaneD laneLoad(const double *p) { return {_mm512_loadu_pd(p)}; }
+inline void laneStore(double *p, LaneD a) { _mm512_storeu_pd(p, a.v); }
+
+inline LaneD operator+(LaneD a, LaneD b) { return {_mm512_add_pd(a.v, b.v)}; }
+inline LaneD operator-(LaneD a, LaneD b) { return {_mm512_sub_pd(a.v, b.v)}; }
+inline LaneD operator*(LaneD a, LaneD b) { return {_mm512_mul_pd(a.v, b.v)}; }
+inline LaneD operator/(LaneD a, LaneD b) { return {_mm512_div_pd(a.v, b.v)}; }
+inline LaneD laneSqrt(LaneD a) { return {_mm512_sqrt_pd(a.v)}; }
+inline LaneD laneAbs(LaneD a) { return {_mm512_abs_pd(a.v)}; }
+
+inline LaneMask laneGt(LaneD a, LaneD b) { return _mm512_cmp_pd_mask(a.v, b.v, _CMP_GT_OQ); }
+inline LaneMask laneLe(LaneD a, LaneD b) { return _mm512_cmp_pd_mask(a.v, b.v, _CMP_LE_OQ); }
+inline LaneMask maskNone() { return 0; }
+inline LaneMask maskAnd(LaneMask a, LaneMask b) { return a & b; }
+inline LaneMask maskOr(LaneMask a, LaneMask b) { return a | b; }
+inline LaneMask maskNot(LaneMask a) { return static_cast<LaneMask>(~a); }
+inline bool maskAny(LaneMask a) { return a != 0; }
+inline bool maskAll(LaneMask a) { return a == 0xFF; }
+
+// mask ? a : b
+inline LaneD laneSelect(LaneMask mask, LaneD a, LaneD b) { return {_mm512_mask_blend_pd(mask, b.v, a.v)}; }
+
+constexpr int LANES_F = 16;
+
+struct LaneF
+{
+    __m512 v;
+};
+
+typedef __mmask16 LaneMaskF;
+
+inline LaneF laneSetF(float a) { return {_mm512_set1_ps(a)}; }
+
+inline LaneF laneLoadF(const double *p)
+{
+    __m256 lo = _mm512_cvtpd_ps(_mm512_loadu_pd(p));
+    __m256 hi = _mm512_cvtpd_ps(_mm512_loadu_pd(p + 8));
+    return {_mm512_castpd_ps(_mm512_insertf64x4(_mm512_castps_pd(_mm512_castps256_ps512(lo)),
+                                                _mm256_castps_pd(hi), 1))};
+}
+
+inline void laneStoreF(double *p, LaneF a)
+{
+    _mm512_storeu_pd(p, _mm512_cvtps_pd(_mm512_castps512_ps256(a.v)));
+    _mm512_storeu_pd(p + 8, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(a.v), 1))));
+}
+
+inline LaneF operator+(LaneF a, LaneF b) { return {_mm512_add_ps(a.v, b.v)}; }
+inline LaneF operator-(LaneF a, LaneF b) { return {_mm512_sub_ps(a.v, b.v)}; }
+inline LaneF operator*(LaneF a, LaneF b) { return {_mm512_mul_ps(a.v, b.v)}; }
+inline LaneF operator/(LaneF a, LaneF b) { return {_mm512_div_ps(a.v, b.v)}; }
+inline LaneF laneSqrtF(LaneF a) { return {_mm512_sqrt_ps(a.v)}; }
+inline LaneF laneAbsF(LaneF a) { return {_mm512_abs_ps(a.v)}; }
+
+inline LaneMaskF laneGtF(LaneF a, LaneF b) { return _mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ); }
+inline LaneMaskF laneLeF(LaneF a, LaneF b) { return _mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ); }
+inline LaneMaskF maskNoneF() { return 0; }
+inline LaneMaskF maskAndF(LaneMaskF a, LaneMaskF b) { return a & b; }
+inline LaneMaskF maskOrF(LaneMaskF a, LaneMaskF b) { return a | b; }
+inline LaneMaskF maskNotF(LaneMaskF a) { return static_cast<LaneMaskF>(~a); }
+inline bool maskAnyF(LaneMaskF a) { return a != 0; }
+inline bool maskAllF(LaneMaskF a) { return a == 0xFFFF; }
+
+inline LaneF laneSelectF(LaneMaskF mask, LaneF a, LaneF b) { return {_mm512_mask_blend_ps(mask, b.v, a.v)}; }
+
+#elif defined(__AVX2__)
+
+#include <immintrin.h>
+
+#define LAMBERT_SIMD_NAME "avx2"
+
+constexpr int LANES = 4;
+
+struct LaneD
+{
+    __m256d v;
+};
+
+typedef __m256d LaneMask;
+
+inline LaneD laneSet(double a) { return {_mm256_set1_pd(a)}; }
+inline LaneD laneLoad(const double *p) { return {_mm256_loadu_pd(p)}; }
+inline void laneStore(double *p, LaneD a) { _mm256_storeu_pd(p, a.v); }
+
+inline LaneD operator+(LaneD a, LaneD b) { return {_mm256_add_pd(a.v, b.v)}; }
+inline LaneD operator-(LaneD a, LaneD b) { return {_mm256_sub_pd(a.v, b.v)}; }
+inline LaneD operator*(LaneD a, LaneD b) { return {_mm256_mul_pd(a.v, b.v)}; }
+inline LaneD operator/(LaneD a, LaneD b) { return {_mm256_div_pd(a.v, b.v)}; }
+inline LaneD laneSqrt(LaneD a) { return {_mm256_sqrt_pd(a.v)}; }
+inline LaneD laneAbs(LaneD a) { return {_mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v)}; }
+
+inline LaneMask laneGt(LaneD a, LaneD b) { return _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ); }
+inline LaneMask laneLe(LaneD a, LaneD b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ); }
+inline LaneMask maskNone() { return _mm256_setzero_pd(); }
+inline LaneMask maskAnd(LaneMask a, LaneMask b) { return _mm256_and_pd(a, b); }
+inline LaneMask maskOr(LaneMask a, LaneMask b) { return _mm256_or_pd(a, b); }
+inline LaneMask maskNot(LaneMask a) { return _mm256_xor_pd(a, _mm256_castsi256_pd(_mm256_set1_epi64x(-1))); }
+inline bool maskAny(LaneMask a) { return _mm256_movemask_pd(a) != 0; }
+inline bool maskAll(LaneMask a) { return _mm256_movemask_pd(a) == 0xF; }
+
+// mask ? a : b
+inline LaneD laneSelect(LaneMask mask, LaneD a, LaneD b) { return {_mm256_blendv_pd(b.v, a.v, mask)}; }
+
+constexpr int LANES_F = 8;
+
+struct LaneF
+{
+    __m256 v;
+};
+
+typedef __m256 LaneMaskF;
+
+inline LaneF laneSetF(float a) { return {_mm256_set1_ps(a)}; }
+
+inline LaneF laneLoadF(const double *p)
+{
+    return {_mm256_set_m128(_mm256_cvtpd_ps(_mm256_loadu_pd(p + 4)), _mm256_cvtpd_ps(_mm256_loadu_pd(p)))};
+}
+
+inline void laneStoreF(double *p, LaneF a)
+{
+    _mm256_storeu_pd(p, _mm256_cvtps_pd(_mm256_castps256_ps128(a.v)));
+    _mm256_storeu_pd(p + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(a.v, 1)));
+}
+
+inline LaneF operator+(LaneF a, LaneF b) { return {_mm256_add_ps(a.v, b.v)}; }
+inline LaneF operator-(LaneF a, LaneF b) { return {_mm256_sub_ps(a.v, b.v)}; }
+inline LaneF operator*(LaneF a, LaneF b) { return {_mm256_mul_ps(a.v, b.v)}; }
+inline LaneF operator/(LaneF a, LaneF b) { return {_mm256_div_ps(a.v, b.v)}; }
+inline LaneF laneSqrtF(LaneF a) { return {_mm256_sqrt_ps(a.v)}; }
+inline LaneF laneAbsF(LaneF a) { return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)}; }
+
+inline LaneMaskF laneGtF(LaneF a, LaneF b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+inline LaneMaskF laneLeF(LaneF a, LaneF b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+inline LaneMaskF maskNoneF() { return _mm256_setzero_ps(); }
+inline LaneMaskF maskAndF(LaneMaskF a, LaneMaskF b) { return _mm256_and_ps(a, b); }
+inline LaneMaskF maskOrF(LaneMaskF a, LaneMaskF b) { return _mm256_or_ps(a, b); }
+inline LaneMaskF maskNotF(LaneMaskF a) { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+inline bool maskAnyF(LaneMaskF a) { return _mm256_movemask_ps(a) != 0; }
+inline bool maskAllF(LaneMaskF a) { return _mm256_movemask_ps(a) == 0xFF; }
+
+inline LaneF laneSelectF(LaneMaskF mask, LaneF a, LaneF b) { return {_mm256_blendv_ps(b.v, a.v, mask)}; }
+
+#elif defined(__wasm_simd128__)
+
+#include <wasm_simd128.h>
+
+#define LAMBERT_SIMD_NAME "wasm-simd128"
+
+constexpr int LANES = 2;
+
+struct LaneD
+{
+    v128_t v;
+};
+
+typedef v128_t LaneMask;
+
+inline LaneD laneSet(double a) { return {wasm_f64x2_splat(a)}; }
+inline LaneD laneLoad(const double *p) { return {wasm_v128_load(p)}; }
+inline void laneStore(double *p, LaneD a) { wasm_v128_store(p, a.v); }
+
+inline LaneD operator+(LaneD a, LaneD b) { return {wasm_f64x2_add(a.v, b.v)}; }
+inline LaneD operator-(LaneD a, LaneD b) { return {wasm_f64x2_sub(a.v, b.v)}; }
+inline LaneD operator*(LaneD a, LaneD b) { return {wasm_f64x2_mul(a.v, b.v)}; }
+inline LaneD operator/(LaneD a, LaneD b) { return {wasm_f64x2_div(a.v, b.v)}; }
+inline LaneD laneSqrt(LaneD a) { return {wasm_f64x2_sqrt(a.v)}; }
+inline LaneD laneAbs(LaneD a) { return {wasm_f64x2_abs(a.v)}; }
+
+inline LaneMask laneGt(LaneD a, LaneD b) { return wasm_f64x2_gt(a.v, b.v); }
+inline LaneMask laneLe(LaneD a, LaneD b) { return wasm_f64x2_le(a.v, b.v); }
+inline LaneMask maskNone() { return wasm_i64x2_splat(0); }
+inline LaneMask maskAnd(LaneMask a, LaneMask b) { return wasm_v128_and(a, b); }
+inline LaneMask maskOr(LaneMask a, LaneMask b) { return wasm_v128_or(a, b); }
+inline LaneMask maskNot(LaneMask a) { return wasm_v128_not(a); }
+inline bool maskAny(LaneMask a) { return wasm_v128_any_true(a); }
+inline bool maskAll(LaneMask a) { return wasm_i64x2_all_true(a); }
+
+// mask ? a : b
+inline LaneD laneSelect(LaneMask mask, LaneD a, LaneD b) { return {wasm_v128_bitselect(a.v, b.v, mask)}; }
+
+constexpr int LANES_F = 4;
+
+struct LaneF
+{
+    v128_t v;
+};
+
+typedef v128_t LaneMaskF;
+
+inline LaneF laneSetF(float a) { return {wasm_f32x4_splat(a)}; }
+
+inline LaneF laneLoadF(const double *p)
+{
+    v128_t lo = wasm_f32x4_demote_f64x2_zero(wasm_v128_load(p));
+    v128_t hi = wasm_f32x4_demote_f64x2_zero(wasm_v128_load(p + 2));
+    return {wasm_i32x4_shuffle(lo, hi, 0, 1, 4, 5)};
+}
+
+inline void laneStoreF(double *p, LaneF a)
+{
+    wasm_v128_store(p, wasm_f64x2_promote_low_f32x4(a.v));
+    wasm_v128_store(p + 2, wasm_f64x2_promote_low_f32x4(wasm_i32x4_shuffle(a.v, a.v, 2, 3, 0, 1)));
+}
+
+inline LaneF operator+(LaneF a, LaneF b) { return {wasm_f32x4_add(a.v, b.v)}; }
+inline LaneF operator-(LaneF a, LaneF b) { return {wasm_f32x4_sub(a.v, b.v)}; }
+inline LaneF operator*(LaneF a, LaneF b) { return {wasm_f32x4_mul(a.v, b.v)}; }
+inline LaneF operator/(LaneF a, LaneF b) { return {wasm_f32x4_div(a.v, b.v)}; }
+inline LaneF laneSqrtF(LaneF a) { return {wasm_f32x4_sqrt(a.v)}; }
+inline LaneF laneAbsF(LaneF a) { return {wasm_f32x4_abs(a.v)}; }
+
+inline LaneMaskF laneGtF(LaneF a, LaneF b) { return wasm_f32x4_gt(a.v, b.v); }
+inline LaneMaskF laneLeF(LaneF a, LaneF b) { return wasm_f32x4_le(a.v, b.v); }
+inline LaneMaskF maskNoneF() { return wasm_i32x4_splat(0); }
+inline LaneMaskF maskAndF(LaneMaskF a, LaneMaskF b) { return wasm_v128_and(a, b); }
+inline LaneMaskF maskOrF(LaneMaskF a, LaneMaskF b) { return wasm_v128_or(a, b); }
+inline LaneMaskF maskNotF(LaneMaskF a) { return wasm_v128_not(a); }
+inline bool maskAnyF(LaneMaskF a) { return wasm_v128_any_true(a); }
+inline bool maskAllF(LaneMaskF a) { return wasm_i32x4_all_true(a); }
+
+inline LaneF laneSelectF(LaneMaskF mask, LaneF a, LaneF b) { return {wasm_v128_bitselect(a.v, b.v, mask)}; }
+
+#else
+
+#define LAMBERT_SIMD_NAME "scalar"
+
+constexpr int LANES = 1;
+
+struct LaneD
+{
+    double v;
+};
+
+typedef bool LaneMask;
+
+inline LaneD laneSet(double a) { return {a}; }
+inline LaneD laneLoad(const double *p) { return {*p}; }
+inline void laneStore(double *p, LaneD a) { *p = a.v; }
+
+inline LaneD operator+(LaneD a, LaneD b) { return {a.v + b.v}; }
+inline LaneD operator-(LaneD a, LaneD b) { return {a.v - b.v}; }
+inline LaneD operator*(LaneD a, LaneD b) { return {a.v * b.v}; }
+inline LaneD operator/(LaneD a, LaneD b) { return {a.v / b.v}; }
+inline LaneD laneSqrt(LaneD a) { return {std::sqrt(a.v)}; }
+inline LaneD laneAbs(LaneD a) { return {std::abs(a.v)}; }
+
+inline LaneMask laneGt(LaneD a, LaneD b) { return a.v > b.v; }
+inline LaneMask laneLe(LaneD a, LaneD b) { return a.v <= b.v; }
+inline LaneMask maskNone() { return false; }
+inline LaneMask maskAnd(LaneMask a, LaneMask b) { return a && b; }
+inline LaneMask maskOr(LaneMask a, LaneMask b) { return a || b; }
+inline LaneMask maskNot(LaneMask a) { return !a; }
+inline bool maskAny(LaneMask a) { return a; }
+inline bool maskAll(LaneMask a) { return a; }
+
+// mask ? a : b
+inline LaneD laneSelect(LaneMask mask, LaneD a, LaneD b) { return mask ? a : b; }
+
+constexpr int LANES_F = 1;
+
+struct LaneF
+{
+    float v;
+};
+
+typedef bool LaneMaskF;
+
+inline LaneF laneSetF(float a) { return {a}; }
+inline LaneF laneLoadF(const double *p) { return {static_cast<float>(*p)}; }
+inline void laneStoreF(double *p, LaneF a) { *p = a.v; }
+
+inline LaneF operator+(LaneF a, LaneF b) { return {a.v + b.v}; }
+inline LaneF operator-(LaneF a, LaneF b) { return {a.v - b.v}; }
+inline LaneF operator*(LaneF a, LaneF b) { return {a.v * b.v}; }
+inline LaneF operator/(LaneF a, LaneF b) { return {a.v / b.v}; }
+inline LaneF laneSqrtF(LaneF a) { return {std::sqrt(a.v)}; }
+inline LaneF laneAbsF(LaneF a) { return {std::abs(a.v)}; }
+
+inline LaneMaskF laneGtF(LaneF a, LaneF b) { return a.v > b.v; }
+inline LaneMaskF laneLeF(LaneF a, LaneF b) { return a.v <= b.v; }
+inline LaneMaskF maskNoneF() { return false; }
+inline LaneMaskF maskAndF(LaneMaskF a, LaneMaskF b) { return a && b; }
+inline LaneMaskF maskOrF(LaneMaskF a, LaneMaskF b) { return a || b; }
+inline LaneMaskF maskNotF(LaneMaskF a) { return !a; }
+inline bool maskAnyF(LaneMaskF a) { return a; }
+inline bool maskAllF(LaneMaskF a) { return a; }
+
+inline LaneF laneSelectF(LaneMaskF mask, LaneF a, LaneF b) { return mask ? a : b; }
+
+#endif
+
+#endif //LAMBERT_SIMD_LANES_H
@@ -0,0 +1,63 @@
+#ifndef LAMBERT_TILE_SCHEDULER_H
+#define LAMBERT_TILE_SCHEDULER_H
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Per-worker tile queues. A worker pops from the front of its own queue and,
+// once that runs dry, steals from the back of the other workers' queues.
+class TileScheduler
+{
+public:
+    TileScheduler(int num_tiles, int num_workers) : queues(num_workers)
+    {
+        for (auto &queue: queues)
+            queue = std::make_unique<Queue>();
+
+        // round-robin so every worker starts with tiles from the whole grid
+        for (int tile = 0; tile < num_tiles; ++tile)
+            queues[tile % num_workers]->tiles.push_back(tile);
+    }
+
+    bool next(int worker, int &tile)
+    {
+        {
+            Queue &own = *queues[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tiles.empty())
+            {
+                tile = own.tiles.front();
+                own.tiles.pop_front();
+                return true;
+            }
+        }
+
+        int num_workers = static_cast<int>(queues.size());
+        for (int k = 1; k < num_workers; ++k)
+        {
+            Queue &victim = *queues[(worker + k) % num_workers];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tiles.empty())
+            {
+                tile = victim.tiles.back();
+                victim.tiles.pop_back();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<int> tiles;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+};
+
+#endif //LAMBERT_TILE_SCHEDULER_H